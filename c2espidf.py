@@ -1,50 +1,577 @@
+import json
+import math
 import os
+import re
 import shutil
 import time
-from typing import Optional
+from typing import List, Optional
 
 import jinja2
 from hvcc.types.compiler import CompilerResp, ExternInfo, Generator
 from hvcc.types.meta import Meta
 
-def render_templates(project_name: str, out_dir: str, heavy_header: str, hv_new_fn: str,
-                     ws_pin: int = 26, bclk_pin: int = 27, dout_pin: int = 25, sample_rate: int = 48000) -> None:
+def load_config() -> dict:
+    # Optional generator settings, read from $C2ESPIDF_CONFIG or ./c2espidf.json
+    path = os.environ.get('C2ESPIDF_CONFIG', 'c2espidf.json')
+    if not os.path.isfile(path):
+        return {}
+    with open(path, 'r') as f:
+        return json.load(f)
+
+
+def resource_dir(name: str) -> str:
     base_dir = os.path.dirname(os.path.abspath(__file__))
-    templates_dir = os.path.join(base_dir, 'c2espidf', 'templates')
-    if not os.path.isdir(templates_dir):
-        # fallback to sibling templates if running as a package module
-        templates_dir = os.path.join(os.path.dirname(base_dir), 'c2espidf', 'templates')
+    path = os.path.join(base_dir, 'c2espidf', name)
+    if not os.path.isdir(path):
+        # fallback to sibling resources if running as a package module
+        path = os.path.join(os.path.dirname(base_dir), 'c2espidf', name)
+    return path
+
 
-    env = jinja2.Environment(
-        loader=jinja2.FileSystemLoader(templates_dir),
+def template_env() -> jinja2.Environment:
+    return jinja2.Environment(
+        loader=jinja2.FileSystemLoader(resource_dir('templates')),
         trim_blocks=True,
         lstrip_blocks=True,
     )
 
+
+def hv_string_to_hash(s: str) -> int:
+    # Python port of hv_string_to_hash() in HvUtils.c (MurmurHash2, seed 0)
+    n = 0x5bd1e995
+    data = s.encode('utf-8')
+    length = len(data)
+    x = length
+    i = 0
+    while length >= 4:
+        k = int.from_bytes(data[i:i + 4], 'little')
+        k = (k * n) & 0xFFFFFFFF
+        k ^= k >> 24
+        k = (k * n) & 0xFFFFFFFF
+        x = (x * n) & 0xFFFFFFFF
+        x ^= k
+        i += 4
+        length -= 4
+    # the tail is read through char, which is signed on the ESP32 and the host, so
+    # bytes above 0x7F are sign-extended; host/hvhash.c checks these against C
+    tail = [b - 256 if b > 127 else b for b in data[i:]]
+    if length == 3:
+        x ^= (tail[2] << 16) & 0xFFFFFFFF
+    if length >= 2:
+        x ^= (tail[1] << 8) & 0xFFFFFFFF
+    if length >= 1:
+        x ^= tail[0] & 0xFFFFFFFF
+        x = (x * n) & 0xFFFFFFFF
+    x ^= x >> 13
+    x = (x * n) & 0xFFFFFFFF
+    x ^= x >> 15
+    return x
+
+
+def overlay_runtime(hvcc_c_dir: str) -> None:
+    # Replace HVCC runtime sources with the ESP32-tuned versions kept in c2espidf/static.
+    # A source is only added if its header ships with it or was emitted by HVCC,
+    # so that objects the patch does not use are left out.
+    static_dir = resource_dir('static')
+    if not os.path.isdir(static_dir):
+        return
+    for name in sorted(os.listdir(static_dir)):
+        src = os.path.join(static_dir, name)
+        if not os.path.isfile(src):
+            continue
+        base, ext = os.path.splitext(name)
+        if ext in ('.c', '.cpp'):
+            headers = [base + '.h'] + ([base + '.hpp'] if ext == '.cpp' else [])
+            if not any(os.path.exists(os.path.join(d, h))
+                       for d in (static_dir, hvcc_c_dir) for h in headers):
+                continue
+        shutil.copy2(src, os.path.join(hvcc_c_dir, name))
+
+
+# string literals that become symbol elements or are compared against them
+SYMBOL_LITERAL_RE = re.compile(
+    r'\b(?:msg_setSymbol|msg_initWithSymbol|msg_compareSymbol|cVar_init_s)\s*\([^;"]*"((?:[^"\\]|\\.)*)"')
+
+
+def collect_symbols(hvcc_c_dir: str) -> List[str]:
+    symbols = set()
+    for name in sorted(os.listdir(hvcc_c_dir)):
+        if name.endswith(('.c', '.cpp')):
+            with open(os.path.join(hvcc_c_dir, name), 'r') as f:
+                symbols.update(SYMBOL_LITERAL_RE.findall(f.read()))
+    return sorted(symbols)
+
+
+# calls with a symbol literal last, and their counterparts taking an interned symbol
+SYMBOL_CALL_RE = re.compile(
+    r'\b(msg_setSymbol|msg_initWithSymbol|msg_compareSymbol)(\s*\([^;"]*)"((?:[^"\\]|\\.)*)"(\s*\))')
+INTERNED_CALLS = {
+    'msg_setSymbol': 'msg_setInternedSymbol',
+    'msg_initWithSymbol': 'msg_initWithInternedSymbol',
+    'msg_compareSymbol': 'msg_compareInternedSymbol',
+}
+
+
+def render_static_symbols(hvcc_c_dir: str) -> None:
+    # Intern every symbol literal at generation time; the table is sorted by hash for binary search
+    symbols = sorted(((hv_string_to_hash(s), s) for s in collect_symbols(hvcc_c_dir)))
+    source = template_env().get_template('HvStaticSymbols.c.j2').render(symbols=symbols)
+    with open(os.path.join(hvcc_c_dir, 'HvStaticSymbols.c'), 'w') as f:
+        f.write(source)
+
+    # Point the literals at their table entries, so that the audio thread never
+    # hashes or looks up a string it knew at generation time
+    index = {s: i for i, (_, s) in enumerate(symbols)}
+    def interned(m: re.Match) -> str:
+        return f'{INTERNED_CALLS[m.group(1)]}{m.group(2)}&hv_staticSymbols[{index[m.group(3)]}] /* "{m.group(3)}" */{m.group(4)}'
+    for name in sorted(os.listdir(hvcc_c_dir)):
+        if not name.endswith(('.c', '.cpp')):
+            continue
+        path = os.path.join(hvcc_c_dir, name)
+        with open(path, 'r') as f:
+            text = f.read()
+        rewritten = SYMBOL_CALL_RE.sub(interned, text)
+        if rewritten != text:
+            with open(path, 'w') as f:
+                f.write(rewritten)
+
+
+def load_ir(c_src_dir: str) -> Optional[dict]:
+    # HVCC writes the IR next to its C output: <out>/ir/<name>.heavy.ir.json
+    ir_dir = os.path.join(os.path.dirname(os.path.normpath(c_src_dir)), 'ir')
+    if not os.path.isdir(ir_dir):
+        return None
+    for name in sorted(os.listdir(ir_dir)):
+        if name.endswith('.heavy.ir.json'):
+            with open(os.path.join(ir_dir, name), 'r') as f:
+                return json.load(f)
+    return None
+
+
+def hash_identifier(prefix: str, name: str) -> str:
+    return f"{prefix}_{re.sub(r'[^A-Za-z0-9]', '_', name).strip('_').upper()}"
+
+
+def named_hashes(pairs: list, prefix: str) -> List[tuple]:
+    # (identifier, hash, name) sorted by identifier, dropping anonymous entries
+    entries = {}
+    for name, h in pairs:
+        if not name or h is None:
+            continue
+        ident = hash_identifier(prefix, name)
+        value = int(h, 16) if isinstance(h, str) else int(h)
+        if entries.setdefault(ident, (value, name))[0] != value:
+            raise RuntimeError(f"c2espidf: '{name}' and '{entries[ident][1]}' both map to {ident}")
+    return [(i, v, n) for i, (v, n) in sorted(entries.items())]
+
+
+def receiver_entries(ir: dict, base: str) -> List[tuple]:
+    # Receivers in index order: (identifier, hash, name, receive object ids)
+    receivers = ir.get('control', {}).get('receivers', {})
+    pairs = [(n, r.get('hash')) for n, r in receivers.items()]
+    return [(i, v, n, receivers[n].get('ids', [])) for i, v, n in named_hashes(pairs, f"HV_{base.upper()}_RECEIVER")]
+
+
+# one case of the getParameterInfo() switch emitted by HVCC for an input parameter
+PARAMETER_IN_RE = re.compile(
+    r'case (\d+): \{\s*info->name = "((?:[^"\\]|\\.)*)";\s*info->hash = (0x[0-9A-Fa-f]+);\s*'
+    r'info->type = HvParameterType::HV_PARAM_TYPE_PARAMETER_IN;')
+
+
+def parameter_in_entries(hvcc_c_dir: str, base: str) -> List[tuple]:
+    # Input parameters as (identifier, getParameterInfo index, name)
+    cpp = os.path.join(hvcc_c_dir, f'Heavy_{base}.cpp')
+    if not os.path.exists(cpp):
+        return []
+    with open(cpp, 'r') as f:
+        found = PARAMETER_IN_RE.findall(f.read())
+    return [(hash_identifier(f"HV_{base.upper()}_PARAM_INDEX", name), int(index), name)
+            for index, name, _ in sorted(found, key=lambda e: int(e[0]))]
+
+
+def send_entries(ir: dict, base: str) -> List[tuple]:
+    # Sends as (identifier, hash, name), sorted by identifier
+    sends = ir.get('control', {}).get('sendMessage', [])
+    return named_hashes([(s.get('name'), s.get('hash')) for s in sends], f"HV_{base.upper()}_SEND")
+
+
+def hash_constant_groups(ir: dict, base: str, parameters: List[tuple]) -> List[tuple]:
+    control = ir.get('control', {})
+    receivers = receiver_entries(ir, base)
+    groups = [
+        ('Receiver', 'Receiver hashes', [(i, f'0x{v:08X}', n) for i, v, n, _ in receivers]),
+        ('ReceiverIndex', 'Receiver indices', [(i.replace('_RECEIVER_', '_RECEIVER_INDEX_', 1), str(k), n)
+                           for k, (i, _, n, _) in enumerate(receivers)]),
+        ('ParameterIndex', 'Input parameter indices', [(i, str(k), n) for i, k, n in parameters]),
+        ('Send', 'Send hashes', [(i, f'0x{v:08X}', n) for i, v, n in send_entries(ir, base)]),
+        ('Table', 'Table hashes', [(i, f'0x{v:08X}', n) for i, v, n in named_hashes(
+            [(n, t.get('hash')) for n, t in ir.get('tables', {}).items()], f"HV_{base.upper()}_TABLE")]),
+    ]
+    return [g for g in groups if g[2]]
+
+
+def render_hash_constants(hvcc_c_dir: str, heavy_header: str, ir: Optional[dict]) -> None:
+    # Emit receiver/send/table hashes into the patch header so that callers can
+    # use named constants instead of hashing strings at runtime.
+    header_path = os.path.join(hvcc_c_dir, heavy_header)
+    if ir is None or not os.path.exists(header_path):
+        return
+    base = heavy_header[len('Heavy_'):-len('.h')]
+    groups = hash_constant_groups(ir, base, parameter_in_entries(hvcc_c_dir, base))
+    if not groups:
+        return
+    with open(header_path, 'r') as f:
+        s = f.read()
+    anchor = '\n/**\n * Creates a new patch instance.'
+    if anchor not in s:
+        print(f"c2espidf: warning: no insertion point in {heavy_header}, hash constants not emitted")
+        return
+    block = template_env().get_template('Heavy_hashes.h.j2').render(groups=groups, base=base)
+    s = s.replace(anchor, '\n' + block.rstrip('\n') + '\n' + anchor, 1)
+    with open(header_path, 'w') as f:
+        f.write(s)
+
+
+# the per-block input queue drain emitted by HVCC in process()
+INPUT_QUEUE_DRAIN_RE = re.compile(
+    r'  while \(hLp_hasData\(&inQueue\)\) \{\n.*?scheduleMessageForReceiver\(p->receiverHash, &p->msg\);\n'
+    r'\s*hLp_consume\(&inQueue\);\n  \}\n', re.S)
+
+
+def patch_file(path: str, edits: List[tuple]) -> bool:
+    # Apply (old, new) replacements, leaving the file untouched unless all anchors are found
+    with open(path, 'r') as f:
+        s = f.read()
+    for old, new in edits:
+        if isinstance(old, re.Pattern):
+            s, n = old.subn(lambda _: new, s, count=1)
+        else:
+            n = s.count(old)
+            s = s.replace(old, new, 1)
+        if n == 0:
+            return False
+    with open(path, 'w') as f:
+        f.write(s)
+    return True
+
+
+def render_receiver_table(hvcc_c_dir: str, heavy_header: str, ir: Optional[dict]) -> None:
+    # Give every receiver a dense index and a table of its receive objects, so that
+    # hv_send*ToReceiverIndex() dispatches without searching the hash switch.
+    base = heavy_header[len('Heavy_'):-len('.h')]
+    cls = f'Heavy_{base}'
+    hpp = os.path.join(hvcc_c_dir, f'{cls}.hpp')
+    cpp = os.path.join(hvcc_c_dir, f'{cls}.cpp')
+    if not (os.path.exists(hpp) and os.path.exists(cpp)):
+        return
+    receivers = receiver_entries(ir, base) if ir is not None else []
+    env = template_env()
+    cpp_edits = [(INPUT_QUEUE_DRAIN_RE, '  processInputQueue();\n')]
+    if receivers:
+        offsets = [0]
+        for r in receivers:
+            offsets.append(offsets[-1] + len(r[3]))
+        hash_order = sorted(range(len(receivers)), key=lambda k: receivers[k][1])
+        table = env.get_template('Heavy_receivers.cpp.j2').render(
+            cls=cls, prefix=f"HV_{base.upper()}", receivers=receivers, offsets=offsets, hash_order=hash_order)
+        cpp_edits += [
+            (f'    : HeavyContext(sampleRate, poolKb, inQueueKb, outQueueKb) {{\n',
+             f'    : HeavyContext(sampleRate, poolKb, inQueueKb, outQueueKb) {{\n'
+             f'  initReceiverTable(&receiverIndexTable);\n'
+             f'  initParameterBank();\n'),
+            (f'int {cls}::getParameterInfo(', table + f'int {cls}::getParameterInfo('),
+        ]
+        hpp_edits = [(
+            '  void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override;\n',
+            '  void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override;\n'
+            '  static HvReceiverTarget_t *const receiverIndexTargets[];\n'
+            '  static const HvReceiverTable receiverIndexTable;\n')]
+        if not patch_file(hpp, hpp_edits):
+            print(f"c2espidf: warning: unexpected layout in {cls}.hpp, receiver index table not emitted")
+            cpp_edits = cpp_edits[:1]
+    if not patch_file(cpp, cpp_edits):
+        raise RuntimeError(f"c2espidf: unexpected layout in {cls}.cpp, cannot install the receiver index table")
+
+
+def render_send_table(hvcc_c_dir: str, heavy_header: str, ir: Optional[dict]) -> None:
+    # Give the patch a table of its sends, so that hv_subscribeSend() can register
+    # callbacks and the send hook can drop messages nobody subscribed to.
+    base = heavy_header[len('Heavy_'):-len('.h')]
+    cls = f'Heavy_{base}'
+    hpp = os.path.join(hvcc_c_dir, f'{cls}.hpp')
+    cpp = os.path.join(hvcc_c_dir, f'{cls}.cpp')
+    sends = sorted(send_entries(ir, base), key=lambda e: e[1]) if ir is not None else []
+    if not sends or not (os.path.exists(hpp) and os.path.exists(cpp)):
+        return
+    table = template_env().get_template('Heavy_sends.cpp.j2').render(cls=cls, sends=sends)
+    cpp_edits = [
+        (f'    : HeavyContext(sampleRate, poolKb, inQueueKb, outQueueKb) {{\n',
+         f'    : HeavyContext(sampleRate, poolKb, inQueueKb, outQueueKb) {{\n'
+         f'  sendTable = &sendHashTable;\n'
+         f'  initSendSubscriptions();\n'),
+        (f'int {cls}::getParameterInfo(', table + f'int {cls}::getParameterInfo('),
+    ]
+    hpp_edits = [(
+        '  void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override;\n',
+        '  void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override;\n'
+        '  static const HvSendTable sendHashTable;\n')]
+    if not patch_file(hpp, hpp_edits) or not patch_file(cpp, cpp_edits):
+        print(f"c2espidf: warning: unexpected layout in {cls}, send table not emitted")
+
+
+def install_smoother(hvcc_c_dir: str, cls: str, name: str, receiver: dict, time_ms: float) -> bool:
+    # Swap the __var~f written by an @hv_param receiver for a SignalSmooth, which the
+    # receiver then feeds. Only the plain [r name @hv_param] -> [sig~] shape qualifies:
+    # one receive object whose sole action is the var write, and a single signal read.
+    hpp = os.path.join(hvcc_c_dir, f'{cls}.hpp')
+    cpp = os.path.join(hvcc_c_dir, f'{cls}.cpp')
+    ids = receiver.get('ids', [])
+    with open(cpp, 'r') as f:
+        c = f.read()
+    with open(hpp, 'r') as f:
+        h = f.read()
+    m = len(ids) == 1 and re.search(
+        rf'void {cls}::cReceive_{ids[0]}_sendMessage\(HeavyContextInterface \*_c, int letIn, const HvMessage \*m\) \{{\n'
+        r'  sVarf_onMessage\(_c, &Context\(_c\)->(sVarf_\w+), m\);\n\}', c)
+    if not m:
+        print(f"c2espidf: warning: '{name}' does not feed a sig~ directly, smoothing not applied")
+        return False
+    var = m.group(1)
+    init = re.search(rf'numBytes \+= sVarf_init\(&{var}, ([^,]+), 0\.0f, false\);', c)
+    if not (init and c.count(var) == 3 and c.count(f'__hv_varread_f(&{var}, ') == 1 and h.count(var) == 1):
+        print(f"c2espidf: warning: '{name}' signal is used in more than one place, smoothing not applied")
+        return False
+    smooth = var.replace('sVarf_', 'sSmooth_', 1)
+    cpp_edits = [
+        (init.group(0), f'numBytes += sSmooth_init(&{smooth}, {init.group(1)}, {float(time_ms)}f, sampleRate);'),
+        (f'sVarf_onMessage(_c, &Context(_c)->{var}, m);', f'sSmooth_onMessage(_c, &Context(_c)->{smooth}, m);'),
+        (f'__hv_varread_f(&{var}, ', f'__hv_smooth_f(&{smooth}, '),
+    ]
+    hpp_edits = [(f'SignalVarf {var};', f'SignalSmooth {smooth};')]
+    if '#include "HvSignalSmooth.h"' not in h:
+        hpp_edits.append(('#include "HeavyContext.hpp"\n', '#include "HeavyContext.hpp"\n#include "HvSignalSmooth.h"\n'))
+    # a partial swap would leave a SignalVarf read as a SignalSmooth, so every edit must apply or none
+    if not (all(c.count(old) == 1 for old, _ in cpp_edits) and all(h.count(old) == 1 for old, _ in hpp_edits)):
+        print(f"c2espidf: warning: unexpected layout in {cls}, smoothing of '{name}' not applied")
+        return False
+    if not (patch_file(cpp, cpp_edits) and patch_file(hpp, hpp_edits)):
+        raise RuntimeError(f"c2espidf: {cls} changed while smoothing '{name}'")
+    return True
+
+
+def render_smoothers(hvcc_c_dir: str, heavy_header: str, ir: Optional[dict], smoothing: dict) -> None:
+    # smoothing: {"<param receiver>": <time constant in ms>}
+    if not smoothing or ir is None:
+        return
+    base = heavy_header[len('Heavy_'):-len('.h')]
+    cls = f'Heavy_{base}'
+    receivers = ir.get('control', {}).get('receivers', {})
+    indices = {n: i for _, i, n in parameter_in_entries(hvcc_c_dir, base)}
+    for name, time_ms in sorted(smoothing.items()):
+        if name not in indices or name not in receivers:
+            print(f"c2espidf: warning: '{name}' is not an @hv_param receiver, smoothing not applied")
+            continue
+        install_smoother(hvcc_c_dir, cls, name, receivers[name], time_ms)
+
+
+def render_latest_wins(hvcc_c_dir: str, heavy_header: str, ir: Optional[dict], names: List[str]) -> None:
+    # latest_wins: ["<receiver>", ...] whose undelayed floats replace a still-pending one
+    if not names or ir is None:
+        return
+    base = heavy_header[len('Heavy_'):-len('.h')]
+    cls = f'Heavy_{base}'
+    indices = {n: i for i, (_, _, n, _) in enumerate(receiver_entries(ir, base))}
+    lines = ''
+    for name in sorted(set(names)):
+        if name not in indices:
+            print(f"c2espidf: warning: '{name}' is not a receiver of the patch, latest-wins not applied")
+            continue
+        lines += f'  setReceiverLatestWins({indices[name]}, true); // {name}\n'
+    if lines and not patch_file(os.path.join(hvcc_c_dir, f'{cls}.cpp'),
+                                [('  initParameterBank();\n', '  initParameterBank();\n' + lines)]):
+        print(f"c2espidf: warning: unexpected layout in {cls}.cpp, latest-wins receivers not set")
+
+
+def load_board(config: dict) -> dict:
+    # Pin assignments of the control surface: config "board" is a JSON file or an inline object
+    board = config.get('board', os.path.join(resource_dir('boards'), 'default.json'))
+    if isinstance(board, dict):
+        return board
+    with open(board, 'r') as f:
+        return json.load(f)
+
+
+def c_float(x: float) -> str:
+    s = repr(float(x))
+    return s + 'f' if ('.' in s or 'e' in s) else s + '.0f'
+
+
+# MIDI input receivers decoded by HvMidiParser
+MIDI_RECEIVERS = ('__hv_notein', '__hv_ctlin', '__hv_pgmin', '__hv_touchin', '__hv_bendin', '__hv_polytouchin')
+
+
+def control_entries(ir: Optional[dict], hvcc_c_dir: str, base: str, board: dict) -> tuple:
+    # Buttons, knobs, encoders, the MIDI input, the control link and the OSC input of the board that map
+    # onto the patch, and the patch's number of receivers, for control_map.h
+    if ir is None:
+        return [], [], [], None, None, None, 0
+    receivers = ir.get('control', {}).get('receivers', {})
+    indices = {n: (i, v) for i, (_, v, n, _) in enumerate(receiver_entries(ir, base))}
+    params = {n: ident for ident, _, n in parameter_in_entries(hvcc_c_dir, base)}
+    prefix = f"HV_{base.upper()}"
+
+    buttons = []
+    for b in board.get('buttons', []):
+        name = b['receiver']
+        if name not in indices:
+            print(f"c2espidf: warning: button '{name}' is not a receiver of the patch, not mapped")
+            continue
+        mode = b.get('mode', 'bang')
+        if mode not in ('bang', 'level'):
+            raise RuntimeError(f"c2espidf: button '{name}': unknown mode '{mode}'")
+        buttons.append({
+            'name': name, 'gpio': int(b['gpio']),
+            'index': hash_identifier(f"{prefix}_RECEIVER_INDEX", name),
+            'hash': hash_identifier(f"{prefix}_RECEIVER", name),
+            'active_low': 'true' if b.get('active_low', True) else 'false',
+            'mode': f"CONTROL_BUTTON_{mode.upper()}",
+        })
+
+    def param_range(kind: str, name: str, curve: str) -> dict:
+        # scaling of a position in [0, 1] onto the @hv_param range, and where the default sits
+        attributes = receivers[name].get('attributes', {})
+        lo, hi = float(attributes.get('min', 0.0)), float(attributes.get('max', 1.0))
+        default = float(attributes.get('default', lo))
+        if curve not in ('linear', 'exp'):
+            raise RuntimeError(f"c2espidf: {kind} '{name}': unknown curve '{curve}'")
+        if curve == 'exp' and (lo == 0.0 or hi / lo <= 0.0 or default / lo <= 0.0):
+            print(f"c2espidf: warning: {kind} '{name}' range {lo}..{hi} includes zero, using a linear curve")
+            curve = 'linear'
+        scale = math.log(hi / lo) if curve == 'exp' else hi - lo
+        if scale == 0.0:
+            start = 0.0
+        else:
+            start = math.log(default / lo) / scale if curve == 'exp' else (default - lo) / scale
+        return {
+            'min': c_float(lo), 'scale': c_float(scale), 'start': c_float(min(max(start, 0.0), 1.0)),
+            'curve': f"CONTROL_CURVE_{curve.upper()}", 'range': f"{lo:g}..{hi:g} {curve}",
+        }
+
+    knobs = []
+    for k in board.get('knobs', []):
+        name = k['receiver']
+        if name not in params:
+            print(f"c2espidf: warning: knob '{name}' is not an @hv_param receiver, not mapped")
+            continue
+        knobs.append({
+            'name': name, 'channel': int(k['adc_channel']), 'param': params[name],
+            'hash': hash_identifier(f"{prefix}_RECEIVER", name),
+            **param_range('knob', name, k.get('curve', 'linear')),
+        })
+
+    encoders = []
+    for e in board.get('encoders', []):
+        name = e['receiver']
+        mode = e.get('mode', 'delta')
+        if mode not in ('delta', 'absolute'):
+            raise RuntimeError(f"c2espidf: encoder '{name}': unknown mode '{mode}'")
+        if name not in indices or (mode == 'absolute' and name not in params):
+            print(f"c2espidf: warning: encoder '{name}' is not {'an @hv_param' if mode == 'absolute' else 'a'}"
+                  " receiver of the patch, not mapped")
+            continue
+        entry = {
+            'name': name, 'gpio_a': int(e['gpio_a']), 'gpio_b': int(e['gpio_b']),
+            'mode': f"CONTROL_ENCODER_{mode.upper()}",
+            'index': hash_identifier(f"{prefix}_RECEIVER_INDEX", name),
+            'param': params[name] if mode == 'absolute' else '-1',
+            'hash': hash_identifier(f"{prefix}_RECEIVER", name),
+            'counts_per_detent': int(e.get('counts_per_detent', 4)),
+            'acceleration': c_float(e.get('acceleration', 0.2)),
+            'step': c_float(e.get('step', 0.01)),
+        }
+        if mode == 'absolute':
+            entry.update(param_range('encoder', name, e.get('curve', 'linear')))
+        else:
+            entry.update({'min': '0.0f', 'scale': '1.0f', 'start': '0.0f', 'curve': 'CONTROL_CURVE_LINEAR', 'range': ''})
+        encoders.append(entry)
+
+    # hvcc turns [notein], [ctlin] and friends into receivers named after them
+    midi = None
+    if 'midi' in board:
+        used = sorted(n for n in receivers if n in MIDI_RECEIVERS)
+        if used:
+            midi = {'uart': int(board['midi'].get('uart', 2)), 'rx_gpio': int(board['midi']['rx_gpio']),
+                    'receivers': ', '.join(n[len('__hv_'):] for n in used)}
+        else:
+            print("c2espidf: warning: the patch has no MIDI input objects, MIDI input not mapped")
+
+    link = None
+    if 'link' in board:
+        link = {'uart': int(board['link'].get('uart', 1)), 'baud': int(board['link'].get('baud', 921600)),
+                'rx_gpio': board['link'].get('rx_gpio')}
+
+    # every receiver answers to /<name>, plus any addresses the board names
+    osc = None
+    if 'osc' in board:
+        addresses = {f"/{n}": n for n in indices if not n.startswith('__hv_')}
+        for address, name in board['osc'].get('addresses', {}).items():
+            if not address.startswith('/'):
+                raise RuntimeError(f"c2espidf: OSC address '{address}' doesn't start with '/'")
+            if name not in indices:
+                print(f"c2espidf: warning: OSC address '{address}': '{name}' is not a receiver of the patch, not mapped")
+                continue
+            addresses[address] = name
+        entries = sorted((hv_string_to_hash(a), a, n) for a, n in addresses.items())
+        osc = {'port': int(board['osc'].get('port', 9000)), 'addresses': [
+            {'hash': f"0x{h:08X}", 'address': a, 'index': hash_identifier(f"{prefix}_RECEIVER_INDEX", n), 'name': n}
+            for h, a, n in entries]}
+    return buttons, knobs, encoders, midi, link, osc, len(indices)
+
+
+def render_templates(project_name: str, out_dir: str, heavy_header: str, hv_new_fn: str, hash_prefix: str,
+                     sends: List[tuple], controls: tuple, ws_pin: int = 26, bclk_pin: int = 27, dout_pin: int = 25, din_pin: int = 35,
+                     sample_rate: int = 48000) -> None:
+    env = template_env()
+
     # Root CMakeLists.txt
     root_cmake = env.get_template('root_CMakeLists.txt.j2').render(project_name=project_name)
     with open(os.path.join(out_dir, 'CMakeLists.txt'), 'w') as f:
         f.write(root_cmake)
 
-    # main/CMakeLists.txt
+    # main/CMakeLists.txt, with the network components only if the board takes OSC
+    buttons, knobs, encoders, midi, link, osc, num_receivers = controls
     main_dir = os.path.join(out_dir, 'main')
     os.makedirs(main_dir, exist_ok=True)
-    main_cmake = env.get_template('main_CMakeLists.txt.j2').render()
+    main_cmake = env.get_template('main_CMakeLists.txt.j2').render(osc=osc)
     with open(os.path.join(main_dir, 'CMakeLists.txt'), 'w') as f:
         f.write(main_cmake)
 
+    # main/Kconfig.projbuild, the network settings of the OSC input
+    with open(os.path.join(main_dir, 'Kconfig.projbuild'), 'w') as f:
+        f.write(env.get_template('main_Kconfig.projbuild.j2').render())
+
     # Wrapper C file
     wrapper = env.get_template('poc_esp32_hvcc_i2s.c.j2').render(
         heavy_header=heavy_header,
         hv_new_fn=hv_new_fn,
+        hash_prefix=hash_prefix,
+        sends=[(i, v, n, 'on_' + i[len(hash_prefix + '_SEND_'):].lower()) for i, v, n in sends],
         ws_pin=ws_pin,
         bclk_pin=bclk_pin,
         dout_pin=dout_pin,
+        din_pin=din_pin,
         sample_rate=sample_rate,
     )
     with open(os.path.join(main_dir, 'poc_esp32_hvcc_i2s.c'), 'w') as f:
         f.write(wrapper)
 
+    # Control surface tables
+    control_map = env.get_template('control_map.h.j2').render(
+        heavy_header=heavy_header, buttons=buttons, knobs=knobs, encoders=encoders, midi=midi, link=link, osc=osc,
+        num_receivers=num_receivers)
+    with open(os.path.join(main_dir, 'control_map.h'), 'w') as f:
+        f.write(control_map)
+
 class c2espidf(Generator):
     @classmethod
     def compile(
@@ -60,6 +587,7 @@ class c2espidf(Generator):
         verbose: Optional[bool] = False
     ) -> CompilerResp:
         t0 = time.time()
+        config = load_config()
         project_name = (patch_name or "hvcc_esp32_audio").replace(" ", "_")
 
         main_dir = os.path.join(out_dir, "main")
@@ -77,34 +605,31 @@ class c2espidf(Generator):
             if os.path.isfile(src):
                 shutil.copy2(src, dst)
 
+        overlay_runtime(hvcc_c_dir)
+        render_static_symbols(hvcc_c_dir)
+
         # Determine Heavy header and init function
         heavy_header = "Heavy_heavy.h"
         hv_new_fn = "hv_heavy_new"
+        hash_prefix = "HV_HEAVY"
         for name in os.listdir(hvcc_c_dir):
             if name.startswith("Heavy_") and name.endswith(".h"):
                 heavy_header = name
                 base = name.replace("Heavy_", "").replace(".h", "")
                 hv_new_fn = f"hv_{base}_new"
+                hash_prefix = f"HV_{base.upper()}"
                 break
 
-        render_templates(project_name, out_dir, heavy_header, hv_new_fn)
-
-        hv_msg = os.path.join(hvcc_c_dir, "HvMessage.c")
-        if os.path.exists(hv_msg):
-            with open(hv_msg, "r") as rf:
-                s = rf.read()
-            s = s.replace("\"0x%X\"", "\"0x%\" PRIX32")
-            with open(hv_msg, "w") as wf:
-                wf.write(s)
-
-        hv_utils = os.path.join(hvcc_c_dir, "HvUtils.h")
-        if os.path.exists(hv_utils):
-            with open(hv_utils, "r") as rf:
-                s = rf.read()
-            if "#include <inttypes.h>" not in s and "#include <stdint.h>" in s:
-                s = s.replace("#include <stdint.h>", "#include <stdint.h>\n#include <inttypes.h>")
-            with open(hv_utils, "w") as wf:
-                wf.write(s)
+        ir = load_ir(c_src_dir)
+        render_hash_constants(hvcc_c_dir, heavy_header, ir)
+        render_receiver_table(hvcc_c_dir, heavy_header, ir)
+        render_send_table(hvcc_c_dir, heavy_header, ir)
+        render_smoothers(hvcc_c_dir, heavy_header, ir, config.get('smoothing', {}))
+        render_latest_wins(hvcc_c_dir, heavy_header, ir, config.get('latest_wins', []))
+        base = heavy_header[len('Heavy_'):-len('.h')]
+        sends = send_entries(ir, base) if ir is not None else []
+        controls = control_entries(ir, hvcc_c_dir, base, load_board(config))
+        render_templates(project_name, out_dir, heavy_header, hv_new_fn, hash_prefix, sends, controls)
 
         t1 = time.time()
         return CompilerResp(
@@ -0,0 +1,764 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HeavyContext.hpp"
+#include "HvTable.h"
+#include <limits>
+#include <new>
+
+void defaultSendHook(HeavyContextInterface *context,
+    const char *sendName, hv_uint32_t sendHash, const HvMessage *msg) {
+  HeavyContext *thisContext = reinterpret_cast<HeavyContext *>(context);
+  if (thisContext->filterSends.load(std::memory_order_relaxed)) {
+    // only dispatched messages are queued, so don't copy what nobody listens to
+    HvSendSubscription *s = thisContext->getSendSubscription(sendHash);
+    if (s == nullptr || s->callback.load(std::memory_order_relaxed) == nullptr) return;
+  }
+  const hv_uint32_t numBytes = sizeof(ReceiverMessagePair) + msg_getSize(msg) - sizeof(HvMessage);
+  ReceiverMessagePair *p = reinterpret_cast<ReceiverMessagePair *>(hLp_getWriteBuffer(&thisContext->outQueue, numBytes));
+  if (p != nullptr) {
+    p->receiverHash = sendHash;
+    p->receiverIndex = HV_RECEIVER_INDEX_NONE;
+    msg_copyToBuffer(msg, (char *) &p->msg, msg_getSize(msg));
+    hLp_produce(&thisContext->outQueue, numBytes);
+    hNt_notify(&thisContext->outNotifier);
+  } else {
+    hv_assert(false &&
+        "::defaultSendHook - The out message queue is full and cannot accept more messages until they "
+        "have been processed. Try increasing the outQueueKb size in the new_with_options() constructor.");
+  }
+}
+
+HeavyContext::HeavyContext(double sampleRate, int poolKb, int inQueueKb, int outQueueKb) :
+    sampleRate(sampleRate),
+    samplesPerMillisecond((float) (sampleRate/1000.0)),
+    samplesPerMillisecondError((float) (sampleRate/1000.0 - samplesPerMillisecond)),
+    millisecondsPerSample((float) (1000.0/sampleRate)),
+    samplePeriod((float) (1.0/sampleRate)) {
+
+  hv_assert(sampleRate > 0.0); // sample rate must be positive
+  hv_assert(poolKb > 0);
+  hv_assert(inQueueKb > 0);
+  hv_assert(outQueueKb >= 0);
+
+  blockStartTimestamp = 0;
+  printHook = nullptr;
+  userData = nullptr;
+  receiverTable = nullptr;
+  parameters = nullptr;
+  numParameters = 0;
+  receiverParameters = nullptr;
+  latestWins = nullptr;
+  numLatestWins.store(0, std::memory_order_relaxed);
+  sendTable = nullptr;
+  subscriptions = nullptr;
+  filterSends.store(false, std::memory_order_relaxed);
+  hNt_init(&outNotifier);
+  hMp_init(&printQueue, 0);
+  numDroppedPrints.store(0, std::memory_order_relaxed);
+  hNt_init(&printNotifier);
+  sampleRateHz = (hv_uint32_t) (sampleRate + 0.5);
+  sampleClock.sequence.store(0, std::memory_order_relaxed);
+  sampleClock.sample = 0;
+  sampleClock.timeUs = 0;
+
+  // if outQueueKb is positive, then the outQueue is allocated and the default sendhook is set.
+  // Otherwise outQueue and the sendhook are set to NULL.
+  sendHook = (outQueueKb > 0) ? &defaultSendHook : nullptr;
+
+  HV_SPINLOCK_RELEASE(outQueueLock);
+
+  numBytes = sizeof(HeavyContext);
+
+  numBytes += mq_initWithPoolSize(&mq, poolKb);
+  numBytes += hMp_init(&inQueue, inQueueKb * 1024);
+  numBytes += hLp_init(&outQueue, outQueueKb * 1024); // outQueueKb value of 0 sets everything to NULL
+}
+
+HeavyContext::~HeavyContext() {
+  hv_free(parameters);
+  hv_free(receiverParameters);
+  hv_free(latestWins);
+  hv_free(subscriptions);
+  hNt_free(&outNotifier);
+  hMp_free(&printQueue);
+  hNt_free(&printNotifier);
+  mq_free(&mq);
+  hMp_free(&inQueue);
+  hLp_free(&outQueue);
+}
+
+bool HeavyContext::sendBangToReceiver(hv_uint32_t receiverHash) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithBang(m, 0);
+  bool success = sendMessageToReceiver(receiverHash, 0.0f, m);
+  return success;
+}
+
+bool HeavyContext::sendFloatToReceiver(hv_uint32_t receiverHash, float f) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithFloat(m, 0, f);
+  bool success = sendMessageToReceiver(receiverHash, 0.0f, m);
+  return success;
+}
+
+bool HeavyContext::sendSymbolToReceiver(hv_uint32_t receiverHash, const char *s) {
+  hv_assert(s != nullptr);
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithSymbol(m, 0, (char *) s);
+  bool success = sendMessageToReceiver(receiverHash, 0.0f, m);
+  return success;
+}
+
+bool HeavyContext::sendBangToReceiverIndex(hv_uint32_t receiverIndex) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithBang(m, 0);
+  bool success = sendMessageToReceiverIndex(receiverIndex, 0.0f, m);
+  return success;
+}
+
+bool HeavyContext::sendFloatToReceiverIndex(hv_uint32_t receiverIndex, float f) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithFloat(m, 0, f);
+  bool success = sendMessageToReceiverIndex(receiverIndex, 0.0f, m);
+  return success;
+}
+
+bool HeavyContext::sendSymbolToReceiverIndex(hv_uint32_t receiverIndex, const char *s) {
+  hv_assert(s != nullptr);
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithSymbol(m, 0, (char *) s);
+  bool success = sendMessageToReceiverIndex(receiverIndex, 0.0f, m);
+  return success;
+}
+
+hv_uint32_t HeavyContext::millisecondsToSamples(float ms) {
+  // A plain float product can round up onto the next sample (e.g. ms*48.0f), so the
+  // rounding error is recovered with a fused multiply-add and truncation lands on the
+  // same sample as the exact ms*sampleRate/1000.
+  ms = hv_max_f(0.0f, ms);
+  const float p = ms*samplesPerMillisecond;
+  const float e = hv_fma_f(ms, samplesPerMillisecond, -p) + ms*samplesPerMillisecondError;
+  hv_uint32_t n = (hv_uint32_t) p;
+  const float r = (p - (float) n) + e;
+  if (r < 0.0f) --n;
+  else if (r >= 1.0f) ++n;
+  return n;
+}
+
+bool HeavyContext::sendMessageToReceiverV(hv_uint32_t receiverHash, float delayMs, const char *format, ...) {
+  hv_assert(delayMs >= 0.0f);
+  hv_assert(format != nullptr);
+
+  va_list ap;
+  va_start(ap, format);
+  const int numElem = (int) hv_strlen(format);
+  HvMessage *m = HV_MESSAGE_ON_STACK(numElem);
+  msg_init(m, numElem, blockStartTimestamp); // the delay is applied by enqueueMessage()
+  for (int i = 0; i < numElem; i++) {
+    switch (format[i]) {
+      case 'b': msg_setBang(m, i); break;
+      case 'f': msg_setFloat(m, i, (float) va_arg(ap, double)); break;
+      case 'h': msg_setHash(m, i, (int) va_arg(ap, int)); break;
+      case 's': msg_setSymbol(m, i, (char *) va_arg(ap, char *)); break;
+      default: break;
+    }
+  }
+  va_end(ap);
+
+  bool success = sendMessageToReceiver(receiverHash, delayMs, m);
+  return success;
+}
+
+bool HeavyContext::sendMessageToReceiver(hv_uint32_t receiverHash, float delayMs, HvMessage *m) {
+  hv_assert(delayMs >= 0.0f);
+  hv_uint32_t i = HV_RECEIVER_INDEX_NONE;
+  if (numLatestWins.load(std::memory_order_relaxed) > 0 && delayMs <= 0.0f) {
+    i = getReceiverIndex(receiverHash);
+    if (i != HV_RECEIVER_INDEX_NONE && storeLatestValue(i, m)) return true;
+  }
+  return enqueueMessage(receiverHash, i, blockStartTimestamp + millisecondsToSamples(delayMs), m);
+}
+
+bool HeavyContext::sendMessageToReceiverIndex(hv_uint32_t receiverIndex, float delayMs, HvMessage *m) {
+  hv_assert(delayMs >= 0.0f);
+  if (receiverTable == nullptr || receiverIndex >= receiverTable->numReceivers) return false;
+  if (delayMs <= 0.0f && storeLatestValue(receiverIndex, m)) return true;
+  return enqueueMessage(receiverTable->hashes[receiverIndex], receiverIndex,
+      blockStartTimestamp + millisecondsToSamples(delayMs), m);
+}
+
+// Message timestamps count the same samples as the clock, modulo 2^32. The queue compares
+// them as serial numbers, so a sample near the current time keeps its order across a wrap,
+// while 0 (e.g. from timeToSample() before the first reference) always means the next block.
+static inline hv_uint32_t getTimestampForSample(hv_uint64_t sample, hv_uint32_t blockStartTimestamp) {
+  return (sample == 0) ? blockStartTimestamp : (hv_uint32_t) sample;
+}
+
+bool HeavyContext::sendMessageAtSample(hv_uint32_t receiverHash, hv_uint64_t sample, HvMessage *m) {
+  return enqueueMessage(receiverHash, HV_RECEIVER_INDEX_NONE, getTimestampForSample(sample, blockStartTimestamp), m);
+}
+
+// a marker fits in the smallest record, which no message pair does
+static_assert(sizeof(HvInputMarker) <= HMP_HEADER_SIZE && sizeof(ReceiverMessagePair) > HMP_HEADER_SIZE,
+    "input markers must be told apart from messages by their size");
+
+bool HeavyContext::queueMarker(hv_uint32_t receiverIndex, hv_uint32_t parameterIndex) {
+  char *b = hMp_getWriteBuffer(&inQueue, hMp_getRecordSize(sizeof(HvInputMarker)));
+  if (b == nullptr) return false;
+  HvInputMarker *k = reinterpret_cast<HvInputMarker *>(b);
+  k->receiverIndex = receiverIndex;
+  k->parameterIndex = parameterIndex;
+  hMp_produce(&inQueue, b, sizeof(HvInputMarker));
+  return true;
+}
+
+bool HeavyContext::storeLatestValue(hv_uint32_t receiverIndex, const HvMessage *m) {
+  if (latestWins == nullptr || msg_getNumElements(m) != 1 || !msg_isFloat(m, 0)) return false;
+  HvLatestWinsSlot *const slot = latestWins + receiverIndex;
+  // a float racing with switching the slot off still goes through the slot, in order
+  if (!slot->enabled.load(std::memory_order_relaxed)) return false;
+  const float f = msg_getFloat(m, 0);
+  if (f != f) return false; // NaN could be mistaken for an empty slot, so queue it
+  hv_uint32_t bits;
+  hv_memcpy(&bits, &f, sizeof(bits));
+  if (slot->value.exchange(bits, std::memory_order_relaxed) != HV_LATEST_WINS_EMPTY) {
+    return true; // its marker is already queued, and will deliver this float instead
+  }
+  // the slot was empty, so this float takes its place in the queue with a marker
+  if (!queueMarker(receiverIndex, HV_PARAMETER_INDEX_NONE)) {
+    // without a marker the slot would never be read, so empty it again; a float stored
+    // in the meantime is dropped with this one, as the queue is full anyway
+    slot->value.store(HV_LATEST_WINS_EMPTY, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+static inline hv_uint32_t getReceiverMessagePairSize(const HvMessage *m) {
+  return sizeof(ReceiverMessagePair) + msg_getSize(m) - sizeof(HvMessage);
+}
+
+bool HeavyContext::enqueueMessage(hv_uint32_t receiverHash, hv_uint32_t receiverIndex, hv_uint32_t timestamp, HvMessage *m) {
+  hv_assert(m != nullptr);
+  if (receiverIndex == HV_RECEIVER_INDEX_NONE && receiverParameters != nullptr) {
+    // looked up here rather than on the audio thread, which needs it for the parameter bank
+    receiverIndex = getReceiverIndex(receiverHash);
+  }
+
+  const hv_uint32_t numBytes = getReceiverMessagePairSize(m);
+  char *b = hMp_getWriteBuffer(&inQueue, hMp_getRecordSize(numBytes));
+  if (b != nullptr) {
+    ReceiverMessagePair *p = reinterpret_cast<ReceiverMessagePair *>(b);
+    p->receiverHash = receiverHash;
+    p->receiverIndex = receiverIndex;
+    msg_copyToBuffer(m, (char *) &p->msg, msg_getSize(m));
+    msg_setTimestamp(&p->msg, timestamp);
+    hMp_produce(&inQueue, b, numBytes);
+  } else {
+    hv_assert(false &&
+        "::sendMessageToReceiver - The input message queue is full and cannot accept more messages until they "
+        "have been processed. Try increasing the inQueueKb size in the new_with_options() constructor.");
+  }
+  return (b != nullptr);
+}
+
+int HeavyContext::sendBatch(const HvEvent *events, int numEvents) {
+  hv_assert(events != nullptr || numEvents <= 0);
+
+  // accepted events always form a prefix, so stop at the first invalid receiver index
+  int n = 0;
+  hv_uint32_t totalBytes = 0;
+  for (; n < numEvents; ++n) {
+    const hv_uint32_t receiverIndex = events[n].receiverIndex;
+    if (receiverIndex != HV_RECEIVER_INDEX_NONE &&
+        (receiverTable == nullptr || receiverIndex >= receiverTable->numReceivers)) break;
+    hv_assert(events[n].msg != nullptr);
+    totalBytes += hMp_getRecordSize(getReceiverMessagePairSize(events[n].msg));
+  }
+  if (n == 0) return 0;
+
+  // reserve one contiguous region, dropping events from the back until it fits
+  char *b = nullptr;
+  while (n > 0 && (b = hMp_getWriteBuffer(&inQueue, totalBytes)) == nullptr) {
+    totalBytes -= hMp_getRecordSize(getReceiverMessagePairSize(events[--n].msg));
+  }
+  if (b != nullptr) {
+    const hv_uint32_t firstBytes = getReceiverMessagePairSize(events[0].msg);
+    char *const first = b;
+    hv_uint32_t numBytes = firstBytes;
+    for (int i = 0; i < n; ++i) {
+      const HvEvent *e = events + i;
+      if (i > 0) {
+        const hv_uint32_t nextBytes = getReceiverMessagePairSize(e->msg);
+        b = hMp_getNextBatchBuffer(b, numBytes, nextBytes);
+        numBytes = nextBytes;
+      }
+      ReceiverMessagePair *p = reinterpret_cast<ReceiverMessagePair *>(b);
+      p->receiverHash = (e->receiverIndex != HV_RECEIVER_INDEX_NONE) ?
+          receiverTable->hashes[e->receiverIndex] : e->receiverHash;
+      p->receiverIndex = (e->receiverIndex == HV_RECEIVER_INDEX_NONE && receiverParameters != nullptr) ?
+          getReceiverIndex(e->receiverHash) : e->receiverIndex;
+      msg_copyToBuffer(e->msg, (char *) &p->msg, msg_getSize(e->msg));
+      msg_setTimestamp(&p->msg, getTimestampForSample(e->sample, blockStartTimestamp));
+    }
+    hMp_produce(&inQueue, first, firstBytes);
+  }
+  // unlike sendMessageToReceiver(), a full queue is reported through the return value only
+  return n;
+}
+
+bool HeavyContext::cancelMessage(HvMessage *m, void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *)) {
+  return mq_removeMessage(&mq, m, sendMessage);
+}
+
+void HeavyContext::scheduleMessageForReceiverIndex(hv_uint32_t receiverIndex, HvMessage *m) {
+  hv_assert(receiverTable != nullptr && receiverIndex < receiverTable->numReceivers);
+  const hv_uint32_t end = receiverTable->offsets[receiverIndex + 1];
+  for (hv_uint32_t i = receiverTable->offsets[receiverIndex]; i < end; ++i) {
+    mq_addMessageByTimestamp(&mq, m, 0, receiverTable->targets[i]);
+  }
+}
+
+hv_uint32_t HeavyContext::getReceiverIndex(hv_uint32_t receiverHash) {
+  if (receiverTable == nullptr) return HV_RECEIVER_INDEX_NONE;
+  const hv_uint32_t *const order = receiverTable->hashOrder;
+  hv_uint32_t lo = 0;
+  hv_uint32_t hi = receiverTable->numReceivers;
+  while (lo < hi) {
+    const hv_uint32_t mid = (lo + hi) / 2;
+    if (receiverTable->hashes[order[mid]] < receiverHash) lo = mid + 1;
+    else hi = mid;
+  }
+  return (lo < receiverTable->numReceivers && receiverTable->hashes[order[lo]] == receiverHash) ?
+      order[lo] : HV_RECEIVER_INDEX_NONE;
+}
+
+void HeavyContext::initReceiverTable(const HvReceiverTable *table) {
+  hv_assert(table != nullptr);
+  receiverTable = table;
+  if (table->numReceivers == 0) return;
+  // allocated up front, so that setReceiverLatestWins() never changes the pointer under a sender
+  latestWins = (HvLatestWinsSlot *) hv_malloc(table->numReceivers * sizeof(HvLatestWinsSlot));
+  hv_assert(latestWins != nullptr);
+  numBytes += table->numReceivers * sizeof(HvLatestWinsSlot);
+  for (hv_uint32_t i = 0; i < table->numReceivers; ++i) {
+    HvLatestWinsSlot *s = new (latestWins + i) HvLatestWinsSlot;
+    s->value.store(HV_LATEST_WINS_EMPTY, std::memory_order_relaxed);
+    s->enabled.store(false, std::memory_order_relaxed);
+  }
+}
+
+void HeavyContext::initParameterBank() {
+  numParameters = (hv_uint32_t) hv_max_i(getParameterInfo(0, nullptr), 0);
+  if (numParameters == 0) return;
+  parameters = (HvParameterSlot *) hv_malloc(numParameters * sizeof(HvParameterSlot));
+  hv_assert(parameters != nullptr);
+  numBytes += numParameters * sizeof(HvParameterSlot);
+
+  for (hv_uint32_t i = 0; i < numParameters; ++i) {
+    HvParameterInfo info;
+    getParameterInfo((int) i, &info);
+    HvParameterSlot *s = new (parameters + i) HvParameterSlot;
+    s->value.store(info.defaultVal, std::memory_order_relaxed);
+    s->stored.store(false, std::memory_order_relaxed);
+    s->applied = std::numeric_limits<float>::quiet_NaN(); // the patch is never sent the default, so even it must be forwarded
+    s->receiverIndex = HV_RECEIVER_INDEX_NONE;
+    if (info.type == HvParameterType::HV_PARAM_TYPE_PARAMETER_IN) {
+      s->receiverIndex = getReceiverIndex(info.hash);
+    }
+  }
+
+  // the audio thread maps every message's receiver to its parameter, so make that a lookup
+  if (receiverTable == nullptr || receiverTable->numReceivers == 0) return;
+  receiverParameters = (hv_uint32_t *) hv_malloc(receiverTable->numReceivers * sizeof(hv_uint32_t));
+  hv_assert(receiverParameters != nullptr);
+  numBytes += receiverTable->numReceivers * sizeof(hv_uint32_t);
+  for (hv_uint32_t i = 0; i < receiverTable->numReceivers; ++i) receiverParameters[i] = HV_PARAMETER_INDEX_NONE;
+  for (hv_uint32_t i = 0; i < numParameters; ++i) {
+    if (parameters[i].receiverIndex != HV_RECEIVER_INDEX_NONE) receiverParameters[parameters[i].receiverIndex] = i;
+  }
+}
+
+void HeavyContext::initSendSubscriptions() {
+  if (sendTable == nullptr || sendTable->numSends == 0) return;
+  subscriptions = (HvSendSubscription *) hv_malloc(sendTable->numSends * sizeof(HvSendSubscription));
+  hv_assert(subscriptions != nullptr);
+  numBytes += sendTable->numSends * sizeof(HvSendSubscription);
+  for (hv_uint32_t i = 0; i < sendTable->numSends; ++i) {
+    HvSendSubscription *s = new (subscriptions + i) HvSendSubscription;
+    s->callback.store(nullptr, std::memory_order_relaxed);
+    s->userData = nullptr;
+  }
+}
+
+HvSendSubscription *HeavyContext::getSendSubscription(hv_uint32_t sendHash) {
+  if (subscriptions == nullptr) return nullptr;
+  hv_uint32_t lo = 0;
+  hv_uint32_t hi = sendTable->numSends;
+  while (lo < hi) {
+    const hv_uint32_t mid = (lo + hi) / 2;
+    if (sendTable->hashes[mid] < sendHash) lo = mid + 1;
+    else hi = mid;
+  }
+  return (lo < sendTable->numSends && sendTable->hashes[lo] == sendHash) ? subscriptions + lo : nullptr;
+}
+
+bool HeavyContext::setParameterValue(int index, float value) {
+  if (index < 0 || (hv_uint32_t) index >= numParameters) return false;
+  if (parameters[index].receiverIndex == HV_RECEIVER_INDEX_NONE) return false;
+  if (value != value) return false; // NaN would never compare as applied
+  HvParameterSlot *const s = parameters + index;
+  s->value.store(value, std::memory_order_relaxed);
+  // a marker already queued delivers this value, as the audio thread reads it after the flag
+  if (s->stored.exchange(true, std::memory_order_release)) return true;
+  if (!queueMarker(s->receiverIndex, (hv_uint32_t) index)) {
+    // without a marker the slot would never be read; the value is dropped, as a message would be
+    s->stored.store(false, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void HeavyContext::forgetAppliedParameter(hv_uint32_t receiverIndex) {
+  if (receiverParameters == nullptr || receiverIndex == HV_RECEIVER_INDEX_NONE) return;
+  const hv_uint32_t k = receiverParameters[receiverIndex];
+  if (k != HV_PARAMETER_INDEX_NONE) parameters[k].applied = std::numeric_limits<float>::quiet_NaN();
+}
+
+bool HeavyContext::setReceiverLatestWins(hv_uint32_t receiverIndex, bool enable) {
+  if (receiverTable == nullptr || receiverIndex >= receiverTable->numReceivers) return false;
+  HvLatestWinsSlot *const slot = latestWins + receiverIndex;
+  if (enable) {
+    // counted before the slot opens, so the count never falls below the open slots
+    numLatestWins.fetch_add(1, std::memory_order_relaxed);
+    if (slot->enabled.exchange(true, std::memory_order_relaxed)) {
+      numLatestWins.fetch_sub(1, std::memory_order_relaxed); // already on
+    }
+  } else if (slot->enabled.exchange(false, std::memory_order_relaxed)) {
+    // a float still pending keeps its marker, and is delivered in its place
+    numLatestWins.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void HeavyContext::processInputQueue() {
+  HvMessage *latest = HV_MESSAGE_ON_STACK(1);
+  hv_uint32_t numBytes = 0;
+  char *b;
+  while ((b = hMp_getReadBuffer(&inQueue, &numBytes)) != nullptr) {
+    if (numBytes < sizeof(ReceiverMessagePair)) {
+      // a marker: its slot holds the newest value stored since the marker was queued
+      const HvInputMarker *k = reinterpret_cast<HvInputMarker *>(b);
+      const hv_uint32_t i = k->receiverIndex;
+      if (k->parameterIndex != HV_PARAMETER_INDEX_NONE) {
+        HvParameterSlot *s = parameters + k->parameterIndex;
+        // reading the flag pairs with the stores that found it set, so their values are seen
+        s->stored.exchange(false, std::memory_order_acquire);
+        const float f = s->value.load(std::memory_order_relaxed);
+        if (f != s->applied) {
+          s->applied = f;
+          msg_initWithFloat(latest, blockStartTimestamp, f);
+          scheduleMessageForReceiverIndex(i, latest);
+        }
+      } else {
+        const hv_uint32_t bits = latestWins[i].value.exchange(HV_LATEST_WINS_EMPTY, std::memory_order_relaxed);
+        if (bits != HV_LATEST_WINS_EMPTY) {
+          float f;
+          hv_memcpy(&f, &bits, sizeof(f));
+          msg_initWithFloat(latest, blockStartTimestamp, f);
+          scheduleMessageForReceiverIndex(i, latest);
+          forgetAppliedParameter(i);
+        }
+      }
+      hMp_consume(&inQueue);
+      continue;
+    }
+    ReceiverMessagePair *p = reinterpret_cast<ReceiverMessagePair *>(b);
+    // late messages keep their order behind those already due at the block start
+    if (msg_isTimestampBefore(msg_getTimestamp(&p->msg), blockStartTimestamp)) {
+      msg_setTimestamp(&p->msg, blockStartTimestamp);
+    }
+    if (p->receiverIndex != HV_RECEIVER_INDEX_NONE) {
+      scheduleMessageForReceiverIndex(p->receiverIndex, &p->msg);
+    } else {
+      scheduleMessageForReceiver(p->receiverHash, &p->msg);
+    }
+    forgetAppliedParameter(p->receiverIndex);
+    hMp_consume(&inQueue);
+  }
+}
+
+HvMessage *HeavyContext::scheduleMessageForObject(const HvMessage *m,
+    void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *),
+    int letIndex) {
+  HvMessage *n = mq_addMessageByTimestamp(&mq, m, letIndex, sendMessage);
+  return n;
+}
+
+float *HeavyContext::getBufferForTable(hv_uint32_t tableHash) {
+  HvTable *t = getTableForHash(tableHash);
+  if (t != nullptr) {
+    return hTable_getBuffer(t);
+  } else return nullptr;
+}
+
+int HeavyContext::getLengthForTable(hv_uint32_t tableHash) {
+  HvTable *t = getTableForHash(tableHash);
+  if (t != nullptr) {
+    return hTable_getLength(t);
+  } else return 0;
+}
+
+bool HeavyContext::setLengthForTable(hv_uint32_t tableHash, hv_uint32_t newSampleLength) {
+  HvTable *t = getTableForHash(tableHash);
+  if (t != nullptr) {
+    hTable_resize(t, newSampleLength);
+    return true;
+  } else return false;
+}
+
+// The input queue is lock-free, so there is no lock to take. These are kept so that
+// code written against the stock runtime still builds and runs.
+void HeavyContext::lockAcquire() {}
+
+bool HeavyContext::lockTry() {
+  return true;
+}
+
+void HeavyContext::lockRelease() {}
+
+void HeavyContext::setInputMessageQueueSize(int inQueueKb) {
+  hv_assert(inQueueKb > 0);
+  hMp_free(&inQueue);
+  hMp_init(&inQueue, inQueueKb*1024);
+  // the markers of pending values went with the old queue, so queue them again
+  for (hv_uint32_t i = 0; latestWins != nullptr && i < receiverTable->numReceivers; ++i) {
+    if (latestWins[i].value.load(std::memory_order_relaxed) != HV_LATEST_WINS_EMPTY) {
+      queueMarker(i, HV_PARAMETER_INDEX_NONE);
+    }
+  }
+  for (hv_uint32_t i = 0; i < numParameters; ++i) {
+    if (parameters[i].stored.load(std::memory_order_relaxed)) queueMarker(parameters[i].receiverIndex, i);
+  }
+}
+
+void HeavyContext::setOutputMessageQueueSize(int outQueueKb) {
+  hv_assert(outQueueKb > 0);
+  hLp_free(&outQueue);
+  hLp_init(&outQueue, outQueueKb*1024);
+}
+
+bool HeavyContext::getNextSentMessage(hv_uint32_t *destinationHash, HvMessage *outMsg, hv_size_t msgLengthBytes) {
+  *destinationHash = 0;
+  ReceiverMessagePair *p = nullptr;
+  hv_assert((sendHook == &defaultSendHook) &&
+      "::getNextSentMessage - this function won't do anything if the msg outQueue "
+      "size is 0, or you've overriden the default sendhook.");
+  if (sendHook == &defaultSendHook) {
+    HV_SPINLOCK_ACQUIRE(outQueueLock);
+    if (hLp_hasData(&outQueue)) {
+      hv_uint32_t numBytes = 0;
+      p = reinterpret_cast<ReceiverMessagePair *>(hLp_getReadBuffer(&outQueue, &numBytes));
+      hv_assert((p != nullptr) && "::getNextSentMessage - something bad happened.");
+      hv_assert(numBytes >= sizeof(ReceiverMessagePair));
+      hv_assert((numBytes <= msgLengthBytes) &&
+          "::getNextSentMessage - the sent message is bigger than the message "
+          "passed to handle it.");
+      *destinationHash = p->receiverHash;
+      hv_memcpy(outMsg, &p->msg, numBytes);
+      hLp_consume(&outQueue);
+    }
+    HV_SPINLOCK_RELEASE(outQueueLock);
+  }
+  return (p != nullptr);
+}
+
+bool HeavyContext::subscribeSend(hv_uint32_t sendHash, HvSendCallback_t *f, void *userData) {
+  HvSendSubscription *s = getSendSubscription(sendHash);
+  if (s == nullptr || sendHook != &defaultSendHook) return false;
+  s->userData = userData;
+  s->callback.store(f, std::memory_order_release);
+  filterSends.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+int HeavyContext::dispatchSentMessages() {
+  int numCalls = 0;
+  if (sendHook != &defaultSendHook) return numCalls;
+  HV_SPINLOCK_ACQUIRE(outQueueLock);
+  while (hLp_hasData(&outQueue)) {
+    hv_uint32_t numBytes = 0;
+    ReceiverMessagePair *p = reinterpret_cast<ReceiverMessagePair *>(hLp_getReadBuffer(&outQueue, &numBytes));
+    hv_assert(numBytes >= sizeof(ReceiverMessagePair));
+    // messages queued before the first subscription may have no callback
+    HvSendSubscription *s = getSendSubscription(p->receiverHash);
+    HvSendCallback_t *f = (s != nullptr) ? s->callback.load(std::memory_order_acquire) : nullptr;
+    if (f != nullptr) {
+      f(this, p->receiverHash, &p->msg, s->userData);
+      ++numCalls;
+    }
+    hLp_consume(&outQueue);
+  }
+  HV_SPINLOCK_RELEASE(outQueueLock);
+  return numCalls;
+}
+
+bool HeavyContext::waitForSentMessages(hv_uint32_t timeoutMs) {
+  return hNt_wait(&outNotifier, timeoutMs);
+}
+
+// a print object's message as stored in the print queue
+typedef struct PrintMessagePair {
+  const char *name; // the print object's name, a string literal of the patch
+  HvMessage msg;
+} PrintMessagePair;
+
+void HeavyContext::setPrintQueueSize(int printQueueKb) {
+  hv_assert(printQueueKb >= 0);
+  hMp_free(&printQueue);
+  hMp_init(&printQueue, printQueueKb*1024);
+}
+
+bool HeavyContext::queuePrint(const char *name, const HvMessage *m) {
+  if (printQueue.buffer == nullptr) return false;
+  const hv_uint32_t numBytes = sizeof(PrintMessagePair) + msg_getSize(m) - sizeof(HvMessage);
+  char *b = hMp_getWriteBuffer(&printQueue, hMp_getRecordSize(numBytes));
+  if (b != nullptr) {
+    PrintMessagePair *p = reinterpret_cast<PrintMessagePair *>(b);
+    p->name = name;
+    msg_copyToBuffer(m, (char *) &p->msg, msg_getSize(m));
+    hMp_produce(&printQueue, b, numBytes);
+    hNt_notify(&printNotifier);
+  } else {
+    numDroppedPrints.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+int HeavyContext::dispatchPrints() {
+  int numPrints = 0;
+  hv_uint32_t numBytes = 0;
+  char *b;
+  while ((b = hMp_getReadBuffer(&printQueue, &numBytes)) != nullptr) {
+    PrintMessagePair *p = reinterpret_cast<PrintMessagePair *>(b);
+    hv_assert(numBytes >= sizeof(PrintMessagePair));
+    if (printHook != nullptr) {
+      char s[HV_PRINT_STRING_SIZE]; // longer messages are truncated
+      msg_toStringBuf(&p->msg, s, sizeof(s));
+      printHook(this, p->name, s, &p->msg);
+      ++numPrints;
+    }
+    hMp_consume(&printQueue);
+  }
+  return numPrints;
+}
+
+bool HeavyContext::waitForPrints(hv_uint32_t timeoutMs) {
+  return hNt_wait(&printNotifier, timeoutMs);
+}
+
+void HeavyContext::setSampleClock(hv_int64_t timeUs) {
+  // extend the block start to 64 bits, which holds as long as this is called once per 2^32 samples
+  const hv_uint64_t sample = sampleClock.sample + (hv_uint32_t) (blockStartTimestamp - (hv_uint32_t) sampleClock.sample);
+  const hv_uint32_t s = sampleClock.sequence.load(std::memory_order_relaxed);
+  sampleClock.sequence.store(s + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  sampleClock.sample = sample;
+  sampleClock.timeUs = timeUs;
+  sampleClock.sequence.store(s + 2, std::memory_order_release);
+}
+
+hv_uint64_t HeavyContext::timeToSample(hv_int64_t timeUs) {
+  hv_uint32_t s;
+  hv_uint64_t sample;
+  hv_int64_t refUs;
+  do {
+    s = sampleClock.sequence.load(std::memory_order_acquire);
+    sample = sampleClock.sample;
+    refUs = sampleClock.timeUs;
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((s & 1) || s != sampleClock.sequence.load(std::memory_order_relaxed));
+  if (s == 0) return 0;
+
+  // round to the nearest sample, in 64-bit integers rather than soft-float doubles
+  const hv_int64_t x = (timeUs - refUs) * (hv_int64_t) sampleRateHz;
+  const hv_int64_t d = (x >= 0) ? (x + 500000) / 1000000 : -((500000 - x) / 1000000);
+  return (d >= 0 || (hv_uint64_t) -d <= sample) ? sample + d : 0;
+}
+
+hv_uint32_t HeavyContext::getHashForString(const char *str) {
+  return hv_string_to_hash(str);
+}
+
+HvTable *_hv_table_get(HeavyContextInterface *c, hv_uint32_t tableHash) {
+  hv_assert(c != nullptr);
+  return reinterpret_cast<HeavyContext *>(c)->getTableForHash(tableHash);
+}
+
+void _hv_scheduleMessageForReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, HvMessage *m) {
+  hv_assert(c != nullptr);
+  reinterpret_cast<HeavyContext *>(c)->scheduleMessageForReceiver(receiverHash, m);
+}
+
+HvMessage *_hv_scheduleMessageForObject(HeavyContextInterface *c, const HvMessage *m,
+    void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *),
+    int letIndex) {
+  hv_assert(c != nullptr);
+  HvMessage *n = reinterpret_cast<HeavyContext *>(c)->scheduleMessageForObject(
+      m, sendMessage, letIndex);
+  return n;
+}
+
+bool _hv_queuePrint(HeavyContextInterface *c, const char *name, const HvMessage *m) {
+  hv_assert(c != nullptr);
+  return reinterpret_cast<HeavyContext *>(c)->queuePrint(name, m);
+}
+
+float _hv_getSamplePeriod(HeavyContextInterface *c) {
+  hv_assert(c != nullptr);
+  return reinterpret_cast<HeavyContext *>(c)->samplePeriod;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+HvTable *hv_table_get(HeavyContextInterface *c, hv_uint32_t tableHash) {
+  return _hv_table_get(c, tableHash);
+}
+
+bool hv_queuePrint(HeavyContextInterface *c, const char *name, const HvMessage *m) {
+  return _hv_queuePrint(c, name, m);
+}
+
+float hv_getSamplePeriod(HeavyContextInterface *c) {
+  return _hv_getSamplePeriod(c);
+}
+
+void hv_scheduleMessageForReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, HvMessage *m) {
+  _hv_scheduleMessageForReceiver(c, receiverHash, m);
+}
+
+HvMessage *hv_scheduleMessageForObject(HeavyContextInterface *c, const HvMessage *m,
+    void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *),
+    int letIndex) {
+  return _hv_scheduleMessageForObject(c, m, sendMessage, letIndex);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_AUDIO_IO_H_
+#define _HEAVY_AUDIO_IO_H_
+
+#include "HvUtils.h"
+#include "HvMeter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Conversion between the interleaved integer frames of I2S channels, stereo or
+ * TDM, and the planar float blocks of hv_processInline(), in one pass over the
+ * frames. Channel c of the patch reads and writes slot c.
+ *
+ * There is nothing platform-specific here, so a host can drive it from a mock
+ * of the I2S channels.
+ */
+
+/**
+ * Converts a block read from RX. Channels beyond the slots are silent, and
+ * slots beyond the channels are skipped.
+ *
+ * @param out  numChannels x numFrames floats, channel c at out + c * numFrames.
+ * @param in   numFrames x numSlots 16-bit samples.
+ */
+void hAi_readS16(float *out, hv_uint32_t numChannels, const hv_int16_t *in, hv_uint32_t numSlots, hv_uint32_t numFrames);
+
+/**
+ * As hAi_readS16(), for 32-bit slots, e.g. of 24-bit codecs, which put their
+ * samples in the upper bits.
+ */
+void hAi_readS32(float *out, hv_uint32_t numChannels, const hv_int32_t *in, hv_uint32_t numSlots, hv_uint32_t numFrames);
+
+/**
+ * Converts a block for TX, clipped at full scale. A mono patch goes to every
+ * slot; otherwise slots beyond the channels are silent and channels beyond the
+ * slots are dropped. 2, 4 and 8 slots, fed by as many channels or by one, take
+ * paths unrolled over the slots.
+ *
+ * @param out    numFrames x numSlots 16-bit samples.
+ * @param in     numChannels x numFrames floats, channel c at in + c * numFrames.
+ * @param accum  numSlots meter accumulators fed with the samples before
+ *               clipping, or NULL.
+ */
+void hAi_writeS16(hv_int16_t *out, hv_uint32_t numSlots, const float *in, hv_uint32_t numChannels, hv_uint32_t numFrames,
+    HvMeterAccum *accum);
+
+/**
+ * As hAi_writeS16(), into the upper bits of 32-bit slots.
+ */
+void hAi_writeS32(hv_int32_t *out, hv_uint32_t numSlots, const float *in, hv_uint32_t numChannels, hv_uint32_t numFrames,
+    HvMeterAccum *accum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_AUDIO_IO_H_
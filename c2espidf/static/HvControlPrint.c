@@ -0,0 +1,26 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvControlPrint.h"
+
+void cPrint_onMessage(HeavyContextInterface *_c, const HvMessage *m, const char *name) {
+  // with a print queue, the audio thread only copies the message
+  if (hv_getPrintHook(_c) != NULL && !hv_queuePrint(_c, name, m)) {
+    char s[HV_PRINT_STRING_SIZE]; // longer messages are truncated
+    msg_toStringBuf(m, s, sizeof(s));
+    hv_getPrintHook(_c)(_c, name, s, m);
+  }
+}
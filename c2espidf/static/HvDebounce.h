@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_DEBOUNCE_H_
+#define _HEAVY_DEBOUNCE_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Debounces buttons from timestamped edges. An interrupt handler records each
+ * edge with hDb_pushEdge() into a single-producer, single-consumer ring. The
+ * task calls hDb_process() to drain it and run the per-button state machine:
+ * - A stable button that changes is reported at once, with the time of the
+ *   edge. It then settles, and edges are collected but not reported.
+ * - Settling ends when there has been no edge for the debounce period. If the
+ *   level is then not the one reported, the change is reported with the time
+ *   of the last edge.
+ * A press therefore costs no latency, and a bounce shows up as one change.
+ * Times are in any unit, as long as edges and the period use the same one.
+ *
+ * There is nothing platform-specific here, so the state machine can be run on
+ * a host from a simulated edge source.
+ */
+typedef struct HvDebounceEdge {
+  hv_int64_t time;
+  hv_uint32_t button;
+  hv_uint32_t level;
+} HvDebounceEdge;
+
+typedef struct HvDebounceButton {
+  hv_int64_t deadline; // end of settling, if settling
+  hv_int64_t lastTime; // time of the last edge while settling
+  hv_uint8_t level;    // last reported level
+  hv_uint8_t lastLevel;
+  hv_uint8_t settling;
+} HvDebounceButton;
+
+typedef struct HvDebounce {
+  HvDebounceEdge *ring;
+  hv_uint32_t mask;    // capacity minus one, the capacity is a power of two
+  hv_uint32_t head;    // edges pushed, written by the producer only
+  hv_uint32_t tail;    // edges drained, written by the consumer only
+  hv_uint32_t dropped; // edges the ring had no room for
+  HvDebounceButton *buttons;
+  hv_uint32_t numButtons;
+  hv_int64_t period;
+} HvDebounce;
+
+// returned by hDb_process() when no button is settling
+#define HV_DEBOUNCE_IDLE (-1)
+
+/**
+ * Called by hDb_process() for each debounced change, in the order of the edges
+ * of each button.
+ */
+typedef void (HvDebounceHook_t)(void *user, hv_uint32_t button, hv_uint32_t level, hv_int64_t time);
+
+/**
+ * Initialise the debouncer. All buttons start stable at level 0.
+ *
+ * @param numEdges  Capacity of the edge ring, rounded up to a power of two.
+ * @param period  How long a button must be quiet to be stable again.
+ * @return  Returns the capacity of the ring.
+ */
+hv_uint32_t hDb_init(HvDebounce *o, hv_uint32_t numButtons, hv_uint32_t numEdges, hv_int64_t period);
+
+void hDb_free(HvDebounce *o);
+
+/**
+ * Sets the stable level of a button without reporting it, e.g. from the pin
+ * level at startup. Only the consumer may call this.
+ */
+void hDb_setLevel(HvDebounce *o, hv_uint32_t button, hv_uint32_t level);
+
+/**
+ * Records an edge. Only one thread or interrupt handler may push at a time; it
+ * never blocks and is safe to call from an ISR.
+ *
+ * @return  False if the ring is full and the edge was dropped. A dropped edge
+ *          is only lost if it was the last one of a burst.
+ */
+static inline bool hDb_pushEdge(HvDebounce *o, hv_uint32_t button, hv_uint32_t level, hv_int64_t time) {
+  const hv_uint32_t head = o->head;
+  // acquire pairs with hDb_process(), so the slot is drained before it is reused
+  if (head - __atomic_load_n(&o->tail, __ATOMIC_ACQUIRE) > o->mask) {
+    __atomic_store_n(&o->dropped, o->dropped + 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  HvDebounceEdge *e = o->ring + (head & o->mask);
+  e->time = time;
+  e->button = button;
+  e->level = level ? 1 : 0;
+  __atomic_store_n(&o->head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+/**
+ * Drains the edge ring and ends the settling of buttons whose period has
+ * passed at time now, reporting changes to the hook. Only the consumer may
+ * call this.
+ *
+ * @return  The time at which a settling button has to be looked at again, or
+ *          HV_DEBOUNCE_IDLE if none is settling and only a new edge matters.
+ */
+hv_int64_t hDb_process(HvDebounce *o, hv_int64_t now, HvDebounceHook_t *hook, void *user);
+
+/**
+ * Returns the number of edges dropped because the ring was full.
+ */
+static inline hv_uint32_t hDb_getDroppedCount(HvDebounce *o) {
+  return __atomic_load_n(&o->dropped, __ATOMIC_RELAXED);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_DEBOUNCE_H_
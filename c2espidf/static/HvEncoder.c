@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvEncoder.h"
+
+void hEn_init(HvEncoder *o, hv_int32_t count, hv_int64_t time, hv_int32_t countsPerDetent,
+    float threshold, float acceleration, float maxGain) {
+  o->count = count;
+  o->remainder = 0;
+  o->countsPerDetent = (countsPerDetent > 0) ? countsPerDetent : 1;
+  o->time = time;
+  o->velocity = 0.0f;
+  o->threshold = threshold;
+  o->acceleration = acceleration;
+  o->maxGain = (maxGain > 1.0f) ? maxGain : 1.0f;
+}
+
+float hEn_update(HvEncoder *o, hv_int32_t count, hv_int64_t time) {
+  // unsigned difference, so that a wrapped counter still gives the right step
+  o->remainder += (hv_int32_t) ((hv_uint32_t) count - (hv_uint32_t) o->count);
+  o->count = count;
+  const hv_int32_t detents = o->remainder / o->countsPerDetent; // truncates towards zero
+  o->remainder -= detents * o->countsPerDetent;
+
+  if (detents == 0) return 0.0f;
+
+  // the rate is measured over the time since the last detent, so that slow
+  // turns read as slow however often the counter is polled
+  const float dt = (float) (time - o->time) * 1e-6f;
+  o->time = time;
+  if (dt > 0.0f) {
+    const float v = (float) detents / dt;
+    if (v * o->velocity < 0.0f) o->velocity = 0.0f; // reversed
+    o->velocity += (v - o->velocity) * (dt / (dt + HV_ENCODER_SMOOTHING));
+  }
+  const float speed = hv_abs_f(o->velocity);
+  float gain = 1.0f;
+  if (speed > o->threshold) {
+    gain += (speed - o->threshold) * o->acceleration;
+    if (gain > o->maxGain) gain = o->maxGain;
+  }
+  return (float) detents * gain;
+}
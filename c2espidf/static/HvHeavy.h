@@ -0,0 +1,626 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_H_
+#define _HEAVY_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef _HEAVY_DECLARATIONS_
+#define _HEAVY_DECLARATIONS_
+
+#ifdef __cplusplus
+class HeavyContextInterface;
+#else
+typedef struct HeavyContextInterface HeavyContextInterface;
+#endif
+
+typedef struct HvMessage HvMessage;
+
+typedef enum {
+  HV_PARAM_TYPE_PARAMETER_IN,
+  HV_PARAM_TYPE_PARAMETER_OUT,
+  HV_PARAM_TYPE_EVENT_IN,
+  HV_PARAM_TYPE_EVENT_OUT
+} HvParameterType;
+
+typedef struct HvParameterInfo {
+  const char *name;     // the human readable parameter name
+  hv_uint32_t hash;     // an integer identified used by heavy for this parameter
+  HvParameterType type; // type of this parameter
+  float minVal;         // the minimum value of this parameter
+  float maxVal;         // the maximum value of this parameter
+  float defaultVal;     // the default value of this parameter
+} HvParameterInfo;
+
+typedef void (HvSendHook_t) (HeavyContextInterface *context, const char *sendName, hv_uint32_t sendHash, const HvMessage *msg);
+typedef void (HvPrintHook_t) (HeavyContextInterface *context, const char *printName, const char *str, const HvMessage *msg);
+
+// Receiver index meaning "address the receiver by its hash instead"
+#define HV_RECEIVER_INDEX_NONE 0xFFFFFFFF
+
+typedef struct HvEvent {
+  hv_uint32_t receiverHash;  // used when receiverIndex is HV_RECEIVER_INDEX_NONE
+  hv_uint32_t receiverIndex; // dense receiver index, e.g. HV_HEAVY_RECEIVER_INDEX_KNOB1
+  const HvMessage *msg;      // copied into the input queue
+  hv_uint64_t sample;        // absolute sample time to process the event at, 0 for the next block
+} HvEvent;
+
+typedef void (HvSendCallback_t) (HeavyContextInterface *context, hv_uint32_t sendHash, const HvMessage *msg, void *userData);
+
+#endif // _HEAVY_DECLARATIONS_
+
+
+
+#if HV_APPLE
+#pragma mark - Heavy Context
+#endif
+
+/** Deletes a patch instance. */
+void hv_delete(HeavyContextInterface *c);
+
+
+
+#if HV_APPLE
+#pragma mark - Heavy Process
+#endif
+
+/**
+ * Processes one block of samples for a patch instance. The buffer format is an array of float channel arrays.
+ * If the context has not input or output channels, the respective argument may be NULL.
+ * The number of samples to to tbe processed should be a multiple of 1, 4, or 8, depending on if
+ * no, SSE or NEON, or AVX optimisation is being used, respectively.
+ * e.g. [[LLLL][RRRR]]
+ * This function support in-place processing.
+ *
+ * @return  The number of samples processed.
+ *
+ * This function is NOT thread-safe. It is assumed that only the audio thread will execute this function.
+ */
+int hv_process(HeavyContextInterface *c, float **inputBuffers, float **outputBuffers, int n);
+
+/**
+ * Processes one block of samples for a patch instance. The buffer format is an uninterleaved float array of channels.
+ * If the context has not input or output channels, the respective argument may be NULL.
+ * The number of samples to to tbe processed should be a multiple of 1, 4, or 8, depending on if
+ * no, SSE or NEON, or AVX optimisation is being used, respectively.
+ * e.g. [LLLLRRRR]
+ * This function support in-place processing.
+ *
+ * @return  The number of samples processed.
+ *
+ * This function is NOT thread-safe. It is assumed that only the audio thread will execute this function.
+ */
+int hv_processInline(HeavyContextInterface *c, float *inputBuffers, float *outputBuffers, int n);
+
+/**
+ * Processes one block of samples for a patch instance. The buffer format is an interleaved float array of channels.
+ * If the context has not input or output channels, the respective argument may be NULL.
+ * The number of samples to to tbe processed should be a multiple of 1, 4, or 8, depending on if
+ * no, SSE or NEON, or AVX optimisation is being used, respectively.
+ * e.g. [LRLRLRLR]
+ * This function support in-place processing.
+ *
+ * @return  The number of samples processed.
+ *
+ * This function is NOT thread-safe. It is assumed that only the audio thread will execute this function.
+ */
+int hv_processInlineInterleaved(HeavyContextInterface *c, float *inputBuffers, float *outputBuffers, int n);
+
+
+
+#if HV_APPLE
+#pragma mark - Heavy Common
+#endif
+
+/**
+ * Returns the total size in bytes of the context.
+ * This value may change if tables are resized.
+ */
+int hv_getSize(HeavyContextInterface *c);
+
+/** Returns the sample rate with which this context has been configured. */
+double hv_getSampleRate(HeavyContextInterface *c);
+
+/** Returns the number of input channels with which this context has been configured. */
+int hv_getNumInputChannels(HeavyContextInterface *c);
+
+/** Returns the number of output channels with which this context has been configured. */
+int hv_getNumOutputChannels(HeavyContextInterface *c);
+
+/** Set the print hook. The function is called whenever a message is sent to a print object. */
+void hv_setPrintHook(HeavyContextInterface *c, HvPrintHook_t *f);
+
+/** Returns the print hook, or NULL. */
+HvPrintHook_t *hv_getPrintHook(HeavyContextInterface *c);
+
+/**
+ * Set the send hook. The function is called whenever a message is sent to any send object.
+ * Messages returned by this function should NEVER be freed. If the message must persist, call
+ * hv_msg_copy() first.
+ */
+void hv_setSendHook(HeavyContextInterface *c, HvSendHook_t *f);
+
+/** Returns a 32-bit hash of any string. Returns 0 if string is NULL. */
+hv_uint32_t hv_stringToHash(const char *s);
+
+/**
+ * A convenience function to send a bang to a receiver to be processed immediately.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendBangToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash);
+
+/**
+ * A convenience function to send a float to a receiver to be processed immediately.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendFloatToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, const float x);
+
+/**
+ * A convenience function to send a symbol to a receiver to be processed immediately.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendSymbolToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, char *s);
+
+/**
+ * Sends a formatted message to a receiver that can be scheduled for the future.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendMessageToReceiverV(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, const char *format, ...);
+
+/**
+ * Sends a fixed formatted message of two floats to a receiver that can be scheduled for the future.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendMessageToReceiverFF(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, float data1, float data2);
+
+/**
+ * Sends a fixed formatted message of three floats to a receiver that can be scheduled for the future.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendMessageToReceiverFFF(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, float data1, float data2, float data3);
+
+/**
+ * Sends a message to a receiver that can be scheduled for the future.
+ * The receiver is addressed with its hash, which can also be determined using hv_stringToHash().
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue to be processed this block.
+ */
+bool hv_sendMessageToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, HvMessage *m);
+
+/**
+ * Sends a message to a receiver addressed by its dense index rather than its hash.
+ * Receiver indices are generated into the patch header, e.g. HV_HEAVY_RECEIVER_INDEX_KNOB1,
+ * and dispatch through a table instead of searching the receiver hashes.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the index is out of range or
+ *          the message could not fit onto the message queue to be processed this block.
+ */
+bool hv_sendMessageToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, float delayMs, HvMessage *m);
+
+/**
+ * A convenience function to send a bang to a receiver addressed by its index.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted.
+ */
+bool hv_sendBangToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex);
+
+/**
+ * A convenience function to send a float to a receiver addressed by its index.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted.
+ */
+bool hv_sendFloatToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, const float x);
+
+/**
+ * A convenience function to send a symbol to a receiver addressed by its index.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted.
+ */
+bool hv_sendSymbolToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, char *s);
+
+/**
+ * Sends several messages, each processed at its event's sample time or at the start of
+ * the next block if that time has passed. Space in the input queue is reserved once and
+ * all accepted events are published together with one fence.
+ * This function is thread-safe.
+ *
+ * @return  The number of leading events that were accepted. Events from that position on
+ *          were not sent, either because the input queue is full or because the event
+ *          names an invalid receiver index.
+ */
+int hv_sendBatch(HeavyContextInterface *c, const HvEvent *events, int numEvents);
+
+/**
+ * Sends a message to be processed at an absolute sample time, e.g. one returned by
+ * hv_timeToSample(). A time that has already passed is processed at the start of the
+ * next block. Internally times wrap every 2^32 samples, so the sample should be within
+ * 2^31 samples (about 12 hours at 48kHz) of the current time. This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue.
+ */
+bool hv_sendMessageAtSample(HeavyContextInterface *c, hv_uint32_t receiverHash, hv_uint64_t sample, HvMessage *m);
+
+/**
+ * Records the host time, in microseconds of any monotonic clock (e.g. esp_timer_get_time()
+ * or CLOCK_MONOTONIC), at which the next block to be processed starts. Call it from the
+ * audio thread before each hv_process*(), at a point paced by the audio hardware.
+ */
+void hv_setSampleClock(HeavyContextInterface *c, hv_int64_t timeUs);
+
+/**
+ * Converts a host time from the clock given to hv_setSampleClock() into an absolute
+ * sample time, so that producers can timestamp events when they are captured.
+ * Returns 0, i.e. the next block, before the first hv_setSampleClock() call.
+ * This function is thread-safe.
+ */
+hv_uint64_t hv_timeToSample(HeavyContextInterface *c, hv_int64_t timeUs);
+
+/**
+ * Cancels a previously scheduled message.
+ *
+ * @param sendMessage  May be NULL.
+ */
+void hv_cancelMessage(HeavyContextInterface *c, HvMessage *m, void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *));
+
+/** Returns the read-only user-assigned name of this patch. */
+const char *hv_getName(HeavyContextInterface *c);
+
+/** Sets a user-definable value. This value is never manipulated by Heavy. */
+void hv_setUserData(HeavyContextInterface *c, void *userData);
+
+/** Returns the user-defined data. */
+void *hv_getUserData(HeavyContextInterface *c);
+
+/** Returns the current patch time in milliseconds. This value may have rounding errors. */
+double hv_getCurrentTime(HeavyContextInterface *c);
+
+/** Returns the current patch time in samples. This value is always exact. */
+hv_uint32_t hv_getCurrentSample(HeavyContextInterface *c);
+
+/**
+ * Returns information about each parameter such as name, hash, and range.
+ * The total number of parameters is always returned.
+ *
+ * @param index  The parameter index.
+ * @param info  A pointer to a HvParameterInfo struct. May be null.
+ *
+ * @return  The total number of parameters.
+ */
+int hv_getParameterInfo(HeavyContextInterface *c, int index, HvParameterInfo *info);
+
+/**
+ * Sets an input parameter, addressed by its hv_getParameterInfo() index, e.g.
+ * HV_HEAVY_PARAM_INDEX_KNOB1. The value is an atomic store, and the first store since the
+ * last delivery queues a marker for it. The latest value is sent to the parameter's
+ * receiver where the marker was queued, so it keeps its order with the messages sent
+ * before and after it, unless the receiver already got the same value from the bank and
+ * no other message since (the first store is always sent). Intermediate values stored
+ * before the marker is reached are not seen by the patch.
+ * This function is thread-safe and lock-free.
+ *
+ * @return  False if the index does not name an input parameter, the value is NaN, or
+ *          the input queue has no room for the marker.
+ */
+bool hv_setParameterValue(HeavyContextInterface *c, int index, float value);
+
+/**
+ * Makes a receiver, addressed by its index, latest-wins: a float sent to it without delay,
+ * while an earlier one is still pending, replaces that float instead of queueing behind it.
+ * The float that found nothing pending holds a place in the input queue, and the latest one
+ * is delivered there, so it keeps its order with the messages sent before and after it.
+ * Bangs, symbols, lists, delayed and batched messages keep going through the input queue
+ * in order. This bounds queue growth for controls that are scanned faster than they matter.
+ * A float still pending when it is switched off is delivered in its place all the same.
+ * This function is thread-safe and lock-free.
+ *
+ * @return  False if the index is out of range.
+ */
+bool hv_setReceiverLatestWins(HeavyContextInterface *c, hv_uint32_t receiverIndex, bool latestWins);
+
+/** */
+float hv_samplesToMilliseconds(HeavyContextInterface *c, hv_uint32_t numSamples);
+
+/** Converts milliseconds to samples. Input is limited to non-negative range. */
+hv_uint32_t hv_millisecondsToSamples(HeavyContextInterface *c, float ms);
+
+/**
+ * Does nothing: the input message queue is lock-free, and there is no lock to
+ * acquire. Kept for compatibility with code written for the stock runtime.
+ *
+ * @param c  A Heavy context.
+ */
+void hv_lock_acquire(HeavyContextInterface *c);
+
+/**
+ * Does nothing, see hv_lock_acquire().
+ *
+ * @param c  A Heavy context.
+ *
+ * @return Always true.
+ */
+bool hv_lock_try(HeavyContextInterface *c);
+
+/**
+ * Does nothing, see hv_lock_acquire().
+ *
+ * @param c  A Heavy context.
+ */
+void hv_lock_release(HeavyContextInterface *c);
+
+/**
+ * Set the size of the input message queue in kilobytes.
+ *
+ * The buffer is reset and all existing contents are lost on resize.
+ *
+ * @param c  A Heavy context.
+ * @param inQueueKb  Must be positive i.e. at least one.
+ */
+void hv_setInputMessageQueueSize(HeavyContextInterface *c, hv_uint32_t inQueueKb);
+
+/**
+ * Set the size of the output message queue in kilobytes.
+ *
+ * The buffer is reset and all existing contents are lost on resize.
+ * Only the default sendhook uses the outgoing message queue. If the default
+ * sendhook is not being used, then this function is not useful.
+ *
+ * @param c  A Heavy context.
+ * @param outQueueKb  Must be postive i.e. at least one.
+ */
+void hv_setOutputMessageQueueSize(HeavyContextInterface *c, hv_uint32_t outQueueKb);
+
+/**
+ * Get the next message in the outgoing queue, will also consume the message.
+ * Returns false if there are no messages.
+ *
+ * @param c  A Heavy context.
+ * @param destinationHash  a hash of the name of the receiver the message was sent to.
+ * @param outMsg  message pointer that is filled by the next message contents.
+ * @param msgLength  length of outMsg in bytes.
+ *
+ * @return  True if there is a message in the outgoing queue.
+*/
+bool hv_getNextSentMessage(HeavyContextInterface *c, hv_uint32_t *destinationHash, HvMessage *outMsg, hv_uint32_t msgLength);
+
+/**
+ * Registers a callback for messages sent to a send of the patch, e.g.
+ * HV_HEAVY_SEND_METER. Once any callback is registered, the default send hook
+ * drops messages to sends without one instead of queueing them, and
+ * hv_dispatchSentMessages() takes the place of hv_getNextSentMessage().
+ * Requires an outgoing message queue (see hv_<name>_new_with_options()).
+ * Register callbacks before another thread starts dispatching.
+ *
+ * @param c  A Heavy context.
+ * @param sendHash  The hash of a send known to the patch.
+ * @param f  The callback, or NULL to unsubscribe.
+ * @param userData  Passed to the callback.
+ *
+ * @return  False if the patch has no such send or no outgoing message queue.
+ */
+bool hv_subscribeSend(HeavyContextInterface *c, hv_uint32_t sendHash, HvSendCallback_t *f, void *userData);
+
+/**
+ * Calls the registered callbacks for all queued outgoing messages and consumes
+ * them. Call this from a single low-priority thread.
+ *
+ * @param c  A Heavy context.
+ *
+ * @return  The number of callbacks made.
+ */
+int hv_dispatchSentMessages(HeavyContextInterface *c);
+
+/**
+ * Blocks until the patch queues an outgoing message or until the timeout passes.
+ * Only the dispatching thread may wait.
+ *
+ * @param c  A Heavy context.
+ * @param timeoutMs  The longest time to wait, in milliseconds.
+ *
+ * @return  True if messages were queued since the last wait.
+ */
+bool hv_waitForSentMessages(HeavyContextInterface *c, hv_uint32_t timeoutMs);
+
+/**
+ * Defers print objects to a queue of the given size, so that the audio thread
+ * only copies their messages. The print hook is then called by
+ * hv_dispatchPrints() instead of from within processing. Zero turns the queue off.
+ * Call this before processing starts.
+ *
+ * @param c  A Heavy context.
+ * @param printQueueKb  The size of the print queue in kilobytes.
+ */
+void hv_setPrintQueueSize(HeavyContextInterface *c, hv_uint32_t printQueueKb);
+
+/**
+ * Formats the queued print messages and passes them to the print hook.
+ * Call this from a single low-priority thread.
+ *
+ * @param c  A Heavy context.
+ *
+ * @return  The number of messages printed.
+ */
+int hv_dispatchPrints(HeavyContextInterface *c);
+
+/**
+ * Blocks until a print object queues a message or until the timeout passes.
+ * Only the thread calling hv_dispatchPrints() may wait.
+ *
+ * @param c  A Heavy context.
+ * @param timeoutMs  The longest time to wait, in milliseconds.
+ *
+ * @return  True if messages were queued since the last wait.
+ */
+bool hv_waitForPrints(HeavyContextInterface *c, hv_uint32_t timeoutMs);
+
+/**
+ * Returns how many print messages were dropped because the print queue was
+ * full, since the context was created.
+ *
+ * @param c  A Heavy context.
+ */
+hv_uint32_t hv_getDroppedPrintCount(HeavyContextInterface *c);
+
+
+
+#if HV_APPLE
+#pragma mark - Heavy Message
+#endif
+
+typedef struct HvMessage HvMessage;
+
+/** Returns the total size in bytes of a HvMessage with a number of elements on the heap. */
+unsigned long hv_msg_getByteSize(hv_uint32_t numElements);
+
+/** Initialise a HvMessage structure with the number of elements and a timestamp (in samples). */
+void hv_msg_init(HvMessage *m, int numElements, hv_uint32_t timestamp);
+
+/** Returns the number of elements in this message. */
+unsigned long hv_msg_getNumElements(const HvMessage *m);
+
+/** Returns the time at which this message exists (in samples). */
+hv_uint32_t hv_msg_getTimestamp(const HvMessage *m);
+
+/** Set the time at which this message should be executed (in samples). */
+void hv_msg_setTimestamp(HvMessage *m, hv_uint32_t timestamp);
+
+/** Returns true of the indexed element is a bang. False otherwise. Index is not bounds checked. */
+bool hv_msg_isBang(const HvMessage *const m, int i);
+
+/** Sets the indexed element to a bang. Index is not bounds checked. */
+void hv_msg_setBang(HvMessage *m, int i);
+
+/** Returns true of the indexed element is a float. False otherwise. Index is not bounds checked. */
+bool hv_msg_isFloat(const HvMessage *const m, int i);
+
+/** Returns the indexed element as a float value. Index is not bounds checked. */
+float hv_msg_getFloat(const HvMessage *const m, int i);
+
+/** Sets the indexed element to float value. Index is not bounds checked. */
+void hv_msg_setFloat(HvMessage *m, int i, float f);
+
+/** Returns true of the indexed element is a symbol. False otherwise. Index is not bounds checked. */
+bool hv_msg_isSymbol(const HvMessage *const m, int i);
+
+/** Returns the indexed element as a symbol value. Index is not bounds checked. */
+const char *hv_msg_getSymbol(const HvMessage *const m, int i);
+
+/** Returns true of the indexed element is a hash. False otherwise. Index is not bounds checked. */
+bool hv_msg_isHash(const HvMessage *const m, int i);
+
+/** Returns the indexed element as a hash value. Index is not bounds checked. */
+hv_uint32_t hv_msg_getHash(const HvMessage *const m, int i);
+
+/** Sets the indexed element to symbol value. Index is not bounds checked. */
+void hv_msg_setSymbol(HvMessage *m, int i, const char *s);
+
+/**
+ * Returns true if the message has the given format, in number of elements and type. False otherwise.
+ * Valid element types are:
+ * 'b': bang
+ * 'f': float
+ * 's': symbol
+ *
+ * For example, a message with three floats would have a format of "fff". A single bang is "b".
+ * A message with two symbols is "ss". These types can be mixed and matched in any way.
+ */
+bool hv_msg_hasFormat(const HvMessage *const m, const char *fmt);
+
+/**
+ * Returns a basic string representation of the message.
+ * The character array MUST be deallocated by the caller.
+ */
+char *hv_msg_toString(const HvMessage *const m);
+
+/**
+ * Writes a basic string representation of the message into buf, without
+ * allocating. The string is truncated to len-1 characters and null-terminated.
+ *
+ * @return  The length of the untruncated string.
+ */
+hv_uint32_t hv_msg_toStringBuf(const HvMessage *const m, char *buf, hv_uint32_t len);
+
+/** Copy a message onto the stack. The message persists. */
+HvMessage *hv_msg_copy(const HvMessage *const m);
+
+/** Free a copied message. */
+void hv_msg_free(HvMessage *m);
+
+
+
+#if HV_APPLE
+#pragma mark - Heavy Table
+#endif
+
+/**
+ * Resizes the table to the given length.
+ *
+ * Existing contents are copied to the new table. Remaining space is cleared
+ * if the table is longer than the original, truncated otherwise.
+ *
+ * @param tableHash  The table identifier.
+ * @param newSampleLength  The new length of the table, in samples. Must be positive.
+ *
+ * @return  False if the table could not be found. True otherwise.
+ */
+bool hv_table_setLength(HeavyContextInterface *c, hv_uint32_t tableHash, hv_uint32_t newSampleLength);
+
+/** Returns a pointer to the raw buffer backing this table. DO NOT free it. */
+float *hv_table_getBuffer(HeavyContextInterface *c, hv_uint32_t tableHash);
+
+/** Returns the length of this table in samples. */
+hv_uint32_t hv_table_getLength(HeavyContextInterface *c, hv_uint32_t tableHash);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _HEAVY_H_
@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvKnobFilter.h"
+
+void hKf_init(HvKnobFilter *o, hv_uint32_t numChannels, hv_uint32_t fullScale, float hysteresis, float deadband) {
+  const hv_uint32_t n = (numChannels > 0) ? numChannels : 1;
+  o->channels = (HvKnobFilterChannel *) hv_malloc(n * sizeof(HvKnobFilterChannel));
+  hv_assert(o->channels != NULL);
+  for (hv_uint32_t i = 0; i < n; ++i) {
+    o->channels[i].sum = 0;
+    o->channels[i].count = 0;
+    o->channels[i].value = -1.0f;
+  }
+  o->numChannels = numChannels;
+  o->scale = 1.0f / (float) fullScale;
+  o->hysteresis = hysteresis;
+  o->deadband = deadband;
+}
+
+void hKf_free(HvKnobFilter *o) {
+  hv_free(o->channels);
+}
+
+bool hKf_update(HvKnobFilter *o, hv_uint32_t channel, float *value) {
+  HvKnobFilterChannel *c = o->channels + channel;
+  if (c->count == 0) return false;
+  const float x = ((float) c->sum / (float) c->count) * o->scale;
+  c->sum = 0;
+  c->count = 0;
+
+  float v = c->value;
+  if (v < 0.0f) v = x; // the first average is taken as is
+  else if (x > v + o->hysteresis) v = x - o->hysteresis;
+  else if (x < v - o->hysteresis) v = x + o->hysteresis;
+  else return false;
+
+  if (v <= o->deadband) v = 0.0f;
+  else if (v >= 1.0f - o->deadband) v = 1.0f;
+  if (v == c->value) return false;
+  c->value = v;
+  *value = v;
+  return true;
+}
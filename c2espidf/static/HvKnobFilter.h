@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_KNOB_FILTER_H_
+#define _HEAVY_KNOB_FILTER_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Turns a stream of raw ADC samples per knob into a steady value in [0, 1].
+ * The samples a knob collects between two updates are averaged, which
+ * decimates the stream to the update rate and averages the noise down. The
+ * average then moves the value only once it is more than the hysteresis away
+ * from it, and drags it along from there, so a resting knob stops jittering.
+ * Values within the deadband of either end snap to that end, so that the ends
+ * are reachable despite the hysteresis.
+ *
+ * There is nothing platform-specific here; the driver feeds it samples.
+ */
+typedef struct HvKnobFilterChannel {
+  hv_uint32_t sum;
+  hv_uint32_t count;
+  float value; // last value reported, negative before the first one
+} HvKnobFilterChannel;
+
+typedef struct HvKnobFilter {
+  HvKnobFilterChannel *channels;
+  hv_uint32_t numChannels;
+  float scale; // one over the full-scale raw value
+  float hysteresis;
+  float deadband;
+} HvKnobFilter;
+
+/**
+ * @param fullScale  The raw value that maps to 1, e.g. 4095 for 12 bits.
+ * @param hysteresis  How far the average must move to change the value, in [0, 1].
+ * @param deadband  Values this close to 0 or 1 snap to it. Should be at least
+ *                  the hysteresis, or the ends can't be reached.
+ */
+void hKf_init(HvKnobFilter *o, hv_uint32_t numChannels, hv_uint32_t fullScale, float hysteresis, float deadband);
+
+void hKf_free(HvKnobFilter *o);
+
+/**
+ * Adds a raw sample of a knob. Up to 2^20 12-bit samples fit between updates.
+ */
+static inline void hKf_add(HvKnobFilter *o, hv_uint32_t channel, hv_uint32_t raw) {
+  HvKnobFilterChannel *c = o->channels + channel;
+  c->sum += raw;
+  c->count++;
+}
+
+/**
+ * Averages the samples added since the last update and applies the hysteresis.
+ *
+ * @param value  Filled with the new value if it moved.
+ * @return  True if the value moved, false if it did not or there were no samples.
+ */
+bool hKf_update(HvKnobFilter *o, hv_uint32_t channel, float *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_KNOB_FILTER_H_
@@ -0,0 +1,311 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvMessage.h"
+
+HvMessage *msg_init(HvMessage *m, hv_size_t numElements, hv_uint32_t timestamp) {
+  m->timestamp = timestamp;
+  m->numElements = (hv_uint16_t) numElements;
+  m->numBytes = (hv_uint16_t) msg_getCoreSize(numElements);
+  return m;
+}
+
+HvMessage *msg_initWithFloat(HvMessage *m, hv_uint32_t timestamp, float f) {
+  m->timestamp = timestamp;
+  m->numElements = 1;
+  m->numBytes = sizeof(HvMessage);
+  msg_setFloat(m, 0, f);
+  return m;
+}
+
+HvMessage *msg_initWithBang(HvMessage *m, hv_uint32_t timestamp) {
+  m->timestamp = timestamp;
+  m->numElements = 1;
+  m->numBytes = sizeof(HvMessage);
+  msg_setBang(m, 0);
+  return m;
+}
+
+HvMessage *msg_initWithSymbol(HvMessage *m, hv_uint32_t timestamp, const char *s) {
+  m->timestamp = timestamp;
+  m->numElements = 1;
+  m->numBytes = sizeof(HvMessage);
+  msg_setSymbol(m, 0, s);
+  return m;
+}
+
+HvMessage *msg_initWithInternedSymbol(HvMessage *m, hv_uint32_t timestamp, const HvSymbol *s) {
+  m->timestamp = timestamp;
+  m->numElements = 1;
+  m->numBytes = sizeof(HvMessage);
+  msg_setInternedSymbol(m, 0, s);
+  return m;
+}
+
+HvMessage *msg_initWithHash(HvMessage *m, hv_uint32_t timestamp, hv_uint32_t h) {
+  m->timestamp = timestamp;
+  m->numElements = 1;
+  m->numBytes = sizeof(HvMessage);
+  msg_setHash(m, 0, h);
+  return m;
+}
+
+void msg_copyToBuffer(const HvMessage *m, char *buffer, hv_size_t len) {
+  HvMessage *r = (HvMessage *) buffer;
+
+  hv_size_t len_r = msg_getCoreSize(msg_getNumElements(m));
+
+  // assert that the message is not already larger than the length of the buffer
+  hv_assert(len_r <= len);
+
+  // copy the message to the buffer, symbols are interned and only their pointers are copied
+  hv_memcpy(r, m, len_r);
+
+  r->numBytes = (hv_uint16_t) len_r; // update the message size in memory
+}
+
+HvMessage *msg_copy(const HvMessage *m) {
+  const hv_uint32_t heapSize = msg_getSize(m);
+  char *r = (char *) hv_malloc(heapSize);
+  hv_assert(r != NULL);
+  msg_copyToBuffer(m, r, heapSize);
+  return (HvMessage *) r;
+}
+
+void msg_free(HvMessage *m) {
+  hv_free(m); // because heap messages are serialised in memory, a simple call to free releases the message
+}
+
+bool msg_hasFormat(const HvMessage *m, const char *fmt) {
+  hv_assert(fmt != NULL);
+  const int n = msg_getNumElements(m);
+  for (int i = 0; i < n; ++i) {
+    switch (fmt[i]) {
+      case 'b': if (!msg_isBang(m, i)) return false; break;
+      case 'f': if (!msg_isFloat(m, i)) return false; break;
+      case 'h': if (!msg_isHash(m, i)) return false; break;
+      case 's': if (!msg_isSymbol(m, i)) return false; break;
+      default: return false;
+    }
+  }
+  return (fmt[n] == '\0');
+}
+
+bool msg_compareSymbol(const HvMessage *m, int i, const char *s) {
+  switch (msg_getType(m,i)) {
+    case HV_MSG_SYMBOL: {
+      const HvSymbol *sym = msg_getInternedSymbol(m,i);
+      return (sym->hash == hv_string_to_hash(s)) && !hv_strcmp(sym->str, s);
+    }
+    case HV_MSG_HASH: return (msg_getHash(m,i) == hv_string_to_hash(s));
+    default: return false;
+  }
+}
+
+bool msg_equalsElement(const HvMessage *m, int i_m, const HvMessage *n, int i_n) {
+  if (i_m < msg_getNumElements(m) && i_n < msg_getNumElements(n)) {
+    if (msg_getType(m, i_m) == msg_getType(n, i_n)) {
+      switch (msg_getType(m, i_m)) {
+        case HV_MSG_BANG: return true;
+        case HV_MSG_FLOAT: return (msg_getFloat(m, i_m) == msg_getFloat(n, i_n));
+        case HV_MSG_SYMBOL: return msg_getInternedSymbol(m, i_m) == msg_getInternedSymbol(n, i_n);
+        case HV_MSG_HASH: return msg_getHash(m,i_m) == msg_getHash(n,i_n);
+        default: break;
+      }
+    }
+  }
+  return false;
+}
+
+void msg_setElementToFrom(HvMessage *n, int i_n, const HvMessage *const m, int i_m) {
+  switch (msg_getType(m, i_m)) {
+    case HV_MSG_BANG: msg_setBang(n, i_n); break;
+    case HV_MSG_FLOAT: msg_setFloat(n, i_n, msg_getFloat(m, i_m)); break;
+    case HV_MSG_SYMBOL: msg_setInternedSymbol(n, i_n, msg_getInternedSymbol(m, i_m)); break;
+    case HV_MSG_HASH: msg_setHash(n, i_n, msg_getHash(m, i_m));
+    default: break;
+  }
+}
+
+hv_uint32_t msg_getHash(const HvMessage *const m, int i) {
+  hv_assert(i < msg_getNumElements(m)); // invalid index
+  switch (msg_getType(m,i)) {
+    case HV_MSG_BANG: return 0xFFFFFFFF;
+    case HV_MSG_FLOAT: {
+      union { float f; hv_uint32_t u; } fhash;
+      fhash.f = msg_getFloat(m,i);
+      return fhash.u;
+    }
+    case HV_MSG_SYMBOL: return msg_getInternedSymbol(m,i)->hash;
+    case HV_MSG_HASH: return msg_getData(m,i)->h;
+    default: return 0;
+  }
+}
+
+// Returns round(v * 2^e * 10^k), rounding half to even like printf. v is kept as
+// wide as possible while scaling, so only exponents far outside the 6 printed
+// digits lose any precision, and none is lost for k between 0 and 9.
+static hv_uint64_t msg_scaleToDigits(hv_uint64_t v, int e, int k) {
+  for (; k > 0; --k) {
+    while (v > 0x1999999999999999ULL) { v >>= 1; ++e; } // room for * 10
+    v *= 10;
+  }
+  for (; k < 0; ++k) {
+    while (v < 0x8000000000000000ULL) { v <<= 1; --e; }
+    v /= 10;
+  }
+  if (e >= 0) return (e < 64 && (v >> (63 - e)) == 0) ? (v << e) : ~(hv_uint64_t) 0;
+  const int s = -e;
+  if (s > 63) return 0;
+  const hv_uint64_t q = v >> s;
+  const hv_uint64_t r = v - (q << s);
+  const hv_uint64_t half = (hv_uint64_t) 1 << (s-1);
+  return q + ((r > half || (r == half && (q & 1))) ? 1 : 0);
+}
+
+// Writes f like printf("%g") does (6 significant digits) into buf, which must
+// hold 16 characters, and returns the length. Uses integer arithmetic only.
+static int msg_formatFloat(float f, char *buf) {
+  int n = 0;
+  union { float f; hv_uint32_t u; } x = { f };
+  if (x.u >> 31) buf[n++] = '-';
+  x.u &= 0x7FFFFFFF;
+  if (x.u >= 0x7F800000) {
+    hv_memcpy(buf+n, (x.u == 0x7F800000) ? "inf" : "nan", 3);
+    return n+3;
+  }
+  if (x.u == 0) {
+    buf[n++] = '0';
+    return n;
+  }
+
+  // |f| = m * 2^e exactly
+  const hv_uint64_t m = (x.u & 0x7FFFFF) | ((x.u >> 23) ? 0x800000 : 0);
+  const int e = (int) ((x.u >> 23) ? (x.u >> 23) : 1) - 150;
+
+  // estimate the decimal exponent from the binary one (78913/2^18 ~ log10(2)),
+  // then correct it until there are exactly 6 digits
+  int top = 0;
+  while ((m >> (top+1)) != 0) ++top;
+  const int b = (e + top) * 78913;
+  int exp10 = (b >= 0) ? (b >> 18) : -((-b + (1 << 18) - 1) >> 18);
+  hv_uint64_t digits = 0;
+  for (int i = 0; i < 4; ++i) {
+    digits = msg_scaleToDigits(m, e, 5 - exp10);
+    if (digits >= 1000000) ++exp10;
+    else if (digits < 100000) --exp10;
+    else break;
+  }
+
+  char d[6];
+  for (int i = 5; i >= 0; --i) {
+    d[i] = (char) ('0' + (int) (digits % 10));
+    digits /= 10;
+  }
+  int numDigits = 6;
+  while (numDigits > 1 && d[numDigits-1] == '0') --numDigits;
+
+  if (exp10 < -4 || exp10 >= 6) {
+    buf[n++] = d[0];
+    if (numDigits > 1) {
+      buf[n++] = '.';
+      for (int i = 1; i < numDigits; ++i) buf[n++] = d[i];
+    }
+    buf[n++] = 'e';
+    buf[n++] = (exp10 < 0) ? '-' : '+';
+    int ex = (exp10 < 0) ? -exp10 : exp10;
+    if (ex >= 10) {
+      buf[n++] = (char) ('0' + ex/10);
+      ex %= 10;
+    } else {
+      buf[n++] = '0';
+    }
+    buf[n++] = (char) ('0' + ex);
+  } else if (exp10 >= 0) {
+    for (int i = 0; i <= exp10; ++i) buf[n++] = d[i];
+    if (numDigits > exp10+1) {
+      buf[n++] = '.';
+      for (int i = exp10+1; i < numDigits; ++i) buf[n++] = d[i];
+    }
+  } else {
+    buf[n++] = '0';
+    buf[n++] = '.';
+    for (int i = -1; i > exp10; --i) buf[n++] = '0';
+    for (int i = 0; i < numDigits; ++i) buf[n++] = d[i];
+  }
+  return n;
+}
+
+void msg_format(const HvMessage *m, HvMessageWriter_t *writer, void *userData) {
+  char buf[16];
+  for (int i = 0; i < msg_getNumElements(m); i++) {
+    if (i > 0) writer(userData, " ", 1);
+    switch (msg_getType(m, i)) {
+      case HV_MSG_BANG: writer(userData, "bang", 4); break;
+      case HV_MSG_FLOAT: writer(userData, buf, (hv_size_t) msg_formatFloat(msg_getFloat(m, i), buf)); break;
+      case HV_MSG_SYMBOL: {
+        const char *s = msg_getSymbol(m, i);
+        writer(userData, s, hv_strlen(s));
+        break;
+      }
+      case HV_MSG_HASH: {
+        static const char hex[] = "0123456789ABCDEF";
+        const hv_uint32_t h = msg_getHash(m, i);
+        int n = 0;
+        buf[n++] = '0';
+        buf[n++] = 'x';
+        int shift = 28;
+        while (shift > 0 && ((h >> shift) & 0xF) == 0) shift -= 4; // like "%X", no leading zeros
+        for (; shift >= 0; shift -= 4) buf[n++] = hex[(h >> shift) & 0xF];
+        writer(userData, buf, (hv_size_t) n);
+        break;
+      }
+      default: break;
+    }
+  }
+}
+
+typedef struct MsgStringBuf {
+  char *buf;
+  hv_size_t len;  // capacity of buf, including the terminator
+  hv_size_t size; // length of the full text so far
+} MsgStringBuf;
+
+static void msg_writeToBuf(void *userData, const char *str, hv_size_t len) {
+  MsgStringBuf *b = (MsgStringBuf *) userData;
+  if (b->size+1 < b->len) {
+    const hv_size_t n = hv_min_ui((hv_uint32_t) len, (hv_uint32_t) (b->len - 1 - b->size));
+    hv_memcpy(b->buf + b->size, str, n);
+  }
+  b->size += len;
+}
+
+hv_size_t msg_toStringBuf(const HvMessage *m, char *buf, hv_size_t len) {
+  MsgStringBuf b = { buf, len, 0 };
+  msg_format(m, &msg_writeToBuf, &b);
+  if (len > 0) buf[hv_min_ui((hv_uint32_t) b.size, (hv_uint32_t) (len - 1))] = '\0';
+  return b.size;
+}
+
+char *msg_toString(const HvMessage *m) {
+  hv_assert(msg_getNumElements(m) > 0);
+  // the final buffer we will pass back - user should free it
+  const hv_size_t size = msg_toStringBuf(m, NULL, 0) + 1;
+  char *finalString = (char *) hv_malloc(size*sizeof(char));
+  hv_assert(finalString != NULL);
+  msg_toStringBuf(m, finalString, size);
+  return finalString;
+}
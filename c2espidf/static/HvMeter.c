@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvMeter.h"
+
+void hMe_init(HvMeter *o, hv_uint32_t numChannels, hv_uint32_t window, hv_uint32_t numPoints, hv_uint32_t decimation) {
+  hv_assert(numChannels > 0 && window > 0 && numPoints > 0 && decimation > 0);
+  o->numChannels = numChannels;
+  o->window = window;
+  o->frames = 0;
+  o->accum = (HvMeterAccum *) hv_malloc(numChannels * sizeof(HvMeterAccum));
+  o->levels = (HvMeterLevel *) hv_malloc(numChannels * sizeof(HvMeterLevel));
+  hv_assert(o->accum != NULL && o->levels != NULL);
+  hv_memclear(o->accum, numChannels * sizeof(HvMeterAccum));
+  hv_memclear(o->levels, numChannels * sizeof(HvMeterLevel));
+
+  o->numPoints = numPoints;
+  o->decimation = decimation;
+  o->phase = 0;
+  o->count = 0;
+  o->waited = 0;
+  o->capturing = false;
+  o->last = 0.0f;
+  o->capture = (float *) hv_malloc(numChannels * numPoints * sizeof(float));
+  o->scope = (float *) hv_malloc(numChannels * numPoints * sizeof(float));
+  hv_assert(o->capture != NULL && o->scope != NULL);
+  hv_memclear(o->scope, numChannels * numPoints * sizeof(float));
+
+  o->levelSeq = 0;
+  o->scopeSeq = 0;
+}
+
+void hMe_free(HvMeter *o) {
+  hv_free(o->scope);
+  hv_free(o->capture);
+  hv_free(o->levels);
+  hv_free(o->accum);
+}
+
+// the sequence is odd while a publish is under way
+static inline void hMe_beginWrite(hv_uint32_t *seq) {
+  __atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE); // the odd count is seen before any of the new data
+}
+
+static inline void hMe_endWrite(hv_uint32_t *seq) {
+  __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+static hv_uint32_t hMe_read(const hv_uint32_t *seq, void *out, const void *data, hv_size_t size) {
+  for (int i = 0; i < HV_METER_READ_TRIES; ++i) {
+    const hv_uint32_t s = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+    if (s & 1) continue;
+    hv_memcpy(out, data, size);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE); // the copy is done before the count is checked again
+    if (__atomic_load_n(seq, __ATOMIC_RELAXED) == s) return s >> 1;
+  }
+  return 0;
+}
+
+void hMe_addLevels(HvMeter *o, const HvMeterAccum *accum, hv_uint32_t numFrames) {
+  for (hv_uint32_t c = 0; c < o->numChannels; ++c) {
+    HvMeterAccum *a = o->accum + c;
+    a->peak = (accum[c].peak > a->peak) ? accum[c].peak : a->peak;
+    a->sumSquares += accum[c].sumSquares;
+    a->clips += accum[c].clips;
+  }
+  o->frames += numFrames;
+  if (o->frames < o->window) return;
+
+  hMe_beginWrite(&o->levelSeq);
+  for (hv_uint32_t c = 0; c < o->numChannels; ++c) {
+    HvMeterAccum *a = o->accum + c;
+    o->levels[c].peak = a->peak;
+    o->levels[c].rms = hv_sqrt_f(a->sumSquares / (float) o->frames);
+    o->levels[c].clips += a->clips;
+    a->peak = 0.0f;
+    a->sumSquares = 0.0f;
+    a->clips = 0;
+  }
+  hMe_endWrite(&o->levelSeq);
+  o->frames = 0;
+}
+
+void hMe_addScope(HvMeter *o, const float *samples, hv_uint32_t channelStride, hv_uint32_t numFrames) {
+  hv_uint32_t i = o->phase;
+  for (; i < numFrames; i += o->decimation) {
+    const float x = samples[i];
+    if (!o->capturing) {
+      // start at a rising zero crossing, or anyway once a whole snapshot went by without one
+      const bool rising = (o->last < 0.0f && x >= 0.0f);
+      o->last = x;
+      if (!rising && ++o->waited < o->numPoints) continue;
+      o->capturing = true;
+      o->count = 0;
+    }
+    for (hv_uint32_t c = 0; c < o->numChannels; ++c) {
+      o->capture[c * o->numPoints + o->count] = samples[c * channelStride + i];
+    }
+    if (++o->count == o->numPoints) {
+      hMe_beginWrite(&o->scopeSeq);
+      hv_memcpy(o->scope, o->capture, o->numChannels * o->numPoints * sizeof(float));
+      hMe_endWrite(&o->scopeSeq);
+      o->capturing = false;
+      o->waited = 0;
+      o->last = x;
+    }
+  }
+  o->phase = i - numFrames;
+}
+
+hv_uint32_t hMe_readLevels(const HvMeter *o, HvMeterLevel *out) {
+  return hMe_read(&o->levelSeq, out, o->levels, o->numChannels * sizeof(HvMeterLevel));
+}
+
+hv_uint32_t hMe_readScope(const HvMeter *o, float *out) {
+  return hMe_read(&o->scopeSeq, out, o->scope, o->numChannels * o->numPoints * sizeof(float));
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_METER_H_
+#define _HEAVY_METER_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Output meters and a scope, fed from the loop that converts the patch's output
+ * for the DAC so that they cost no DSP in the patch and no messages.
+ *
+ * The audio side adds each sample to an HvMeterAccum and hands the block's
+ * accumulators and samples over once per block. Every window of frames it
+ * publishes per channel the peak, the RMS and the running count of clipped
+ * samples. The scope keeps every decimation-th frame and publishes a snapshot
+ * of numPoints frames, started at a rising zero crossing of the first channel
+ * when there is one.
+ *
+ * Both are published under a sequence lock: the audio side never waits, and a
+ * reader on another core copies them and tries again if a publish overlapped
+ * the copy. A reader that keeps losing gives up instead of spinning, so one that
+ * preempts the audio task mid-publish can't stall it.
+ *
+ * There is nothing platform-specific here, so it can be driven on a host.
+ */
+#define HV_METER_READ_TRIES 8
+
+typedef struct HvMeterAccum {
+  float peak;       // largest magnitude
+  float sumSquares;
+  hv_uint32_t clips; // samples beyond full scale
+} HvMeterAccum;
+
+typedef struct HvMeterLevel {
+  float peak;        // over the last window, may exceed 1
+  float rms;         // over the last window
+  hv_uint32_t clips; // since hMe_init()
+} HvMeterLevel;
+
+typedef struct HvMeter {
+  // audio side
+  hv_uint32_t numChannels;
+  hv_uint32_t window;     // frames per published level
+  hv_uint32_t frames;     // frames accumulated in the current window
+  HvMeterAccum *accum;    // per channel, over the current window
+  hv_uint32_t numPoints;
+  hv_uint32_t decimation;
+  hv_uint32_t phase;      // frames to skip in the next block before the next point
+  hv_uint32_t count;      // points captured of the snapshot, 0 while waiting for a trigger
+  hv_uint32_t waited;     // points waited for a trigger
+  bool capturing;
+  float last;             // previous point of the first channel, for the trigger
+  float *capture;         // numChannels x numPoints, being captured
+
+  // published, behind the sequence counters
+  hv_uint32_t levelSeq;
+  HvMeterLevel *levels;   // per channel
+  hv_uint32_t scopeSeq;
+  float *scope;           // numChannels x numPoints
+} HvMeter;
+
+/**
+ * @param window      Frames per published level, e.g. 50 ms worth.
+ * @param numPoints   Frames per scope snapshot.
+ * @param decimation  Frames per scope point.
+ */
+void hMe_init(HvMeter *o, hv_uint32_t numChannels, hv_uint32_t window, hv_uint32_t numPoints, hv_uint32_t decimation);
+
+void hMe_free(HvMeter *o);
+
+static inline void hMe_accumulate(HvMeterAccum *a, float x) {
+  const float m = (x < 0.0f) ? -x : x;
+  a->peak = (m > a->peak) ? m : a->peak;
+  a->sumSquares += x * x;
+  a->clips += (m > 1.0f);
+}
+
+/**
+ * Adds the accumulators of a block, one per channel, and publishes the levels
+ * when a window is complete. Called by the audio side only.
+ */
+void hMe_addLevels(HvMeter *o, const HvMeterAccum *accum, hv_uint32_t numFrames);
+
+/**
+ * Feeds the scope from a block of non-interleaved samples, channel c starting
+ * at samples + c * channelStride. A channelStride of 0 repeats the first
+ * channel. Called by the audio side only.
+ */
+void hMe_addScope(HvMeter *o, const float *samples, hv_uint32_t channelStride, hv_uint32_t numFrames);
+
+/**
+ * Copies the levels of all channels into out.
+ *
+ * @return  The number of windows published so far, or 0 if there is nothing
+ *          yet or no consistent copy was made within HV_METER_READ_TRIES tries.
+ */
+hv_uint32_t hMe_readLevels(const HvMeter *o, HvMeterLevel *out);
+
+/**
+ * Copies the last scope snapshot, numChannels x numPoints, into out.
+ *
+ * @return  The number of snapshots published so far, or 0 as for hMe_readLevels().
+ */
+hv_uint32_t hMe_readScope(const HvMeter *o, float *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_METER_H_
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvMidiParser.h"
+
+void hMi_init(HvMidiParser *o) {
+  o->status = 0;
+  o->data1 = 0;
+  o->count = 0;
+}
+
+// data bytes of a channel message, by the high nibble of its status
+static inline hv_uint8_t hMi_dataLength(hv_uint8_t status) {
+  return ((status & 0xE0) == 0xC0) ? 1 : 2; // program change and channel pressure have one
+}
+
+hv_uint32_t hMi_parse(HvMidiParser *o, const hv_uint8_t *bytes, hv_uint32_t numBytes,
+    HvMidiMessage *out, hv_uint32_t maxOut, hv_uint32_t *numOut) {
+  hv_uint32_t n = 0;
+  hv_uint32_t i = 0;
+  for (; i < numBytes && n < maxOut; ++i) {
+    const hv_uint8_t b = bytes[i];
+    if (b < 0x80) {
+      // no status also covers system exclusive and the data of system common messages
+      if (o->status == 0) continue;
+      if (o->count == 0 && hMi_dataLength(o->status) == 2) {
+        o->data1 = b;
+        o->count = 1;
+        continue;
+      }
+      HvMidiMessage *m = out + n++;
+      m->status = o->status;
+      m->data1 = (o->count == 0) ? b : o->data1;
+      m->data2 = (o->count == 0) ? 0 : b;
+      m->end = i;
+      o->count = 0; // the status keeps running
+    } else if (b < 0xF0) {
+      o->status = b;
+      o->count = 0;
+    } else if (b < 0xF8) {
+      // system exclusive and common; real-time (0xF8 and up) doesn't touch the state
+      o->status = 0;
+      o->count = 0;
+    }
+  }
+  *numOut = n;
+  return i;
+}
+
+hv_uint32_t hMi_toMessage(const HvMidiMessage *m, HvMidiMessageStorage *s) {
+  const float channel = (float) (m->status & 0x0F);
+  switch (m->status & 0xF0) {
+    case 0x80: // note off
+    case 0x90: { // note on
+      HvMessage *msg = msg_init(&s->msg, 3, 0);
+      msg_setFloat(msg, 0, (float) m->data1);
+      msg_setFloat(msg, 1, ((m->status & 0xF0) == 0x80) ? 0.0f : (float) m->data2);
+      msg_setFloat(msg, 2, channel);
+      return HV_MIDI_HASH_NOTEIN;
+    }
+    case 0xA0: { // polyphonic key pressure
+      HvMessage *msg = msg_init(&s->msg, 3, 0);
+      msg_setFloat(msg, 0, (float) m->data2);
+      msg_setFloat(msg, 1, (float) m->data1);
+      msg_setFloat(msg, 2, channel);
+      return HV_MIDI_HASH_POLYTOUCHIN;
+    }
+    case 0xB0: { // control change
+      HvMessage *msg = msg_init(&s->msg, 3, 0);
+      msg_setFloat(msg, 0, (float) m->data2);
+      msg_setFloat(msg, 1, (float) m->data1);
+      msg_setFloat(msg, 2, channel);
+      return HV_MIDI_HASH_CTLIN;
+    }
+    case 0xC0: { // program change
+      HvMessage *msg = msg_init(&s->msg, 2, 0);
+      msg_setFloat(msg, 0, (float) m->data1);
+      msg_setFloat(msg, 1, channel);
+      return HV_MIDI_HASH_PGMIN;
+    }
+    case 0xD0: { // channel pressure
+      HvMessage *msg = msg_init(&s->msg, 2, 0);
+      msg_setFloat(msg, 0, (float) m->data1);
+      msg_setFloat(msg, 1, channel);
+      return HV_MIDI_HASH_TOUCHIN;
+    }
+    default: { // pitch bend
+      HvMessage *msg = msg_init(&s->msg, 2, 0);
+      msg_setFloat(msg, 0, (float) ((m->data2 << 7) | m->data1));
+      msg_setFloat(msg, 1, channel);
+      return HV_MIDI_HASH_BENDIN;
+    }
+  }
+}
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_MIDI_PARSER_H_
+#define _HEAVY_MIDI_PARSER_H_
+
+#include "HvMessage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// receivers that Heavy's MIDI input objects listen to
+#define HV_MIDI_HASH_NOTEIN 0x67E37CA3      // __hv_notein: note, velocity, channel
+#define HV_MIDI_HASH_CTLIN 0x41BE0F9C       // __hv_ctlin: value, controller, channel
+#define HV_MIDI_HASH_POLYTOUCHIN 0xBC530F59 // __hv_polytouchin: pressure, note, channel
+#define HV_MIDI_HASH_PGMIN 0x2E1EA03D       // __hv_pgmin: program, channel
+#define HV_MIDI_HASH_TOUCHIN 0x553925BD     // __hv_touchin: pressure, channel
+#define HV_MIDI_HASH_BENDIN 0x3083F0F7      // __hv_bendin: bend (0 to 16383), channel
+
+/*
+ * An incremental MIDI parser. It walks the bytes where they are, e.g. in the
+ * buffer filled by the UART driver, and keeps only the pending status and first
+ * data byte between calls, so messages may be split across reads.
+ * - Running status is followed.
+ * - System real-time bytes may appear anywhere and are skipped.
+ * - System exclusive and system common messages are skipped and cancel the
+ *   running status.
+ * - Data bytes without a status are dropped.
+ * Only channel voice messages are produced.
+ *
+ * There is nothing platform-specific here, so it can be fed from a file or a
+ * pipe on a host.
+ */
+typedef struct HvMidiParser {
+  hv_uint8_t status;  // running status, 0 if none
+  hv_uint8_t data1;   // first data byte of a pending message
+  hv_uint8_t count;   // data bytes received of the pending message
+} HvMidiParser;
+
+typedef struct HvMidiMessage {
+  hv_uint8_t status;
+  hv_uint8_t data1;
+  hv_uint8_t data2; // 0 for messages with one data byte
+  hv_uint32_t end;  // offset of the byte that completed the message, in the bytes parsed
+} HvMidiMessage;
+
+// room for the longest message hMi_toMessage() writes, three floats
+typedef union HvMidiMessageStorage {
+  HvMessage msg;
+  hv_uint8_t bytes[offsetof(HvMessage, types) + 4 * sizeof(ElementData)];
+} HvMidiMessageStorage;
+
+void hMi_init(HvMidiParser *o);
+
+/**
+ * Forgets any partial message and the running status, e.g. after the input
+ * overflowed.
+ */
+static inline void hMi_reset(HvMidiParser *o) {
+  hMi_init(o);
+}
+
+/**
+ * Parses bytes until they run out or out is full.
+ *
+ * @param numOut  Filled with the number of messages written to out.
+ * @return  The number of bytes consumed. Less than numBytes only if out is full,
+ *          in which case the rest should be passed again.
+ */
+hv_uint32_t hMi_parse(HvMidiParser *o, const hv_uint8_t *bytes, hv_uint32_t numBytes,
+    HvMidiMessage *out, hv_uint32_t maxOut, hv_uint32_t *numOut);
+
+/**
+ * Writes the Heavy message for a MIDI message, laid out as the hvcc
+ * wrappers send it: channels count from 0, and a note off is a note on with
+ * velocity 0.
+ *
+ * @return  The hash of the receiver to send it to.
+ */
+hv_uint32_t hMi_toMessage(const HvMidiMessage *m, HvMidiMessageStorage *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_MIDI_PARSER_H_
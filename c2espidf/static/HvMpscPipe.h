@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_MPSC_PIPE_H_
+#define _HEAVY_MPSC_PIPE_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A ring of variable-sized records with any number of producer threads and one
+ * consumer thread. Producers claim space with a compare-and-swap on the head, so
+ * no producer waits for another one and there is no lock to be preempted while
+ * holding. Each record starts with a header word that the producer publishes
+ * with a release store once the record is written; the consumer reads it with an
+ * acquire load. A record that was reserved but not yet published holds back the
+ * records after it until it is published, which keeps them in reservation order.
+ *
+ * The pipe uses the GCC/Clang __atomic builtins, which follow the C11 memory
+ * model and emit the required barriers (memw on Xtensa) on multi-core targets.
+ */
+typedef struct HvMpscPipe {
+  char *buffer;
+  hv_uint32_t mask; // capacity in bytes minus one, the capacity is a power of two
+  hv_uint32_t head; // total bytes reserved by producers, wraps around
+  hv_uint32_t tail; // total bytes consumed, wraps around
+} HvMpscPipe;
+
+// every record is preceded by a header of this size and padded to a multiple of it
+#define HMP_HEADER_SIZE 8
+
+/**
+ * Initialise the pipe with at least the given length, in bytes. A length of
+ * zero leaves the pipe without a buffer, so that writes always fail.
+ * @return  Returns the size of the pipe in bytes, rounded up to a power of two.
+ */
+hv_uint32_t hMp_init(HvMpscPipe *q, hv_uint32_t numBytes);
+
+/**
+ * Frees the internal buffer.
+ */
+void hMp_free(HvMpscPipe *q);
+
+/**
+ * Returns the number of bytes that a record of numBytes occupies in the pipe,
+ * including its header. Batches are reserved by summing these.
+ */
+static inline hv_uint32_t hMp_getRecordSize(hv_uint32_t numBytes) {
+  return HMP_HEADER_SIZE + ((numBytes + HMP_HEADER_SIZE - 1) & ~(hv_uint32_t) (HMP_HEADER_SIZE - 1));
+}
+
+/**
+ * Reserves a contiguous region for one or more records. May be called from any
+ * thread.
+ *
+ * @param totalBytes  The sum of hMp_getRecordSize() over the records to write.
+ * @return  A pointer to where the first record can be written, or NULL if there
+ *          is not enough free space.
+ */
+char *hMp_getWriteBuffer(HvMpscPipe *q, hv_uint32_t totalBytes);
+
+/**
+ * Returns the location of the next record of a batch, given the location and
+ * size of the previous one. The record becomes visible together with the first
+ * one of the batch, when hMp_produce() is called.
+ */
+char *hMp_getNextBatchBuffer(char *buffer, hv_uint32_t numBytes, hv_uint32_t nextBytes);
+
+/**
+ * Publishes the record (or batch) starting at buffer.
+ *
+ * @param buffer  The pointer returned by hMp_getWriteBuffer().
+ * @param numBytes  The size of the first record.
+ */
+void hMp_produce(HvMpscPipe *q, char *buffer, hv_uint32_t numBytes);
+
+/**
+ * Returns the next published record, or NULL if there is none. Only the
+ * consumer thread may call this.
+ *
+ * @param numBytes  Filled with the size of the record, rounded up to the header size.
+ */
+char *hMp_getReadBuffer(HvMpscPipe *q, hv_uint32_t *numBytes);
+
+/**
+ * Releases the record returned by the last call to hMp_getReadBuffer().
+ */
+void hMp_consume(HvMpscPipe *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_MPSC_PIPE_H_
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#if !defined(_POSIX_C_SOURCE) && !ESP_PLATFORM
+#define _POSIX_C_SOURCE 200809L // clock_gettime() under strict C
+#endif
+
+#include "HvNotifier.h"
+
+#if HV_NOTIFIER_PTHREAD
+#include <errno.h>
+#include <time.h>
+#endif
+
+void hNt_init(HvNotifier *o) {
+  o->pending = false;
+#if ESP_PLATFORM
+  o->waiter = NULL;
+#elif HV_NOTIFIER_PTHREAD
+  pthread_mutex_init(&o->mutex, NULL);
+  pthread_cond_init(&o->cond, NULL);
+#endif
+}
+
+void hNt_free(HvNotifier *o) {
+#if HV_NOTIFIER_PTHREAD
+  pthread_cond_destroy(&o->cond);
+  pthread_mutex_destroy(&o->mutex);
+#endif
+}
+
+void hNt_notify(HvNotifier *o) {
+  // sequentially consistent, so that either the waiter sees the flag or we see the waiter
+  if (__atomic_exchange_n(&o->pending, true, __ATOMIC_SEQ_CST)) return;
+#if ESP_PLATFORM
+  TaskHandle_t waiter = __atomic_load_n(&o->waiter, __ATOMIC_SEQ_CST);
+  if (waiter != NULL) xTaskNotifyGive(waiter);
+#elif HV_NOTIFIER_PTHREAD
+  // taking the mutex orders the signal after the waiter has started waiting
+  pthread_mutex_lock(&o->mutex);
+  pthread_cond_signal(&o->cond);
+  pthread_mutex_unlock(&o->mutex);
+#endif
+}
+
+bool hNt_wait(HvNotifier *o, hv_uint32_t timeoutMs) {
+#if ESP_PLATFORM
+  __atomic_store_n(&o->waiter, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&o->pending, __ATOMIC_SEQ_CST)) {
+    // a stale notification only causes an early return with nothing pending
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+  }
+#elif HV_NOTIFIER_PTHREAD
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeoutMs / 1000;
+  deadline.tv_nsec += (long) (timeoutMs % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  pthread_mutex_lock(&o->mutex);
+  int err = 0;
+  while (!__atomic_load_n(&o->pending, __ATOMIC_SEQ_CST) && err != ETIMEDOUT) {
+    err = pthread_cond_timedwait(&o->cond, &o->mutex, &deadline);
+  }
+  pthread_mutex_unlock(&o->mutex);
+#endif
+  return __atomic_exchange_n(&o->pending, false, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_NOTIFIER_H_
+#define _HEAVY_NOTIFIER_H_
+
+#include "HvUtils.h"
+
+#if ESP_PLATFORM
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#elif HV_UNIX || HV_APPLE || HV_ANDROID
+  #include <pthread.h>
+  #define HV_NOTIFIER_PTHREAD 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Wakes one waiting thread from any number of notifying threads. Notifications
+ * coalesce into a pending flag: only the one that sets it pays for a wakeup, and
+ * a wait returns at once while it is set. The wakeup is a FreeRTOS task
+ * notification on ESP-IDF and a condition variable elsewhere. Platforms with
+ * neither never block, so hNt_wait() returns at once and the caller polls.
+ */
+typedef struct HvNotifier {
+  bool pending;
+#if ESP_PLATFORM
+  TaskHandle_t waiter;
+#elif HV_NOTIFIER_PTHREAD
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+} HvNotifier;
+
+void hNt_init(HvNotifier *o);
+
+void hNt_free(HvNotifier *o);
+
+/**
+ * Wakes the waiting thread, or makes its next wait return at once. Must not be
+ * called from an ISR.
+ */
+void hNt_notify(HvNotifier *o);
+
+/**
+ * Blocks until notified or until timeoutMs has passed.
+ * Only one thread may wait on a notifier.
+ *
+ * @return  True if a notification was received, which clears it.
+ */
+bool hNt_wait(HvNotifier *o, hv_uint32_t timeoutMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_NOTIFIER_H_
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvOscParser.h"
+
+static inline hv_uint32_t hOs_read32(const hv_uint8_t *p) {
+  return ((hv_uint32_t) p[0] << 24) | ((hv_uint32_t) p[1] << 16) | ((hv_uint32_t) p[2] << 8) | p[3];
+}
+
+static inline hv_uint64_t hOs_read64(const hv_uint8_t *p) {
+  return ((hv_uint64_t) hOs_read32(p) << 32) | hOs_read32(p + 4);
+}
+
+// size of the NUL-terminated string at p with its padding, or 0 if it doesn't end within size bytes
+static hv_uint32_t hOs_stringSize(const hv_uint8_t *p, hv_uint32_t size) {
+  for (hv_uint32_t i = 0; i < size; ++i) {
+    if (p[i] == '\0') {
+      const hv_uint32_t padded = (i + 4) & ~3u;
+      return (padded <= size) ? padded : 0;
+    }
+  }
+  return 0;
+}
+
+static bool hOs_parseElement(const hv_uint8_t *p, hv_uint32_t size, hv_uint64_t timetag, int depth,
+    HvOscHook *hook, void *user) {
+  if (size < 4 || (size & 3) != 0) return false;
+
+  if (p[0] == '/') {
+    const hv_uint32_t a = hOs_stringSize(p, size);
+    if (a == 0) return false;
+    HvOscMessage m;
+    m.address = (const char *) p;
+    m.timetag = timetag;
+    if (a < size && p[a] == ',') {
+      const hv_uint32_t t = hOs_stringSize(p + a, size - a);
+      if (t == 0) return false;
+      m.types = (const char *) p + a + 1;
+      m.args = p + a + t;
+      m.argsSize = size - a - t;
+    } else {
+      m.types = ""; // packets from before type tags were required
+      m.args = p + a;
+      m.argsSize = size - a;
+    }
+    hook(user, &m);
+    return true;
+  }
+
+  if (size >= 16 && hv_strcmp((const char *) p, "#bundle") == 0) {
+    if (depth == HV_OSC_MAX_DEPTH) return false;
+    const hv_uint64_t tag = hOs_read64(p + 8);
+    for (hv_uint32_t i = 16; i < size;) {
+      if (size - i < 4) return false;
+      const hv_uint32_t n = hOs_read32(p + i);
+      i += 4;
+      if (n > size - i || !hOs_parseElement(p + i, n, tag, depth + 1, hook, user)) return false;
+      i += n;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool hOs_parse(const hv_uint8_t *packet, hv_uint32_t size, HvOscHook *hook, void *user) {
+  return hOs_parseElement(packet, size, HV_OSC_IMMEDIATELY, 0, hook, user);
+}
+
+bool hOs_toMessage(const HvOscMessage *m, HvOscMessageStorage *s) {
+  hv_uint32_t n = 0;
+  for (const char *t = m->types; *t != '\0'; ++t) {
+    if (*t != 'N' && *t != 'I') n++;
+  }
+  if (n > HV_OSC_MAX_ARGS) return false;
+  if (n == 0) {
+    msg_initWithBang(&s->msg, 0);
+    return true;
+  }
+
+  HvMessage *msg = msg_init(&s->msg, n, 0);
+  const hv_uint8_t *p = m->args;
+  hv_uint32_t left = m->argsSize;
+  int k = 0;
+  for (const char *t = m->types; *t != '\0'; ++t) {
+    switch (*t) {
+      case 'i':
+      case 'c': {
+        if (left < 4) return false;
+        msg_setFloat(msg, k++, (float) (hv_int32_t) hOs_read32(p));
+        p += 4; left -= 4;
+        break;
+      }
+      case 'f': {
+        if (left < 4) return false;
+        const hv_uint32_t bits = hOs_read32(p);
+        float f;
+        hv_memcpy(&f, &bits, sizeof(f));
+        msg_setFloat(msg, k++, f);
+        p += 4; left -= 4;
+        break;
+      }
+      case 'h': {
+        if (left < 8) return false;
+        msg_setFloat(msg, k++, (float) (hv_int64_t) hOs_read64(p));
+        p += 8; left -= 8;
+        break;
+      }
+      case 'd': {
+        if (left < 8) return false;
+        const hv_uint64_t bits = hOs_read64(p);
+        double d;
+        hv_memcpy(&d, &bits, sizeof(d));
+        msg_setFloat(msg, k++, (float) d);
+        p += 8; left -= 8;
+        break;
+      }
+      case 'T': msg_setFloat(msg, k++, 1.0f); break;
+      case 'F': msg_setFloat(msg, k++, 0.0f); break;
+      case 'N':
+      case 'I': break;
+      case 's':
+      case 'S': {
+        const hv_uint32_t size = hOs_stringSize(p, left);
+        if (size == 0) return false;
+        const char *str = (const char *) p;
+        const HvSymbol *sym = hSym_find(hv_string_to_hash(str));
+        if (sym == NULL || hv_strcmp(sym->str, str) != 0) return false;
+        msg_setInternedSymbol(msg, k++, sym);
+        p += size; left -= size;
+        break;
+      }
+      default: return false; // blobs, timetags, MIDI and colours
+    }
+  }
+  return true;
+}
@@ -0,0 +1,38 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvSignalSmooth.h"
+
+hv_size_t sSmooth_init(SignalSmooth *o, float k, float timeMs, double sampleRate) {
+  const double samples = timeMs * sampleRate / 1000.0;
+  o->y = k;
+  o->target = k;
+  o->coeff = (samples > 1.0) ? (float) (1.0 - exp(-1.0 / samples)) : 1.0f;
+  o->epsilon = 0.0f;
+  return 0;
+}
+
+void sSmooth_setTarget(SignalSmooth *o, float target) {
+  o->target = target;
+  // the recursion only approaches the target, so stop once inaudibly close
+  o->epsilon = 1e-6f * (hv_abs_f(target) + 1.0f);
+}
+
+void sSmooth_onMessage(HeavyContextInterface *_c, SignalSmooth *o, const HvMessage *m) {
+  if (msg_isFloat(m,0)) {
+    sSmooth_setTarget(o, msg_getFloat(m,0));
+  }
+}
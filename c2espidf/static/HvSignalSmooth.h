@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_SIGNAL_SMOOTH_H_
+#define _HEAVY_SIGNAL_SMOOTH_H_
+
+#include "HvHeavyInternal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A one-pole smoother that turns a control value into a signal. c2espidf uses it
+ * in place of the __var~f that an @hv_param receiver writes to when the parameter
+ * is given a smoothing time, so that knob changes glide without zipper noise.
+ */
+typedef struct SignalSmooth {
+  float y;       // current output value
+  float target;  // value being approached
+  float coeff;   // fraction of the remaining distance covered per sample
+  float epsilon; // distance below which the output snaps to the target
+} SignalSmooth;
+
+/**
+ * @param k  The initial value.
+ * @param timeMs  The time constant, i.e. the time to cover ~63% of a step. Zero disables smoothing.
+ */
+hv_size_t sSmooth_init(SignalSmooth *o, float k, float timeMs, double sampleRate);
+
+void sSmooth_setTarget(SignalSmooth *o, float target);
+
+void sSmooth_onMessage(HeavyContextInterface *_c, SignalSmooth *o, const HvMessage *m);
+
+static inline float sSmooth_tick(SignalSmooth *o) {
+  if (o->y != o->target) {
+    const float y = o->y + o->coeff * (o->target - o->y);
+    // snap once close enough, or once the step falls below float resolution of y
+    o->y = (y == o->y || hv_abs_f(o->target - y) < o->epsilon) ? o->target : y;
+  }
+  return o->y;
+}
+
+static inline void __hv_smooth_f(SignalSmooth *o, hv_bOutf_t bOut) {
+#if HV_SIMD_NONE
+  *bOut = sSmooth_tick(o);
+#else
+  float *const out = (float *) bOut;
+  for (int i = 0; i < HV_N_SIMD; ++i) out[i] = sSmooth_tick(o);
+#endif
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _HEAVY_SIGNAL_SMOOTH_H_
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvSymbolTable.h"
+
+// the number of hash buckets for symbols interned at runtime, must be a power of two
+#define HSYM_NUM_BUCKETS 32
+
+#if HV_WIN
+#define HSYM_LOAD(_p) (_p)
+#define HSYM_CAS(_p, _expected, _desired) \
+    (InterlockedCompareExchangePointer((PVOID volatile *) (_p), (_desired), (_expected)) == (_expected))
+#else
+#define HSYM_LOAD(_p) __atomic_load_n(&(_p), __ATOMIC_ACQUIRE)
+#define HSYM_CAS(_p, _expected, _desired) \
+    __atomic_compare_exchange_n((_p), &(_expected), (_desired), false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#endif
+
+typedef struct SymbolNode {
+  HvSymbol symbol;
+  struct SymbolNode *next;
+} SymbolNode;
+
+// singly linked chains, only ever prepended to
+static SymbolNode *buckets[HSYM_NUM_BUCKETS];
+
+static const HvSymbol *hSym_findStatic(hv_uint32_t hash, const char *str) {
+  // binary search for the first entry with the given hash
+  int lo = 0;
+  int hi = hv_numStaticSymbols;
+  while (lo < hi) {
+    const int mid = (lo + hi) >> 1;
+    if (hv_staticSymbols[mid].hash < hash) lo = mid + 1;
+    else hi = mid;
+  }
+  // then resolve any hash collisions by string comparison
+  for (int i = lo; i < hv_numStaticSymbols && hv_staticSymbols[i].hash == hash; ++i) {
+    if (str == NULL || !hv_strcmp(hv_staticSymbols[i].str, str)) return &hv_staticSymbols[i];
+  }
+  return NULL;
+}
+
+static const HvSymbol *hSym_findDynamic(SymbolNode *n, hv_uint32_t hash, const char *str) {
+  for (; n != NULL; n = n->next) {
+    if (n->symbol.hash == hash && (str == NULL || !hv_strcmp(n->symbol.str, str))) return &n->symbol;
+  }
+  return NULL;
+}
+
+const HvSymbol *hSym_find(hv_uint32_t hash) {
+  const HvSymbol *s = hSym_findStatic(hash, NULL);
+  return (s != NULL) ? s : hSym_findDynamic(HSYM_LOAD(buckets[hash & (HSYM_NUM_BUCKETS-1)]), hash, NULL);
+}
+
+const HvSymbol *hSym_intern(const char *str) {
+  hv_assert(str != NULL);
+  const hv_uint32_t hash = hv_string_to_hash(str);
+  const HvSymbol *s = hSym_findStatic(hash, str);
+  if (s != NULL) return s;
+
+  SymbolNode **bucket = &buckets[hash & (HSYM_NUM_BUCKETS-1)];
+  SymbolNode *head = HSYM_LOAD(*bucket);
+  s = hSym_findDynamic(head, hash, str);
+  if (s != NULL) return s;
+
+  // first sighting of this string, copy it next to its node
+  const hv_size_t len = hv_strlen(str) + 1;
+  SymbolNode *n = (SymbolNode *) hv_malloc(sizeof(SymbolNode) + len);
+  hv_assert(n != NULL);
+  char *copy = (char *) (n + 1);
+  hv_memcpy(copy, str, len);
+  n->symbol.hash = hash;
+  n->symbol.str = copy;
+
+  for (;;) {
+    n->next = head;
+    if (HSYM_CAS(bucket, head, n)) return &n->symbol;
+    // another thread prepended to the chain in the meantime; it may have added this very string
+    head = HSYM_LOAD(*bucket);
+    s = hSym_findDynamic(head, hash, str);
+    if (s != NULL) {
+      hv_free(n);
+      return s;
+    }
+  }
+}
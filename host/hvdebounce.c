@@ -0,0 +1,157 @@
+/*
+ * Host test of the button debouncer (c2espidf/static/HvDebounce.h) against a
+ * simulated edge source. A producer thread stands in for the GPIO interrupt:
+ * for each button it pushes presses and releases a random, stable gap apart,
+ * each followed by a burst of bounces shorter than the debounce period. The
+ * main thread stands in for the task and runs hDb_process() behind the
+ * producer's clock. Every press and release must be reported once, with the
+ * time of its first edge, however much it bounced. Then a lone spike must be
+ * reported at once and taken back when the period ends.
+ *
+ *   cc -O2 -Ic2espidf/static host/hvdebounce.c c2espidf/static/HvDebounce.c -lpthread -o hvdebounce
+ *
+ * Build with -fsanitize=thread as well to have the ring's ordering checked by
+ * ThreadSanitizer; it should report nothing.
+ *
+ *   hvdebounce [-b buttons] [-n presses] [-k ring size]
+ *       -b  buttons (3)
+ *       -n  presses per button (20000)
+ *       -k  edges in the ring, rounded up to a power of two (16, so it fills up)
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "HvDebounce.h"
+
+#define MAX_BUTTONS 32
+#define PERIOD 5000     // debounce period, in microseconds
+#define MAX_BOUNCES 5   // bounces after an edge, each a flip there and back
+#define MAX_BOUNCE 800  // longest time between two bounces
+#define LAG 50000       // how far the task runs behind, longer than any burst
+
+typedef struct {
+  hv_int64_t time;
+  int level;
+} Change;
+
+static HvDebounce db;
+static int num_buttons = 3;
+static int num_presses = 20000;
+static Change *expected[MAX_BUTTONS], *reported[MAX_BUTTONS];
+static int num_reported[MAX_BUTTONS];
+static hv_int64_t clock_now = 0;
+static int producer_done = 0;
+
+static void push(hv_uint32_t button, int level, hv_int64_t time) {
+  while (!hDb_pushEdge(&db, button, (hv_uint32_t) level, time)) sched_yield(); // full, as it often is
+}
+
+static void *producer(void *arg) {
+  unsigned int seed = 1;
+  hv_int64_t t = 0;
+  for (int p = 0; p < num_presses; ++p) {
+    for (int b = 0; b < num_buttons; ++b) {
+      for (int level = 1; level >= 0; --level) {
+        t += 3 * PERIOD + rand_r(&seed) % (4 * PERIOD); // stable for longer than the period
+        expected[b][2 * p + (1 - level)] = (Change) { t, level };
+        push((hv_uint32_t) b, level, t);
+        hv_int64_t bt = t;
+        int current = level;
+        for (int k = rand_r(&seed) % (MAX_BOUNCES + 1); k > 0; --k) {
+          bt += 1 + rand_r(&seed) % MAX_BOUNCE;
+          current = !current;
+          push((hv_uint32_t) b, current, bt);
+          bt += 1 + rand_r(&seed) % MAX_BOUNCE;
+          current = !current;
+          push((hv_uint32_t) b, current, bt);
+        }
+        __atomic_store_n(&clock_now, bt, __ATOMIC_RELEASE);
+      }
+    }
+  }
+  __atomic_store_n(&producer_done, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+static void on_change(void *user, hv_uint32_t button, hv_uint32_t level, hv_int64_t time) {
+  if (num_reported[button] < 2 * num_presses + 2) reported[button][num_reported[button]] = (Change) { time, (int) level };
+  ++num_reported[button];
+}
+
+int main(int argc, char **argv) {
+  int ring = 16, opt;
+  while ((opt = getopt(argc, argv, "b:n:k:")) != -1) {
+    switch (opt) {
+      case 'b': num_buttons = atoi(optarg); break;
+      case 'n': num_presses = atoi(optarg); break;
+      case 'k': ring = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-b buttons] [-n presses] [-k ring size]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (num_buttons < 1 || num_buttons > MAX_BUTTONS || num_presses < 1 || ring < 1) {
+    fprintf(stderr, "-b is 1 to %d, -n and -k are positive\n", MAX_BUTTONS);
+    return 2;
+  }
+  for (int b = 0; b < num_buttons; ++b) {
+    expected[b] = (Change *) malloc(2 * num_presses * sizeof(Change));
+    reported[b] = (Change *) malloc((2 * num_presses + 2) * sizeof(Change));
+  }
+  const hv_uint32_t size = hDb_init(&db, (hv_uint32_t) num_buttons, (hv_uint32_t) ring, PERIOD);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, producer, NULL);
+  while (!__atomic_load_n(&producer_done, __ATOMIC_ACQUIRE)) {
+    hDb_process(&db, __atomic_load_n(&clock_now, __ATOMIC_ACQUIRE) - LAG, &on_change, NULL);
+    sched_yield();
+  }
+  pthread_join(thread, NULL);
+  const hv_int64_t next = hDb_process(&db, clock_now + LAG, &on_change, NULL);
+
+  int wrong = 0;
+  for (int b = 0; b < num_buttons; ++b) {
+    if (num_reported[b] != 2 * num_presses) {
+      printf("button %d: %d changes reported, expected %d\n", b, num_reported[b], 2 * num_presses);
+      ++wrong;
+      continue;
+    }
+    for (int i = 0; i < 2 * num_presses; ++i) {
+      const Change r = reported[b][i], e = expected[b][i];
+      if (r.time == e.time && r.level == e.level) continue;
+      if (wrong++ < 10) {
+        printf("button %d, change %d: %d at %lld, expected %d at %lld\n",
+            b, i, r.level, (long long) r.time, e.level, (long long) e.time);
+      }
+    }
+  }
+  // the producer retries a dropped edge, so the count is how often the ring was full
+  printf("%d buttons, %d presses each through a %u-edge ring: %d changes wrong, ring full %u times\n",
+      num_buttons, num_presses, size, wrong, hDb_getDroppedCount(&db));
+  if (next != HV_DEBOUNCE_IDLE) {
+    printf("a button is still settling at the end\n");
+    ++wrong;
+  }
+
+  // a 50 us spike: the press goes out at once, the release when the period is over
+  hDb_setLevel(&db, 0, 0);
+  num_reported[0] = 0;
+  hDb_pushEdge(&db, 0, 1, 100);
+  hDb_pushEdge(&db, 0, 0, 150);
+  const hv_int64_t settled = hDb_process(&db, 200, &on_change, NULL);
+  const int pressed = (num_reported[0] == 1 && reported[0][0].level == 1 && reported[0][0].time == 100);
+  const hv_int64_t idle = hDb_process(&db, settled, &on_change, NULL);
+  const int spike_ok = pressed && settled == 150 + PERIOD && idle == HV_DEBOUNCE_IDLE &&
+      num_reported[0] == 2 && reported[0][1].level == 0 && reported[0][1].time == 150;
+  printf("spike %s\n", spike_ok ? "reported and taken back" : "not reported as a press and a release");
+
+  hDb_free(&db);
+  for (int b = 0; b < num_buttons; ++b) {
+    free(expected[b]);
+    free(reported[b]);
+  }
+  return (wrong == 0 && spike_ok) ? 0 : 1;
+}
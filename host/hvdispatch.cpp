@@ -0,0 +1,188 @@
+/*
+ * Benchmark of receiver dispatch in HeavyContext, for patches with 10, 100 and
+ * 1000 receivers. Each patch is a stand-in for a generated one: the same receive
+ * switch on the hash that HVCC emits in scheduleMessageForReceiver(), and the
+ * receiver index table that c2espidf adds. Floats are sent to a random set of
+ * receivers each block, then a block's processing delivers them, through
+ *   hash         hv_sendFloatToReceiver(), dispatched by the switch
+ *   index        hv_sendFloatToReceiverIndex(), dispatched through the table
+ *   latest-wins  hv_sendFloatToReceiver() to latest-wins receivers, whose hash is
+ *                looked up in the table's hash order when the float is sent
+ * Every receiver has its own receive function, which checks that the float
+ * sent to it is its own index.
+ *
+ *   c++ -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvdispatch.cpp main/hvcc/c/H*.c main/hvcc/c/H*.cpp -lpthread -o hvdispatch
+ *
+ *   hvdispatch [-n blocks]
+ *       -n  blocks per patch and path (20000)
+ *
+ * Prints the time per message on the sending side and in the block, and exits
+ * nonzero if a message was lost or reached the wrong receiver.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+#include <vector>
+
+#include "HeavyContext.hpp"
+
+#define BLOCK 64
+#define MAX_PER_BLOCK 128
+
+// receiver hashes, a bijection so that none collide
+#define RECEIVER_HASH(i) ((hv_uint32_t) (((i) + 1) * 2654435761u))
+
+class Bench;
+
+template<int I> static void receive(HeavyContextInterface *c, int letIn, const HvMessage *m);
+
+// receive<Lo> .. receive<Hi-1> into targets, split in halves to keep the recursion shallow
+template<int Lo, int Hi, bool Leaf = (Hi - Lo == 1)> struct TargetRange {
+  static void fill(HvReceiverTarget_t **targets) {
+    TargetRange<Lo, (Lo + Hi) / 2>::fill(targets);
+    TargetRange<(Lo + Hi) / 2, Hi>::fill(targets);
+  }
+};
+template<int Lo, int Hi> struct TargetRange<Lo, Hi, true> {
+  static void fill(HvReceiverTarget_t **targets) { targets[Lo] = &receive<Lo>; }
+};
+
+// the cases of a receive switch, as HVCC emits them
+#define CASE(i) case RECEIVER_HASH(i): mq_addMessageByTimestamp(mq, m, 0, &receive<(i)>); break;
+#define CASES10(b) CASE(b) CASE(b+1) CASE(b+2) CASE(b+3) CASE(b+4) CASE(b+5) CASE(b+6) CASE(b+7) CASE(b+8) CASE(b+9)
+#define CASES100(b) CASES10(b) CASES10(b+10) CASES10(b+20) CASES10(b+30) CASES10(b+40) \
+    CASES10(b+50) CASES10(b+60) CASES10(b+70) CASES10(b+80) CASES10(b+90)
+#define CASES1000(b) CASES100(b) CASES100(b+100) CASES100(b+200) CASES100(b+300) CASES100(b+400) \
+    CASES100(b+500) CASES100(b+600) CASES100(b+700) CASES100(b+800) CASES100(b+900)
+
+static void dispatch10(HvMessageQueue *mq, hv_uint32_t receiverHash, HvMessage *m) {
+  switch (receiverHash) { CASES10(0) default: return; }
+}
+static void dispatch100(HvMessageQueue *mq, hv_uint32_t receiverHash, HvMessage *m) {
+  switch (receiverHash) { CASES100(0) default: return; }
+}
+static void dispatch1000(HvMessageQueue *mq, hv_uint32_t receiverHash, HvMessage *m) {
+  switch (receiverHash) { CASES1000(0) default: return; }
+}
+
+class Bench : public HeavyContext {
+ public:
+  Bench(int numReceivers) : HeavyContext(48000.0, 64, 64, 0), delivered(0), misrouted(0) {
+    static HvReceiverTarget_t *allTargets[1000];
+    TargetRange<0, 1000>::fill(allTargets);
+    dispatch = (numReceivers == 10) ? &dispatch10 : (numReceivers == 100) ? &dispatch100 : &dispatch1000;
+    for (int i = 0; i < numReceivers; ++i) {
+      hashes.push_back(RECEIVER_HASH(i));
+      order.push_back((hv_uint32_t) i);
+      offsets.push_back((hv_uint32_t) i);
+    }
+    offsets.push_back((hv_uint32_t) numReceivers);
+    std::sort(order.begin(), order.end(), [this](hv_uint32_t a, hv_uint32_t b) { return hashes[a] < hashes[b]; });
+    table.numReceivers = (hv_uint32_t) numReceivers;
+    table.hashes = hashes.data();
+    table.hashOrder = order.data();
+    table.offsets = offsets.data();
+    table.targets = allTargets;
+    initReceiverTable(&table);
+  }
+
+  const char *getName() override { return "bench"; }
+  int getNumInputChannels() override { return 0; }
+  int getNumOutputChannels() override { return 0; }
+  int getParameterInfo(int index, HvParameterInfo *info) override { return 0; }
+
+  // delivers the messages of one block, like a generated process() without signals
+  int process(float **inputBuffers, float **outputBuffers, int n) override {
+    processInputQueue();
+    const hv_uint32_t nextBlock = blockStartTimestamp + n;
+    while (mq_hasMessageBefore(&mq, nextBlock)) {
+      MessageNode *const node = mq_peek(&mq);
+      node->sendMessage(this, node->let, node->m);
+      mq_pop(&mq);
+    }
+    blockStartTimestamp = nextBlock;
+    return n;
+  }
+  int processInline(float *inputBuffers, float *outputBuffers, int n) override { return process(nullptr, nullptr, n); }
+  int processInlineInterleaved(float *inputBuffers, float *outputBuffers, int n) override { return process(nullptr, nullptr, n); }
+
+  long delivered;
+  long misrouted;
+
+ protected:
+  HvTable *getTableForHash(hv_uint32_t tableHash) override { return nullptr; }
+  void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override { dispatch(&mq, receiverHash, m); }
+
+ private:
+  void (*dispatch)(HvMessageQueue *, hv_uint32_t, HvMessage *);
+  std::vector<hv_uint32_t> hashes, order, offsets;
+  HvReceiverTable table;
+};
+
+template<int I> static void receive(HeavyContextInterface *c, int letIn, const HvMessage *m) {
+  Bench *b = static_cast<Bench *>(c);
+  if (msg_getFloat(m, 0) != (float) I) ++b->misrouted;
+  ++b->delivered;
+}
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+enum Path { HASH, INDEX, LATEST_WINS };
+static const char *const pathNames[] = { "hash", "index", "latest-wins" };
+
+// returns false if a message was lost or misrouted
+static bool run(int numReceivers, Path path, int blocks) {
+  Bench b(numReceivers);
+  if (path == LATEST_WINS) {
+    for (int i = 0; i < numReceivers; ++i) b.setReceiverLatestWins((hv_uint32_t) i, true);
+  }
+  // distinct receivers each block, so that latest-wins has nothing to coalesce
+  const int perBlock = std::min(numReceivers, MAX_PER_BLOCK);
+  std::vector<int> receivers(numReceivers);
+  for (int i = 0; i < numReceivers; ++i) receivers[i] = i;
+  srand(1);
+  double sendTime = 0.0, blockTime = 0.0;
+  long sent = 0;
+  for (int k = 0; k < blocks; ++k) {
+    for (int i = 0; i < perBlock; ++i) std::swap(receivers[i], receivers[i + rand() % (numReceivers - i)]);
+    const double t0 = now();
+    for (int i = 0; i < perBlock; ++i) {
+      const int r = receivers[i];
+      if (path == INDEX) b.sendFloatToReceiverIndex((hv_uint32_t) r, (float) r);
+      else b.sendFloatToReceiver(RECEIVER_HASH(r), (float) r);
+    }
+    const double t1 = now();
+    b.process(nullptr, nullptr, BLOCK);
+    const double t2 = now();
+    sendTime += t1 - t0;
+    blockTime += t2 - t1;
+    sent += perBlock;
+  }
+  printf("%5d receivers  %-12s  send %6.1f ns/msg  block %6.1f ns/msg  (%ld of %ld delivered, %ld misrouted)\n",
+      numReceivers, pathNames[path], sendTime / sent * 1e9, blockTime / sent * 1e9, b.delivered, sent, b.misrouted);
+  return b.delivered == sent && b.misrouted == 0;
+}
+
+int main(int argc, char **argv) {
+  int blocks = 20000, opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n': blocks = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n blocks]\n", argv[0]);
+        return 2;
+    }
+  }
+  bool ok = true;
+  static const int sizes[] = { 10, 100, 1000 };
+  for (int n : sizes) {
+    for (int p = HASH; p <= LATEST_WINS; ++p) ok &= run(n, (Path) p, blocks);
+  }
+  return ok ? 0 : 1;
+}
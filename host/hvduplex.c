@@ -0,0 +1,284 @@
+/*
+ * Host mock of the full-duplex audio path of main/poc_esp32_hvcc_i2s.c: the
+ * I2S channels are replaced by a model of the ESP-IDF driver's DMA rings with
+ * DOUT wired back to DIN, and run_audio_loop()'s pass (read, convert with
+ * HvAudioIo, process, convert, write) runs against it. A click sent on the first
+ * pass goes round the loop through a pass-through stand-in for [adc~]->[dac~],
+ * which verifies the latency from the pins and through the app. Each channel
+ * clicks at its own level, so every slot must come back on its own channel.
+ *
+ * Before that, HvAudioIo's conversions are checked on their own for mono into
+ * 2, 4 and 8 slots, for fewer and more channels than slots, and for slot counts
+ * without a fast path. After it, the unrolled 2, 4 and 8-slot writes are timed
+ * against the generic loop they replace. The test includes HvAudioIo.c, to call
+ * that loop with a slot count only known at runtime.
+ *
+ *   cc -O2 -DHV_SIMD_NONE -Ic2espidf/static host/hvduplex.c -lm -o hvduplex
+ *
+ *   hvduplex [-b 16|32] [-s slots] [-d descriptors] [-n passes] [-x pass] [-r blocks]
+ *       -b  slot width (16, as the app runs it)
+ *       -s  slots per frame and channels of the patch (2; 4 or 8 for TDM)
+ *       -d  DMA buffers each way (two blocks' worth, as the app runs it)
+ *       -n  passes to run (1000)
+ *       -x  lets this pass overrun its block, to show the loop recovers
+ *       -r  blocks to time each conversion on, the fastest is kept (2000)
+ *
+ * The model follows the driver: the DMA goes round dma_desc_num buffers each
+ * way, in step since both channels share the clock. A buffer holds at most 4092
+ * bytes, so a block of 8 slots takes two, as in init_i2s(). At the end of each
+ * buffer the interrupt queues the one just captured for i2s_channel_read() and
+ * the one just played for i2s_channel_write(). Both queues hold
+ * dma_desc_num - 1 buffers and drop the oldest when full.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HvAudioIo.c"
+
+#define BLOCK 256 // AUDIO_BLOCK_FRAMES
+#define MAX_SLOTS 8
+#define MAX_DESC 32
+#define DMA_BUFFER_MAX 4092
+#define CLICK(c) (0.1f * (float) ((c) + 1)) // a level per channel, apart by more than a trip's drift
+
+// buffers by the period they were captured or played in, buffer = period % desc_num
+typedef struct {
+  int n, head, count;
+  long items[MAX_DESC];
+} Queue;
+
+static void q_push(Queue *q, long v) {
+  if (q->count == q->n) { q->head = (q->head + 1) % q->n; --q->count; } // drop the oldest
+  q->items[(q->head + q->count++) % q->n] = v;
+}
+
+static long q_pop(Queue *q) {
+  if (q->count == 0) return -1;
+  long v = q->items[q->head];
+  q->head = (q->head + 1) % q->n;
+  --q->count;
+  return v;
+}
+
+static int bits = 16;
+static int slots = 2;
+static int desc_num = 0;
+static unsigned char tx_dma[MAX_DESC][DMA_BUFFER_MAX * 2];
+static unsigned char rx_dma[MAX_DESC][DMA_BUFFER_MAX * 2];
+static Queue tx_queue, rx_queue;
+
+// channel c, frame i of a block: distinct everywhere, both signs, and beyond full scale
+static float layout_value(int c, int i, int frames) {
+  return (float) ((c + 1) * frames + i) / (float) (4 * frames) * ((i & 1) ? -1.0f : 1.0f);
+}
+
+// the layout of one block of channels in slots, written and read back at both widths
+static int check_layout(int channels, int numSlots) {
+  enum { F = 32 };
+  static float in[MAX_SLOTS * F], back[MAX_SLOTS * F];
+  static hv_int16_t out16[F * MAX_SLOTS];
+  static hv_int32_t out32[F * MAX_SLOTS];
+  HvMeterAccum accum[MAX_SLOTS];
+  int wrong = 0;
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < F; ++i) in[c * F + i] = layout_value(c, i, F);
+  }
+  for (int width = 16; width <= 32; width += 16) {
+    memset(accum, 0, sizeof(accum));
+    if (width == 16) hAi_writeS16(out16, numSlots, in, channels, F, accum);
+    else hAi_writeS32(out32, numSlots, in, channels, F, accum);
+    for (int c = 0; c < numSlots; ++c) {
+      // a mono patch feeds every slot, otherwise slot c is channel c or silent
+      const int from = (channels == 1) ? 0 : (c < channels) ? c : -1;
+      float peak = 0.0f;
+      for (int i = 0; i < F; ++i) {
+        const float x = (from < 0) ? 0.0f : in[from * F + i];
+        const float clipped = (x > 1.0f) ? 1.0f : (x < -1.0f) ? -1.0f : x;
+        const long got = (width == 16) ? out16[i * numSlots + c] : out32[i * numSlots + c];
+        const long expected = (width == 16) ? (hv_int16_t) (clipped * 32767.0f) : (hv_int32_t) (clipped * 2147483520.0f);
+        if (got != expected) ++wrong;
+        peak = fmaxf(peak, fabsf(x));
+      }
+      if (accum[c].peak != peak) ++wrong;
+    }
+    // and back: channel c reads slot c, channels beyond the slots are silent
+    if (width == 16) hAi_readS16(back, channels, out16, numSlots, F);
+    else hAi_readS32(back, channels, out32, numSlots, F);
+    for (int c = 0; c < channels; ++c) {
+      for (int i = 0; i < F; ++i) {
+        const float expected = (c >= numSlots) ? 0.0f : (width == 16) ?
+            (float) out16[i * numSlots + c] * (1.0f / 32768.0f) : (float) out32[i * numSlots + c] * (1.0f / 2147483648.0f);
+        if (back[c * F + i] != expected) ++wrong;
+      }
+    }
+  }
+  if (wrong) printf("%d channels in %d slots: %d samples or meters wrong\n", channels, numSlots, wrong);
+  return wrong;
+}
+
+// the generic loop, with a slot count the compiler can't see
+static __attribute__((noinline)) void generic_write(hv_int16_t *out, hv_uint32_t numSlots, const float *in,
+    hv_uint32_t numFrames, HvMeterAccum *accum) {
+  hAi_framesS16(out, numSlots, numSlots, in, numFrames, numFrames, accum);
+}
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// ns per block of hAi_writeS16() on numSlots channels, through its fast path and the generic loop
+static void time_write(int numSlots, int reps) {
+  static float in[MAX_SLOTS * BLOCK];
+  static hv_int16_t out[BLOCK * MAX_SLOTS];
+  volatile hv_uint32_t runtime_slots = (hv_uint32_t) numSlots;
+  HvMeterAccum accum[MAX_SLOTS];
+  for (int i = 0; i < numSlots * BLOCK; ++i) in[i] = layout_value(i / BLOCK, i % BLOCK, BLOCK);
+  double best[2] = { 1e9, 1e9 };
+  for (int rep = 0; rep < reps; ++rep) {
+    for (int generic = 0; generic < 2; ++generic) {
+      memset(accum, 0, sizeof(accum));
+      const double t0 = now();
+      if (generic) generic_write(out, runtime_slots, in, BLOCK, accum);
+      else hAi_writeS16(out, (hv_uint32_t) numSlots, in, (hv_uint32_t) numSlots, BLOCK, accum);
+      const double t = now() - t0;
+      if (t < best[generic]) best[generic] = t;
+    }
+  }
+  printf("%d slots, block of %d frames with meters: unrolled %.0f ns, generic %.0f ns\n",
+      numSlots, BLOCK, best[0] * 1e9, best[1] * 1e9);
+}
+
+int main(int argc, char **argv) {
+  int passes = 1000, overrun = -1, reps = 2000, opt;
+  while ((opt = getopt(argc, argv, "b:s:d:n:x:r:")) != -1) {
+    switch (opt) {
+      case 'b': bits = atoi(optarg); break;
+      case 's': slots = atoi(optarg); break;
+      case 'd': desc_num = atoi(optarg); break;
+      case 'n': passes = atoi(optarg); break;
+      case 'x': overrun = atoi(optarg); break;
+      case 'r': reps = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-b 16|32] [-s slots] [-d descriptors] [-n passes] [-x pass] [-r blocks]\n", argv[0]);
+        return 2;
+    }
+  }
+  const int bytes_per_sample = bits / 8;
+  int frames = BLOCK; // per DMA buffer
+  while (frames * slots * bytes_per_sample > DMA_BUFFER_MAX) frames /= 2;
+  const int per_block = BLOCK / frames;
+  if (desc_num == 0) desc_num = 2 * per_block;
+  if ((bits != 16 && bits != 32) || slots < 1 || slots > MAX_SLOTS || desc_num <= per_block || desc_num > MAX_DESC ||
+      reps < 1) {
+    fprintf(stderr, "-b is 16 or 32, -s is 1 to %d, -d is %d to %d, -r is positive\n", MAX_SLOTS, per_block + 1, MAX_DESC);
+    return 2;
+  }
+
+  // channels into slots: mono fanned out, as many as the slots, fewer, more, and no fast path
+  static const int layouts[][2] = {
+    { 1, 2 }, { 1, 4 }, { 1, 8 }, { 2, 2 }, { 4, 4 }, { 8, 8 },
+    { 3, 4 }, { 2, 8 }, { 6, 4 }, { 1, 3 }, { 3, 3 }, { 5, 6 },
+  };
+  const int num_layouts = (int) (sizeof(layouts) / sizeof(layouts[0]));
+  int bad_layouts = 0;
+  for (int j = 0; j < num_layouts; ++j) bad_layouts += (check_layout(layouts[j][0], layouts[j][1]) != 0);
+  printf("%d layouts of channels in slots, %d wrong\n", num_layouts, bad_layouts);
+  const size_t buffer_bytes = (size_t) frames * slots * bytes_per_sample;
+  tx_queue.n = rx_queue.n = desc_num - 1;
+
+  static float hv_in[MAX_SLOTS * BLOCK], hv_out[MAX_SLOTS * BLOCK];
+  static unsigned char samples[BLOCK * MAX_SLOTS * 4];
+  long click_out = -1, click_in = -1, round_trip = -1, latency = -1, captured = -1;
+  int clicks = 0, bad_trips = 0, bad_latencies = 0, bad_slots = 0, got = 0;
+  float level_error = 0.0f;
+  int pass = 0;
+  long busy = 0;
+
+  // period k: the DMA plays tx buffer k % desc_num onto DOUT, and the wire to DIN
+  // fills rx buffer k % desc_num with the same frames
+  for (long k = 0; pass < passes; ++k) {
+    const int d = (int) (k % desc_num);
+    memcpy(rx_dma[d], tx_dma[d], buffer_bytes);
+    for (int i = 0; i < frames * slots && click_out < 0; i += slots) {
+      const int nonzero = (bits == 16) ? ((hv_int16_t *) tx_dma[d])[i] != 0 : ((hv_int32_t *) tx_dma[d])[i] != 0;
+      if (nonzero) click_out = k * frames + i / slots;
+    }
+    memset(tx_dma[d], 0, buffer_bytes); // auto_clear
+    q_push(&rx_queue, k);
+    q_push(&tx_queue, k);
+
+    if (busy > 0) { --busy; continue; }
+    // i2s_channel_read() returns once it has a block's worth of buffers
+    long r;
+    while (got < per_block && (r = q_pop(&rx_queue)) >= 0) {
+      if (got == 0) captured = r * frames;
+      memcpy(samples + got * buffer_bytes, rx_dma[r % desc_num], buffer_bytes);
+      ++got;
+    }
+    if (got < per_block) continue;
+    got = 0;
+
+    // one pass of run_audio_loop()
+    if (bits == 16) hAi_readS16(hv_in, slots, (const hv_int16_t *) samples, slots, BLOCK);
+    else hAi_readS32(hv_in, slots, (const hv_int32_t *) samples, slots, BLOCK);
+    for (int i = 0; i < BLOCK; ++i) {
+      int arrived = 0;
+      for (int c = 0; c < slots; ++c) arrived |= (hv_in[c * BLOCK + i] != 0.0f);
+      if (!arrived) continue;
+      const long frame = captured + i;
+      // every slot comes back on its own channel, at its own level
+      for (int c = 0; c < slots; ++c) {
+        const float error = fabsf(hv_in[c * BLOCK + i] - CLICK(c));
+        if (clicks == 0) level_error = fmaxf(level_error, error);
+        if (error > 0.05f) ++bad_slots;
+      }
+      if (click_in >= 0) {
+        if (round_trip < 0) round_trip = frame - click_in;
+        else if (frame - click_in != round_trip) ++bad_trips;
+      }
+      click_in = frame;
+      ++clicks;
+    }
+    // pass-through patch, with a click on the first pass
+    memcpy(hv_out, hv_in, sizeof(hv_out));
+    if (pass == 0) for (int c = 0; c < slots; ++c) hv_out[c * BLOCK] = CLICK(c);
+    if (bits == 16) hAi_writeS16((hv_int16_t *) samples, slots, hv_out, slots, BLOCK, NULL);
+    else hAi_writeS32((hv_int32_t *) samples, slots, hv_out, slots, BLOCK, NULL);
+
+    // i2s_channel_write() fills the buffers that just played; it would block if
+    // there were too few, but in full duplex one frees with every one captured
+    for (int j = 0; j < per_block; ++j) {
+      const long t = q_pop(&tx_queue);
+      if (t < 0) { fprintf(stderr, "no TX buffer free on pass %d\n", pass); return 1; }
+      memcpy(tx_dma[t % desc_num], samples + j * buffer_bytes, buffer_bytes);
+      if (j > 0) continue;
+      // from the first frame read to the same frame leaving again
+      const long plays = t + desc_num;
+      if (latency < 0) latency = plays * frames - captured;
+      else if (plays * frames - captured != latency) ++bad_latencies;
+    }
+    if (pass == overrun) busy = per_block;
+    ++pass;
+  }
+
+  printf("%d-bit slots, %d slots, %d DMA buffers of %d frames each way, %d passes\n",
+      bits, slots, desc_num, frames, passes);
+  printf("DIN to DOUT: %ld frames (%.2f blocks) on every pass, %d passes off\n",
+      latency, latency / (double) BLOCK, bad_latencies);
+  printf("click left DOUT on frame %ld and came back %d times, every %ld frames, %d times off\n",
+      click_out, clicks, round_trip, bad_trips);
+  printf("level error after one trip %.3g, %d slots back on the wrong channel or level\n", level_error, bad_slots);
+
+  time_write(2, reps);
+  time_write(4, reps);
+  time_write(8, reps);
+
+  return (bad_layouts == 0 && bad_latencies == 0 && bad_trips == 0 && bad_slots == 0 && clicks > 0 &&
+      round_trip == latency) ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*
+ * Host test of the encoder acceleration (c2espidf/static/HvEncoder.h). A
+ * simulated counter stands in for PCNT: it counts countsPerDetent per detent
+ * of a turn at a steady rate, starting just below the top of its range so that
+ * it wraps, and hEn_update() polls it. Checks, in this order:
+ *   slow        2 detents/s for 5 s, across the wrap: exactly one step each
+ *   fast        50 detents/s for 1 s: accelerated, but to at most the maximum gain
+ *   reverse     2 detents/s backwards right after: slow single steps again
+ *   jitter      half a detent back and forth: never a step
+ *   no gain     50 detents/s with the acceleration off: exactly one step each
+ *
+ *   cc -O2 -Ic2espidf/static host/hvencoder.c c2espidf/static/HvEncoder.c -o hvencoder
+ *
+ *   hvencoder [-p poll] [-c counts]
+ *       -p  milliseconds between polls, a divisor of 1000 up to 500 (10)
+ *       -c  counts per detent (4)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "HvEncoder.h"
+
+#define THRESHOLD 5.0f
+#define ACCELERATION 0.2f
+#define MAX_GAIN 8.0f
+
+static int poll_ms = 10;
+static int counts_per_detent = 4;
+static int failures = 0;
+
+// the simulated counter and its clock, in microseconds
+typedef struct {
+  hv_int32_t count;
+  hv_int64_t time;
+} Counter;
+
+// turns at detents per second for ms and returns the sum of the steps reported
+static float turn(HvEncoder *e, Counter *c, int rate, int ms) {
+  float total = 0.0f;
+  long turned = 0; // whole detents so far, either way
+  for (int k = 0; k < ms / poll_ms; ++k) {
+    const long now = (long) rate * (k + 1) * poll_ms / 1000;
+    const int n = (int) (now - turned);
+    turned = now;
+    c->count = (hv_int32_t) ((hv_uint32_t) c->count + (hv_uint32_t) (n * counts_per_detent));
+    c->time += poll_ms * 1000;
+    total += hEn_update(e, c->count, c->time);
+  }
+  return total;
+}
+
+static void check(const char *name, float got, float min, float max) {
+  const int ok = (got >= min && got <= max);
+  if (min == max) printf("%-9s %g steps, expected %g%s\n", name, got, min, ok ? "" : "  FAIL");
+  else printf("%-9s %g steps, expected %g to %g%s\n", name, got, min, max, ok ? "" : "  FAIL");
+  if (!ok) ++failures;
+}
+
+int main(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "p:c:")) != -1) {
+    switch (opt) {
+      case 'p': poll_ms = atoi(optarg); break;
+      case 'c': counts_per_detent = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-p poll] [-c counts]\n", argv[0]);
+        return 2;
+    }
+  }
+  // each turn lasts whole polls, and half a detent must be a whole count
+  if (poll_ms < 1 || poll_ms > 500 || 1000 % poll_ms || counts_per_detent < 2 || counts_per_detent % 2) {
+    fprintf(stderr, "-p divides 1000 and is at most 500, -c is even and at least 2\n");
+    return 2;
+  }
+
+  Counter c = { 0x7FFFFFFF - 100, 0 };
+  HvEncoder e;
+  hEn_init(&e, c.count, c.time, counts_per_detent, THRESHOLD, ACCELERATION, MAX_GAIN);
+  check("slow", turn(&e, &c, 2, 5000), 10.0f, 10.0f);
+  check("fast", turn(&e, &c, 50, 1000), 50.5f, 50.0f * MAX_GAIN);
+  check("reverse", turn(&e, &c, -2, 1000), -2.0f, -2.0f);
+
+  float jitter = 0.0f;
+  for (int k = 0; k < 100; ++k) {
+    c.count += (k & 1) ? -counts_per_detent / 2 : counts_per_detent / 2;
+    c.time += poll_ms * 1000;
+    jitter += hEn_update(&e, c.count, c.time);
+  }
+  check("jitter", jitter, 0.0f, 0.0f);
+
+  Counter d = { 0, 0 };
+  HvEncoder f;
+  hEn_init(&f, d.count, d.time, counts_per_detent, THRESHOLD, 0.0f, MAX_GAIN);
+  check("no gain", turn(&f, &d, 50, 1000), 50.0f, 50.0f);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Cross-check of the generator's hash: c2espidf.py hashes the patch's symbols in
+ * Python for hv_staticSymbols and the receiver and parameter constants, and
+ * hv_string_to_hash() must agree with it in C, or those constants never match.
+ * The table below is the Python function's output, non-ASCII tails included; the
+ * static symbols of the generated runtime are checked too.
+ *
+ *   cc -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvhash.c main/hvcc/c/HvStaticSymbols.c main/hvcc/c/HvUtils.c -o hvhash
+ *
+ *   hvhash
+ *       Runs every check and prints the ones that fail.
+ *
+ * When c2espidf.hv_string_to_hash() changes, reprint the table from it and rerun.
+ */
+#include <stdio.h>
+
+#include "HvSymbolTable.h"
+
+// from c2espidf.hv_string_to_hash()
+static const struct { hv_uint32_t hash; const char *str; } expected[] = {
+    { 0x00000000, "" }, // empty
+    { 0x92685F5E, "a" }, // a
+    { 0x1AA14063, "ab" }, // ab
+    { 0x13577C9B, "abc" }, // abc
+    { 0x26873021, "abcd" }, // abcd
+    { 0x3A6EC41A, "knob1" }, // knob1
+    { 0xE293B681, "\x7F" }, // 
+    { 0x20A5A987, "\xC3\xA9" }, // é
+    { 0x76077756, "\xE2\x82\xAC" }, // €
+    { 0x206C7DD1, "a\xC3\xA9" }, // aé
+    { 0x8D22FEF2, "\xC3\xA9" "1" }, // é1
+    { 0x8880CDE4, "\xC3\xBF" "a" }, // ÿa
+    { 0x76209E99, "na\xC3\xAFve" }, // naïve
+    { 0xAF205B04, "\xE6\x97\xA5\xE6\x9C\xAC" }, // 日本
+    { 0x0CC732EE, "Gr\xC3\xBC\xC3\x9F" "e" }, // Grüße
+    { 0xA771FDD5, "\xC3\xA9\xC3\xA9" }, // éé
+    { 0xE65C5170, "\xC3\xA9\xC3\xA9\xC3\xA9" }, // ééé
+    { 0xB3A64BCD, "\xC2\xBFqu\xC3\xA9?" }, // ¿qué?
+    { 0x284BF43F, "\xF0\x9F\x8E\x9B" }, // 🎛
+    { 0x115991B2, "\xF0\x9F\x8E\x9Bx" }, // 🎛x
+    { 0x210284F4, "kn\xC3\xB6" "b" }, // knöb
+    { 0xB30A5889, "kn\xC3\xB6" "b1" }, // knöb1
+    { 0xC37270A8, "pitch\xE2\x86\x92" }, // pitch→
+};
+
+int main(void) {
+  int failures = 0;
+  for (int i = 0; i < (int) (sizeof(expected) / sizeof(expected[0])); ++i) {
+    const hv_uint32_t h = hv_string_to_hash(expected[i].str);
+    if (h != expected[i].hash) {
+      fprintf(stderr, "\"%s\": 0x%08X, the generator has 0x%08X\n", expected[i].str, h, expected[i].hash);
+      ++failures;
+    }
+  }
+  for (int i = 0; i < hv_numStaticSymbols; ++i) {
+    const HvSymbol *s = &hv_staticSymbols[i];
+    if (hv_string_to_hash(s->str) != s->hash) {
+      fprintf(stderr, "static symbol \"%s\": 0x%08X, the generator has 0x%08X\n", s->str, hv_string_to_hash(s->str), s->hash);
+      ++failures;
+    }
+    if (i > 0 && hv_staticSymbols[i-1].hash > s->hash) {
+      fprintf(stderr, "static symbol \"%s\" is out of order\n", s->str);
+      ++failures;
+    }
+  }
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("all passed\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Host test of the knob filter (c2espidf/static/HvKnobFilter.h) on simulated
+ * 12-bit ADC readings with uniform noise, as the driver feeds it:
+ *   resting  a knob held mid-travel reports one value and then stays quiet
+ *   ends     a knob resting near 0 snaps to exactly 0 and never leaves it
+ *   sweep    a knob turned up and down reaches exactly 1 and 0, and the value
+ *            only moves the way it is turned
+ *
+ *   cc -O2 -Ic2espidf/static host/hvknob.c c2espidf/static/HvKnobFilter.c -o hvknob
+ *
+ *   hvknob [-n updates] [-s samples] [-a noise]
+ *       -n  updates the resting knobs are held for (10000)
+ *       -s  samples averaged per update (64)
+ *       -a  noise on each sample, in raw codes either way (20)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "HvKnobFilter.h"
+
+#define FULL_SCALE 4095
+#define HYSTERESIS 0.002f
+#define DEADBAND 0.01f
+
+static int samples = 64;
+static int noise = 20;
+static unsigned int seed = 3;
+
+// a knob's readings for one update, at raw plus noise
+static void add_readings(HvKnobFilter *f, hv_uint32_t channel, int raw) {
+  for (int i = 0; i < samples; ++i) {
+    int s = raw + (int) (rand_r(&seed) % (2 * noise + 1)) - noise;
+    s = (s < 0) ? 0 : (s > FULL_SCALE) ? FULL_SCALE : s;
+    hKf_add(f, channel, (hv_uint32_t) s);
+  }
+}
+
+int main(int argc, char **argv) {
+  int updates = 10000, opt;
+  while ((opt = getopt(argc, argv, "n:s:a:")) != -1) {
+    switch (opt) {
+      case 'n': updates = atoi(optarg); break;
+      case 's': samples = atoi(optarg); break;
+      case 'a': noise = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n updates] [-s samples] [-a noise]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (updates < 1 || samples < 1 || noise < 0) {
+    fprintf(stderr, "-n and -s are positive, -a is not negative\n");
+    return 2;
+  }
+
+  HvKnobFilter f;
+  hKf_init(&f, 2, FULL_SCALE, HYSTERESIS, DEADBAND);
+  float v = -1.0f, w = -1.0f;
+  const int empty_ok = !hKf_update(&f, 0, &v); // nothing added yet
+
+  // knob 0 rests in the middle, knob 1 just above the bottom
+  int resting = 0, end_moves = 0, end_wrong = 0;
+  for (int u = 0; u < updates; ++u) {
+    add_readings(&f, 0, FULL_SCALE / 2);
+    add_readings(&f, 1, 10);
+    if (hKf_update(&f, 0, &v)) ++resting;
+    if (hKf_update(&f, 1, &w)) {
+      ++end_moves;
+      if (w != 0.0f) ++end_wrong;
+    }
+  }
+  printf("resting mid-travel: %d of %d updates moved (to %f)\n", resting, updates, v);
+  printf("resting near 0: %d moved, %d not to 0\n", end_moves, end_wrong);
+
+  // knob 0 turned down to 0, then all the way up and back down in steps of 4 codes per update
+  add_readings(&f, 0, 0);
+  hKf_update(&f, 0, &v);
+  int moves = 0, backwards = 0;
+  float top = -1.0f;
+  for (int dir = 0; dir < 2; ++dir) {
+    for (int r = 0; r <= FULL_SCALE + 100; r += 4) {
+      const int raw = dir ? FULL_SCALE - r : r;
+      add_readings(&f, 0, raw < 0 ? 0 : raw > FULL_SCALE ? FULL_SCALE : raw);
+      const float last = v;
+      if (!hKf_update(&f, 0, &v)) continue;
+      ++moves;
+      if (dir ? (v > last) : (v < last)) ++backwards;
+    }
+    if (dir == 0) top = v;
+  }
+  printf("sweep: %d moves, %d backwards, top %f, bottom %f\n", moves, backwards, top, v);
+  hKf_free(&f);
+
+  return (empty_ok && resting == 1 && end_moves == 1 && end_wrong == 0 &&
+      backwards == 0 && top == 1.0f && v == 0.0f) ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+/*
+ * Host test of latest-wins receivers (hv_setReceiverLatestWins()) and of the
+ * parameter bank (hv_setParameterValue()) in HeavyContext, which both queue a
+ * marker for the first value and deliver the latest one in its place. A
+ * stand-in patch with two plain receivers and an @hv_param one logs what each
+ * is sent. Floats, bangs, lists, batches, delayed and hash-addressed messages
+ * are mixed with the values, and each case checks the order they arrive in
+ * within a block: the newest value must win, in the place of the first one it
+ * replaced, and nothing sent before or after it may change sides. Then a
+ * producer thread sends a counting value and, now and then, a list carrying
+ * the count, while the main thread runs blocks: the values must only ever
+ * count up, end on the last one sent, and never be older at a list than the
+ * count it carries. This runs once for each kind of slot.
+ *
+ *   c++ -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvlatest.cpp main/hvcc/c/H*.c main/hvcc/c/H*.cpp -lpthread -o hvlatest
+ *
+ *   hvlatest [-n values]
+ *       -n  values the producer thread sends to each kind of slot (1000000)
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "HeavyContext.hpp"
+
+#define BLOCK 64
+#define HASH_R 0x1234u
+#define HASH_S 0x5678u
+#define HASH_P 0x9ABCu
+#define LIST_EVERY 7
+#define MAX_LISTS_AHEAD 64 // lists queued but not delivered, well within the queue
+
+static void receiveR(HeavyContextInterface *c, int letIn, const HvMessage *m);
+static void receiveS(HeavyContextInterface *c, int letIn, const HvMessage *m);
+static void receiveP(HeavyContextInterface *c, int letIn, const HvMessage *m);
+
+class Patch : public HeavyContext {
+ public:
+  Patch() : HeavyContext(48000.0, 64, 64, 0) {
+    table.numReceivers = 3;
+    table.hashes = hashes;
+    table.hashOrder = order;
+    table.offsets = offsets;
+    table.targets = targets;
+    initReceiverTable(&table);
+    initParameterBank();
+  }
+
+  const char *getName() override { return "latest"; }
+  int getNumInputChannels() override { return 0; }
+  int getNumOutputChannels() override { return 0; }
+  int getParameterInfo(int index, HvParameterInfo *info) override {
+    if (info != nullptr) *info = { "p", HASH_P, HvParameterType::HV_PARAM_TYPE_PARAMETER_IN, 0.0f, 1.0f, 0.0f };
+    return 1;
+  }
+
+  // delivers the messages of one block, like a generated process() without signals
+  int process(float **inputBuffers, float **outputBuffers, int n) override {
+    processInputQueue();
+    const hv_uint32_t nextBlock = blockStartTimestamp + n;
+    while (mq_hasMessageBefore(&mq, nextBlock)) {
+      MessageNode *const node = mq_peek(&mq);
+      node->sendMessage(this, node->let, node->m);
+      mq_pop(&mq);
+    }
+    blockStartTimestamp = nextBlock;
+    return n;
+  }
+  int processInline(float *inputBuffers, float *outputBuffers, int n) override { return process(nullptr, nullptr, n); }
+  int processInlineInterleaved(float *inputBuffers, float *outputBuffers, int n) override { return process(nullptr, nullptr, n); }
+
+  std::string log; // what the receivers got, s: and p: marking receivers S and P
+
+  // the stress test's view of the receiver under test
+  float lastFloat = 0.0f;
+  long floats = 0, lists = 0, wrong = 0;
+  std::atomic<long> listsDelivered{0};
+  bool stress = false;
+
+ protected:
+  HvTable *getTableForHash(hv_uint32_t tableHash) override { return nullptr; }
+  void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override {
+    switch (receiverHash) {
+      case HASH_R: mq_addMessageByTimestamp(&mq, m, 0, &receiveR); break;
+      case HASH_S: mq_addMessageByTimestamp(&mq, m, 0, &receiveS); break;
+      case HASH_P: mq_addMessageByTimestamp(&mq, m, 0, &receiveP); break;
+      default: return;
+    }
+  }
+
+ private:
+  static constexpr hv_uint32_t hashes[3] = { HASH_R, HASH_S, HASH_P };
+  static constexpr hv_uint32_t order[3] = { 0, 1, 2 };
+  static constexpr hv_uint32_t offsets[4] = { 0, 1, 2, 3 };
+  static constexpr HvReceiverTarget_t *targets[3] = { &receiveR, &receiveS, &receiveP };
+  HvReceiverTable table;
+};
+
+static void logMessage(Patch *p, const char *prefix, const HvMessage *m) {
+  char s[32];
+  if (msg_isBang(m, 0)) snprintf(s, sizeof(s), "%sb ", prefix);
+  else if (msg_getNumElements(m) == 1) snprintf(s, sizeof(s), "%s%g ", prefix, msg_getFloat(m, 0));
+  else snprintf(s, sizeof(s), "%s[%g] ", prefix, msg_getFloat(m, 0));
+  p->log += s;
+}
+
+// R and P, either of which the stress test runs on
+static void receive(Patch *p, const char *prefix, const HvMessage *m) {
+  if (!p->stress) {
+    logMessage(p, prefix, m);
+  } else if (msg_getNumElements(m) == 1) {
+    // counting up, never back
+    if (msg_getFloat(m, 0) <= p->lastFloat) ++p->wrong;
+    p->lastFloat = msg_getFloat(m, 0);
+    ++p->floats;
+  } else {
+    // the list was sent after the float of its count, so that float or a newer one is in
+    if (p->lastFloat < msg_getFloat(m, 0)) ++p->wrong;
+    ++p->lists;
+    p->listsDelivered.store(p->lists, std::memory_order_release);
+  }
+}
+
+static void receiveR(HeavyContextInterface *c, int letIn, const HvMessage *m) {
+  receive(static_cast<Patch *>(c), "", m);
+}
+
+static void receiveS(HeavyContextInterface *c, int letIn, const HvMessage *m) {
+  logMessage(static_cast<Patch *>(c), "s:", m);
+}
+
+static void receiveP(HeavyContextInterface *c, int letIn, const HvMessage *m) {
+  receive(static_cast<Patch *>(c), "p:", m);
+}
+
+static HvMessage *list(HvMessage *m, float f) {
+  msg_init(m, 2, 0);
+  msg_setFloat(m, 0, f);
+  msg_setFloat(m, 1, f);
+  return m;
+}
+
+static int failures = 0;
+
+// runs a block and compares what was delivered in it
+static void expect(Patch &p, const char *name, const char *expected) {
+  p.log.clear();
+  p.process(nullptr, nullptr, BLOCK);
+  if (!p.log.empty()) p.log.pop_back();
+  const bool ok = (p.log == expected);
+  printf("%-16s %-16s%s\n", name, p.log.c_str(), ok ? "" : "  FAIL");
+  if (!ok) {
+    printf("  expected %s\n", expected);
+    ++failures;
+  }
+}
+
+static void check_cases() {
+  Patch p;
+  p.setReceiverLatestWins(0, true);
+  p.setReceiverLatestWins(1, true);
+  HvMessage *m = HV_MESSAGE_ON_STACK(2);
+
+  p.sendBangToReceiverIndex(0);
+  p.sendFloatToReceiverIndex(0, 1.0f);
+  p.sendFloatToReceiverIndex(0, 2.0f);
+  expect(p, "bang first", "b 2");
+
+  p.sendFloatToReceiverIndex(0, 1.0f);
+  p.sendBangToReceiverIndex(0);
+  p.sendFloatToReceiverIndex(0, 2.0f);
+  expect(p, "float first", "2 b");
+
+  p.sendFloatToReceiverIndex(0, 1.0f);
+  p.sendMessageToReceiverIndex(0, 0.0f, list(m, 3.0f));
+  p.sendFloatToReceiverIndex(0, 2.0f);
+  expect(p, "list between", "2 [3]");
+
+  msg_initWithFloat(m, 0, 5.0f);
+  HvEvent e = { 0, 0, m, 0 };
+  p.sendBatch(&e, 1);
+  p.sendFloatToReceiverIndex(0, 6.0f);
+  p.sendFloatToReceiverIndex(0, 7.0f);
+  expect(p, "batch first", "5 7");
+
+  p.sendFloatToReceiverIndex(0, 6.0f);
+  p.sendBatch(&e, 1);
+  expect(p, "batch after", "6 5");
+
+  // a float delayed by a block is due at the start of the next, where the newest float follows it
+  msg_initWithFloat(m, 0, 3.0f);
+  p.sendMessageToReceiverIndex(0, 1000.0f * BLOCK / 48000.0f, m);
+  expect(p, "delayed", "");
+  p.sendFloatToReceiverIndex(0, 8.0f);
+  p.sendFloatToReceiverIndex(0, 9.0f);
+  expect(p, "delayed due", "3 9");
+
+  msg_initWithBang(m, 0);
+  p.sendMessageAtSample(HASH_R, 0, m);
+  p.sendFloatToReceiver(HASH_R, 1.0f);
+  p.sendFloatToReceiver(HASH_R, 2.0f);
+  expect(p, "by hash", "b 2");
+
+  p.sendFloatToReceiverIndex(0, 1.0f);
+  p.sendFloatToReceiverIndex(1, 10.0f);
+  p.sendFloatToReceiverIndex(0, 2.0f);
+  p.sendFloatToReceiverIndex(1, 11.0f);
+  expect(p, "two receivers", "2 s:11");
+
+  p.sendFloatToReceiverIndex(0, 1.0f);
+  p.setReceiverLatestWins(0, false);
+  p.sendBangToReceiverIndex(0);
+  p.sendFloatToReceiverIndex(0, 2.0f);
+  p.sendFloatToReceiverIndex(0, 3.0f);
+  expect(p, "switched off", "1 b 2 3");
+
+  p.setReceiverLatestWins(0, true);
+  p.sendFloatToReceiverIndex(0, 1.0f);
+  expect(p, "on again", "1");
+  p.sendFloatToReceiverIndex(0, 2.0f);
+  p.sendFloatToReceiverIndex(0, 3.0f);
+  expect(p, "next block", "3");
+
+  // receiver 2 is the parameter's, and not latest-wins itself
+  p.sendFloatToReceiverIndex(2, 0.5f);
+  p.setParameterValue(0, 0.25f);
+  expect(p, "param after", "p:0.5 p:0.25");
+
+  p.setParameterValue(0, 0.1f);
+  p.sendBangToReceiverIndex(2);
+  p.setParameterValue(0, 0.2f);
+  expect(p, "param first", "p:0.2 p:b");
+
+  // any message to the receiver, by index or by hash, makes the bank send the value again
+  p.setParameterValue(0, 0.2f);
+  expect(p, "param after bang", "p:0.2");
+  p.setParameterValue(0, 0.2f);
+  expect(p, "param same", "");
+  p.sendFloatToReceiver(HASH_P, 0.7f);
+  p.setParameterValue(0, 0.3f);
+  p.setParameterValue(0, 0.2f);
+  expect(p, "param by hash", "p:0.7 p:0.2");
+
+  p.sendMessageAtSample(HASH_P, 0, list(m, 0.9f));
+  p.setParameterValue(0, 0.2f);
+  expect(p, "param at sample", "p:[0.9] p:0.2");
+}
+
+// counts up on latest-wins receiver R, or on the parameter of P
+static void check_threads(long n, bool parameter) {
+  Patch p;
+  p.stress = true;
+  p.setReceiverLatestWins(0, true);
+  const hv_uint32_t receiver = parameter ? 2 : 0;
+  std::atomic<bool> done{false};
+  long listsSent = 0;
+  std::thread producer([&] {
+    HvMessage *m = HV_MESSAGE_ON_STACK(2);
+    for (long i = 1; i <= n; ++i) {
+      if (parameter) p.setParameterValue(0, (float) i);
+      else p.sendFloatToReceiverIndex(0, (float) i);
+      if (i % LIST_EVERY) continue;
+      // the audio side keeps the queue short, so the marker of the next value always fits
+      while (listsSent - p.listsDelivered.load(std::memory_order_acquire) >= MAX_LISTS_AHEAD) sched_yield();
+      HvEvent e = { 0, receiver, list(m, (float) i), 0 };
+      while (p.sendBatch(&e, 1) == 0) sched_yield();
+      ++listsSent;
+    }
+    done.store(true, std::memory_order_release);
+  });
+  long blocks = 0;
+  while (!done.load(std::memory_order_acquire)) {
+    p.process(nullptr, nullptr, BLOCK);
+    ++blocks;
+    sched_yield(); // blocks come far apart on the device, let the producer run
+  }
+  producer.join();
+  p.process(nullptr, nullptr, BLOCK);
+  printf("%ld %s and %ld lists sent: %ld values and %ld lists delivered in %ld blocks, last %g, %ld out of order\n",
+      n, parameter ? "parameter values" : "latest-wins floats", listsSent, p.floats, p.lists, blocks + 1,
+      p.lastFloat, p.wrong);
+  if (p.wrong || p.lists != listsSent || p.lastFloat != (float) n) ++failures;
+}
+
+int main(int argc, char **argv) {
+  long n = 1000000;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n': n = atol(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n values]\n", argv[0]);
+        return 2;
+    }
+  }
+  // values count exactly up to 2^24
+  if (n < 1 || n > (1L << 24)) {
+    fprintf(stderr, "-n is 1 to %ld\n", 1L << 24);
+    return 2;
+  }
+
+  check_cases();
+  check_threads(n, false);
+  check_threads(n, true);
+  return failures ? 1 : 0;
+}
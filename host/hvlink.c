@@ -0,0 +1,289 @@
+/*
+ * Host side of the control link (c2espidf/static/HvControlLink.h): streams
+ * receiver and parameter updates to the board over a serial port.
+ *
+ * Build:  cc -O2 -Ic2espidf/static host/hvlink.c c2espidf/static/HvControlLink.c -lpthread -lm -o hvlink
+ *
+ *   hvlink send <tty> [baud]
+ *       Sends "<index> <value>" lines from stdin, "p<index>" for a parameter.
+ *       The lines of each read are batched into frames.
+ *   hvlink sweep <tty> <baud> <rate> <index>...
+ *       Streams a 1 Hz sine in [0, 1] to each index, <rate> updates per second in all.
+ *   hvlink loopback [updates]
+ *       Sends frames through a pty into the parser the board uses, with some of
+ *       them corrupted, and checks what comes out.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HvControlLink.h"
+
+#define DEFAULT_BAUD 921600
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static speed_t baud_constant(long baud) {
+  switch (baud) {
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    default: return 0;
+  }
+}
+
+static int open_port(const char *path, long baud) {
+  const speed_t speed = baud_constant(baud);
+  if (speed == 0) {
+    fprintf(stderr, "hvlink: unsupported baud rate %ld\n", baud);
+    return -1;
+  }
+  const int fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    fprintf(stderr, "hvlink: %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  struct termios t;
+  tcgetattr(fd, &t);
+  cfmakeraw(&t);
+  cfsetispeed(&t, speed);
+  cfsetospeed(&t, speed);
+  t.c_cflag |= CLOCAL | CREAD;
+  t.c_cflag &= ~(CRTSCTS | CSTOPB);
+  tcsetattr(fd, TCSANOW, &t);
+  return fd;
+}
+
+static int write_all(int fd, const hv_uint8_t *p, size_t n) {
+  while (n > 0) {
+    const ssize_t w = write(fd, p, n);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += w;
+    n -= (size_t) w;
+  }
+  return 0;
+}
+
+typedef struct {
+  int fd;
+  hv_uint8_t seq;
+  hv_uint32_t count;
+  HvControlUpdate updates[HV_CONTROL_LINK_MAX_UPDATES];
+} Sender;
+
+static int flush_frame(Sender *s) {
+  if (s->count == 0) return 0;
+  hv_uint8_t frame[HV_CONTROL_LINK_MAX_FRAME];
+  const hv_uint32_t n = hCl_encode(frame, s->seq++, s->updates, s->count);
+  s->count = 0;
+  return write_all(s->fd, frame, n);
+}
+
+static int add_update(Sender *s, hv_uint16_t index, float value) {
+  s->updates[s->count].index = index;
+  s->updates[s->count].value = value;
+  return (++s->count == HV_CONTROL_LINK_MAX_UPDATES) ? flush_frame(s) : 0;
+}
+
+static int parse_index(const char *s, hv_uint16_t *index) {
+  const int param = (*s == 'p');
+  char *end;
+  const long i = strtol(s + param, &end, 10);
+  if (end == s + param || i < 0 || i >= HV_CONTROL_LINK_PARAMETER) return -1;
+  *index = (hv_uint16_t) (i | (param ? HV_CONTROL_LINK_PARAMETER : 0));
+  return 0;
+}
+
+static int cmd_send(const char *path, long baud) {
+  Sender s = { .fd = open_port(path, baud) };
+  if (s.fd < 0) return 1;
+  char buf[4096];
+  size_t have = 0;
+  ssize_t r;
+  while ((r = read(STDIN_FILENO, buf + have, sizeof(buf) - 1 - have)) > 0) {
+    have += (size_t) r;
+    buf[have] = '\0';
+    char *line = buf, *nl;
+    while ((nl = strchr(line, '\n')) != NULL) {
+      *nl = '\0';
+      char name[32];
+      float value;
+      hv_uint16_t index;
+      if (sscanf(line, "%31s %f", name, &value) == 2 && parse_index(name, &index) == 0) {
+        if (add_update(&s, index, value) != 0) return 1;
+      } else if (*line != '\0') {
+        fprintf(stderr, "hvlink: ignoring '%s'\n", line);
+      }
+      line = nl + 1;
+    }
+    have -= (size_t) (line - buf);
+    memmove(buf, line, have);
+    if (have == sizeof(buf) - 1) have = 0; // a line too long to be an update
+    if (flush_frame(&s) != 0) return 1;
+  }
+  flush_frame(&s);
+  tcdrain(s.fd);
+  close(s.fd);
+  return 0;
+}
+
+static int cmd_sweep(const char *path, long baud, double rate, int numIndices, char **names) {
+  hv_uint16_t indices[HV_CONTROL_LINK_MAX_UPDATES];
+  if (numIndices > HV_CONTROL_LINK_MAX_UPDATES) numIndices = HV_CONTROL_LINK_MAX_UPDATES;
+  for (int i = 0; i < numIndices; ++i) {
+    if (parse_index(names[i], &indices[i]) != 0) {
+      fprintf(stderr, "hvlink: bad index '%s'\n", names[i]);
+      return 1;
+    }
+  }
+  Sender s = { .fd = open_port(path, baud) };
+  if (s.fd < 0) return 1;
+  // one frame of an update per index, as often as the rate allows
+  const double period = numIndices / rate;
+  const double start = now();
+  double next = start, report = start + 1.0;
+  unsigned long sent = 0, frames = 0;
+  while (1) {
+    const double t = now();
+    if (t < next) {
+      const double wait = next - t;
+      const struct timespec ts = { (time_t) wait, (long) ((wait - (time_t) wait) * 1e9) };
+      nanosleep(&ts, NULL);
+      continue;
+    }
+    next += period;
+    for (int i = 0; i < numIndices; ++i) add_update(&s, indices[i], 0.5f + 0.5f * sinf((float) (2.0 * M_PI * (t - start))));
+    if (flush_frame(&s) != 0) return 1;
+    sent += (unsigned long) numIndices;
+    frames++;
+    if (t >= report) {
+      fprintf(stderr, "%lu updates/s in %lu frames\n", sent, frames);
+      sent = frames = 0;
+      report += 1.0;
+    }
+  }
+}
+
+// loopback: frame f carries the updates f * UPDATES_PER_FRAME onwards, and every CORRUPT_EVERY-th has a value byte flipped
+#define UPDATES_PER_FRAME 32
+#define CORRUPT_EVERY 97
+
+typedef struct {
+  int fd;
+  unsigned long frames;
+} Writer;
+
+static HvControlUpdate expected_update(unsigned long n) {
+  HvControlUpdate u = { (hv_uint16_t) (n % 200), (float) n * 0.25f };
+  if (n % 3 == 0) u.index |= HV_CONTROL_LINK_PARAMETER;
+  return u;
+}
+
+static void *loopback_writer(void *arg) {
+  Writer *w = (Writer *) arg;
+  hv_uint8_t frame[HV_CONTROL_LINK_MAX_FRAME];
+  HvControlUpdate updates[UPDATES_PER_FRAME];
+  for (unsigned long f = 0; f < w->frames; ++f) {
+    for (int i = 0; i < UPDATES_PER_FRAME; ++i) updates[i] = expected_update(f * UPDATES_PER_FRAME + i);
+    const hv_uint32_t n = hCl_encode(frame, (hv_uint8_t) f, updates, UPDATES_PER_FRAME);
+    if (f % CORRUPT_EVERY == CORRUPT_EVERY - 1) frame[6] ^= 0x10;
+    if (write_all(w->fd, frame, n) != 0) break;
+  }
+  return NULL;
+}
+
+static int cmd_loopback(unsigned long updates) {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    fprintf(stderr, "hvlink: no pty: %s\n", strerror(errno));
+    return 1;
+  }
+  const int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  struct termios t;
+  tcgetattr(slave, &t);
+  cfmakeraw(&t);
+  tcsetattr(slave, TCSANOW, &t);
+
+  Writer w = { master, (updates + UPDATES_PER_FRAME - 1) / UPDATES_PER_FRAME };
+  const unsigned long corrupted = w.frames / CORRUPT_EVERY;
+  HvControlLink link;
+  hCl_init(&link);
+  const double start = now();
+  pthread_t thread;
+  pthread_create(&thread, NULL, loopback_writer, &w);
+
+  hv_uint8_t buf[512];
+  unsigned long frame = 0, received = 0, mismatches = 0;
+  double parse_time = 0.0;
+  while (frame < w.frames && hCl_getFrameCount(&link) + hCl_getBadFrameCount(&link) < w.frames) {
+    const ssize_t r = read(slave, buf, sizeof(buf));
+    if (r <= 0) break;
+    const double t0 = now();
+    for (hv_uint32_t used = 0; used < (hv_uint32_t) r; ) {
+      hv_uint32_t n = 0;
+      used += hCl_parse(&link, buf + used, (hv_uint32_t) r - used, &n);
+      if (n == 0) continue;
+      // the corrupted frames are expected to be missing
+      while (frame % CORRUPT_EVERY == CORRUPT_EVERY - 1) frame++;
+      for (hv_uint32_t i = 0; i < n; ++i) {
+        const HvControlUpdate want = expected_update(frame * UPDATES_PER_FRAME + i);
+        const HvControlUpdate got = hCl_getUpdate(&link, i);
+        if (got.index != want.index || got.value != want.value) mismatches++;
+      }
+      received += n;
+      frame++;
+    }
+    parse_time += now() - t0;
+  }
+  const double elapsed = now() - start;
+  pthread_join(thread, NULL);
+  close(slave);
+  close(master);
+
+  const unsigned long good = w.frames - corrupted;
+  printf("%lu frames sent, %lu corrupted\n", w.frames, corrupted);
+  printf("%u good, %u bad, %u lost, %lu updates received, %lu mismatched\n",
+      hCl_getFrameCount(&link), hCl_getBadFrameCount(&link), hCl_getLostFrameCount(&link), received, mismatches);
+  printf("%.0f updates/s through the pty, parser %.1f M updates/s\n",
+      received / elapsed, received / parse_time * 1e-6);
+  const int ok = hCl_getFrameCount(&link) == good && hCl_getBadFrameCount(&link) == corrupted
+      && hCl_getLostFrameCount(&link) == corrupted && received == good * UPDATES_PER_FRAME && mismatches == 0;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 3 && strcmp(argv[1], "send") == 0) {
+    return cmd_send(argv[2], (argc > 3) ? atol(argv[3]) : DEFAULT_BAUD);
+  }
+  if (argc >= 6 && strcmp(argv[1], "sweep") == 0) {
+    return cmd_sweep(argv[2], atol(argv[3]), atof(argv[4]), argc - 5, argv + 5);
+  }
+  if (argc >= 2 && strcmp(argv[1], "loopback") == 0) {
+    return cmd_loopback((argc > 2) ? strtoul(argv[2], NULL, 10) : 1000000);
+  }
+  fprintf(stderr,
+      "usage: hvlink send <tty> [baud]\n"
+      "       hvlink sweep <tty> <baud> <rate> <index>...\n"
+      "       hvlink loopback [updates]\n");
+  return 2;
+}
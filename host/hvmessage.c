@@ -0,0 +1,217 @@
+/*
+ * Host test of HvMessage (c2espidf/static/HvMessage.h): builds float, symbol,
+ * bang, hash and mixed messages with the msg_* setters, reads them back, copies
+ * them with msg_copy() and msg_copyToBuffer(), and prints them with
+ * msg_toString() and msg_toStringBuf(). Floats are also formatted against
+ * printf("%g"), and symbols with colliding hashes are compared.
+ *
+ * Build against a generated runtime, whose static symbols the strings are
+ * resolved with:
+ *   cc -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvmessage.c main/hvcc/c/HvMessage.c \
+ *      main/hvcc/c/HvSymbolTable.c main/hvcc/c/HvStaticSymbols.c main/hvcc/c/HvUtils.c -lpthread -o hvmessage
+ *
+ *   hvmessage
+ *       Runs every check and prints the ones that fail.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "HvMessage.h"
+
+static int failures = 0;
+
+#define CHECK(_c) do { if (!(_c)) { fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #_c); ++failures; } } while (0)
+
+// the message's text through both msg_toString() and msg_toStringBuf()
+static void check_text(const HvMessage *m, const char *expected) {
+  char *s = msg_toString(m);
+  if (strcmp(s, expected)) { fprintf(stderr, "msg_toString: \"%s\", expected \"%s\"\n", s, expected); ++failures; }
+  hv_free(s);
+
+  const hv_size_t len = (hv_size_t) strlen(expected);
+  char buf[64];
+  CHECK(msg_toStringBuf(m, NULL, 0) == len);
+  CHECK(msg_toStringBuf(m, buf, sizeof(buf)) == len && !strcmp(buf, expected));
+  // truncated like snprintf(), still null-terminated
+  memset(buf, 'x', sizeof(buf));
+  CHECK(msg_toStringBuf(m, buf, 4) == len && strlen(buf) == (len < 3 ? len : 3) && !strncmp(buf, expected, 3));
+}
+
+// every element of m equals the same element of n
+static void check_equal(const HvMessage *m, const HvMessage *n) {
+  CHECK(msg_getNumElements(m) == msg_getNumElements(n));
+  CHECK(msg_getTimestamp(m) == msg_getTimestamp(n));
+  for (int i = 0; i < msg_getNumElements(m); ++i) {
+    CHECK(msg_getType(m, i) == msg_getType(n, i));
+    CHECK(msg_equalsElement(m, i, n, i));
+  }
+}
+
+// a heap copy and a copy into a buffer of just the right size, both equal to m
+static void check_copies(const HvMessage *m, const char *expected) {
+  HvMessage *c = msg_copy(m);
+  CHECK(msg_getSize(c) == msg_getSize(m));
+  check_equal(m, c);
+  check_text(c, expected);
+  msg_free(c);
+
+  const hv_size_t size = msg_getCoreSize(msg_getNumElements(m));
+  char *buf = (char *) malloc(size);
+  msg_copyToBuffer(m, buf, size);
+  check_equal(m, (HvMessage *) buf);
+  check_text((HvMessage *) buf, expected);
+  free(buf);
+}
+
+static void test_float(void) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithFloat(m, 123, 0.25f);
+  CHECK(msg_getNumElements(m) == 1 && msg_getTimestamp(m) == 123);
+  CHECK(msg_isFloat(m, 0) && !msg_isBang(m, 0) && !msg_isSymbol(m, 0) && !msg_isHashLike(m, 0));
+  CHECK(msg_getFloat(m, 0) == 0.25f);
+  CHECK(msg_hasFormat(m, "f") && !msg_hasFormat(m, "s") && !msg_hasFormat(m, "ff"));
+  check_text(m, "0.25");
+  check_copies(m, "0.25");
+}
+
+static void test_bang(void) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithBang(m, 0);
+  CHECK(msg_isBang(m, 0) && !msg_isFloat(m, 0));
+  CHECK(msg_hasFormat(m, "b"));
+  check_text(m, "bang");
+  check_copies(m, "bang");
+}
+
+static void test_symbol(void) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  // a string only known at runtime is interned
+  char name[16];
+  snprintf(name, sizeof(name), "knob%d", 7);
+  msg_initWithSymbol(m, 5, name);
+  CHECK(msg_isSymbol(m, 0) && msg_isHashLike(m, 0) && msg_hasFormat(m, "s"));
+  CHECK(!strcmp(msg_getSymbol(m, 0), "knob7") && msg_getSymbol(m, 0) != name);
+  CHECK(msg_getInternedSymbol(m, 0) == hSym_intern("knob7"));
+  CHECK(msg_getHash(m, 0) == hv_string_to_hash("knob7"));
+  CHECK(msg_compareSymbol(m, 0, "knob7") && !msg_compareSymbol(m, 0, "knob8"));
+  CHECK(msg_compareSymbolHash(m, 0, hv_string_to_hash("knob7")));
+  check_text(m, "knob7");
+  check_copies(m, "knob7");
+
+  // a literal comes from the static table, as the generator sets it
+  const HvSymbol *bang = hSym_intern("bang");
+  CHECK(bang >= hv_staticSymbols && bang < hv_staticSymbols + hv_numStaticSymbols);
+  msg_initWithInternedSymbol(m, 5, bang);
+  CHECK(msg_compareInternedSymbol(m, 0, bang) && msg_compareSymbol(m, 0, "bang"));
+  CHECK(!msg_compareInternedSymbol(m, 0, hSym_intern("knob7")));
+  CHECK(!msg_isBang(m, 0)); // the symbol bang is not a bang
+  check_copies(m, "bang");
+
+  // a hash matches the string it was made from
+  msg_initWithHash(m, 5, hv_string_to_hash("knob7"));
+  CHECK(msg_isHash(m, 0) && msg_isHashLike(m, 0) && !msg_isSymbol(m, 0));
+  CHECK(msg_compareSymbol(m, 0, "knob7") && msg_compareInternedSymbol(m, 0, hSym_intern("knob7")));
+  char hex[16];
+  snprintf(hex, sizeof(hex), "0x%X", (unsigned) hv_string_to_hash("knob7"));
+  check_copies(m, hex);
+}
+
+static void test_mixed(void) {
+  HvMessage *m = HV_MESSAGE_ON_STACK(5);
+  msg_init(m, 5, 0xFFFFFFF0);
+  msg_setSymbol(m, 0, "set");
+  msg_setFloat(m, 1, -1.5f);
+  msg_setBang(m, 2);
+  msg_setFloat(m, 3, 1e10f);
+  msg_setHash(m, 4, 0xAB);
+  CHECK(msg_hasFormat(m, "sfbfh") && !msg_hasFormat(m, "sfbf") && !msg_hasFormat(m, "ffbfh"));
+  CHECK(msg_getTimestamp(m) == 0xFFFFFFF0);
+  check_text(m, "set -1.5 bang 1e+10 0xAB");
+  check_copies(m, "set -1.5 bang 1e+10 0xAB");
+
+  // elements set from another message
+  HvMessage *n = HV_MESSAGE_ON_STACK(5);
+  msg_init(n, 5, 0xFFFFFFF0);
+  for (int i = 0; i < 5; ++i) msg_setElementToFrom(n, i, m, 4 - i);
+  check_text(n, "0xAB 1e+10 bang -1.5 set");
+  for (int i = 0; i < 5; ++i) CHECK(msg_equalsElement(m, i, n, 4 - i));
+  CHECK(!msg_equalsElement(m, 0, n, 0) && !msg_equalsElement(m, 0, n, 5));
+}
+
+static void test_float_format(void) {
+  static const float values[] = {
+    0.0f, -0.0f, 1.0f, -1.0f, 0.1f, 0.5f, 1.0f/3.0f, 2.0f/3.0f, 100.0f, 440.0f, 44100.0f,
+    123456.0f, 999999.0f, 1000000.0f, 1234567.0f, 1e-4f, 1e-5f, 0.00012345f, 3.14159265f,
+    1e20f, -2.5e-12f, 16777216.0f, 3.4e38f, 1.17549435e-38f,
+  };
+  char expected[32], buf[32];
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  for (int i = 0; i < (int) (sizeof(values) / sizeof(values[0])); ++i) {
+    msg_initWithFloat(m, 0, values[i]);
+    snprintf(expected, sizeof(expected), "%g", values[i]);
+    msg_toStringBuf(m, buf, sizeof(buf));
+    if (strcmp(buf, expected)) { fprintf(stderr, "%.9g: \"%s\", expected \"%s\"\n", values[i], buf, expected); ++failures; }
+  }
+  // and a sweep over the exponents
+  for (unsigned int bits = 0x00800000; bits < 0x7F800000; bits += 0x00012345) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    msg_initWithFloat(m, 0, f);
+    snprintf(expected, sizeof(expected), "%g", f);
+    msg_toStringBuf(m, buf, sizeof(buf));
+    if (strcmp(buf, expected)) { fprintf(stderr, "%.9g: \"%s\", expected \"%s\"\n", f, buf, expected); ++failures; break; }
+  }
+}
+
+typedef struct { hv_uint32_t hash; int i; } Entry;
+
+static int entry_compare(const void *a, const void *b) {
+  const hv_uint32_t x = ((const Entry *) a)->hash, y = ((const Entry *) b)->hash;
+  return (x > y) - (x < y);
+}
+
+static void test_collision(void) {
+  // the birthday bound finds two strings with one 32-bit hash well within this many
+  enum { N = 1 << 18 };
+  Entry *e = (Entry *) malloc(N * sizeof(Entry));
+  char s[16], t[16];
+  for (int i = 0; i < N; ++i) {
+    snprintf(s, sizeof(s), "%08x", i * 2654435761u);
+    e[i].hash = hv_string_to_hash(s);
+    e[i].i = i;
+  }
+  qsort(e, N, sizeof(Entry), entry_compare);
+  int found = 0;
+  for (int i = 1; i < N && !found; ++i) {
+    if (e[i].hash != e[i-1].hash) continue;
+    snprintf(s, sizeof(s), "%08x", e[i-1].i * 2654435761u);
+    snprintf(t, sizeof(t), "%08x", e[i].i * 2654435761u);
+    found = 1;
+  }
+  free(e);
+  CHECK(found);
+  if (!found) return;
+
+  const HvSymbol *a = hSym_intern(s), *b = hSym_intern(t);
+  CHECK(a != b && a->hash == b->hash && !strcmp(a->str, s) && !strcmp(b->str, t));
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithSymbol(m, 0, s);
+  CHECK(msg_compareSymbol(m, 0, s) && !msg_compareSymbol(m, 0, t));
+  CHECK(msg_compareInternedSymbol(m, 0, a) && !msg_compareInternedSymbol(m, 0, b));
+  HvMessage *n = HV_MESSAGE_ON_STACK(1);
+  msg_initWithSymbol(n, 0, t);
+  CHECK(!msg_equalsElement(m, 0, n, 0));
+}
+
+int main(void) {
+  test_float();
+  test_bang();
+  test_symbol();
+  test_mixed();
+  test_float_format();
+  test_collision();
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  else printf("all passed\n");
+  return failures ? 1 : 0;
+}
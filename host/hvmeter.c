@@ -0,0 +1,177 @@
+/*
+ * Host test and benchmark of the output meters and scope (c2espidf/static/HvMeter.h):
+ *   levels   a 0.5 sine and a 1.25 sine, 100 blocks of 256 frames at 48 kHz:
+ *            peak and RMS of the first, clips counted only on the second
+ *   scope    the snapshot starts at a rising zero crossing
+ *   tearing  the audio side publishes a ramp and its negative as fast as it
+ *            can while another thread reads: every snapshot read must be one
+ *            ramp and its mirror, and the two channels' levels must match
+ *   cost     a block's conversion to 16 bits, as run_audio_loop() does it,
+ *            with and without the meters fused in
+ *
+ *   cc -O2 -Ic2espidf/static host/hvmeter.c c2espidf/static/HvMeter.c -lpthread -lm -o hvmeter
+ *
+ * ThreadSanitizer is no help here: it doesn't model the sequence lock's fences,
+ * and the lock copies the data racily by design. The tearing check is the test.
+ *
+ *   hvmeter [-t seconds] [-r blocks]
+ *       -t  how long the audio side publishes against the reader (2)
+ *       -r  blocks to time the conversion on, the fastest is kept (2000)
+ */
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HvMeter.h"
+
+#define BLOCK 256
+#define POINTS 256
+#define DECIMATION 8
+#define WINDOW 2400 // 50 ms
+#define RAMP_STEP 1e-5f
+
+static HvMeter meter;
+static int done = 0;
+static unsigned long reads = 0, gave_up = 0, torn = 0, levels_torn = 0;
+static volatile hv_int16_t sink; // a sample of each timed block, so that the loop is kept
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void *reader(void *arg) {
+  float *s = (float *) malloc(2 * POINTS * sizeof(float));
+  HvMeterLevel l[2];
+  while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+    if (hMe_readScope(&meter, s) == 0) {
+      ++gave_up;
+      continue;
+    }
+    ++reads;
+    // a point every DECIMATION frames of the ramp, or the ramp starting over
+    for (int i = 1; i < POINTS; ++i) {
+      const float d = s[i] - s[i-1];
+      if ((fabsf(d - DECIMATION * RAMP_STEP) > 1e-5f && d > -0.5f) || s[POINTS + i] != -s[i]) {
+        ++torn;
+        break;
+      }
+    }
+    if (hMe_readLevels(&meter, l) && (l[0].peak != l[1].peak || l[0].rms != l[1].rms)) ++levels_torn;
+  }
+  free(s);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  double seconds = 2.0;
+  int reps = 2000, opt;
+  while ((opt = getopt(argc, argv, "t:r:")) != -1) {
+    switch (opt) {
+      case 't': seconds = atof(optarg); break;
+      case 'r': reps = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-t seconds] [-r blocks]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (seconds <= 0.0 || reps < 1) {
+    fprintf(stderr, "-t and -r are positive\n");
+    return 2;
+  }
+  int failures = 0;
+  float out[2 * BLOCK];
+
+  // a 100 Hz sine at 0.5, and at 1.25 on the second channel
+  hMe_init(&meter, 2, WINDOW, POINTS, DECIMATION);
+  unsigned long n = 0;
+  for (int b = 0; b < 100; ++b) {
+    HvMeterAccum acc[2] = { { 0 } };
+    for (int i = 0; i < BLOCK; ++i, ++n) {
+      const float l = 0.5f * sinf((float) (2.0 * M_PI * 100.0 * n / 48000.0)), r = 2.5f * l;
+      hMe_accumulate(&acc[0], l);
+      hMe_accumulate(&acc[1], r);
+      out[i] = l;
+      out[BLOCK + i] = r;
+    }
+    hMe_addLevels(&meter, acc, BLOCK);
+    hMe_addScope(&meter, out, BLOCK, BLOCK);
+  }
+  HvMeterLevel l[2];
+  const hv_uint32_t windows = hMe_readLevels(&meter, l);
+  printf("%u windows: peak %.4f rms %.4f clips %u, peak %.4f rms %.4f clips %u\n",
+      windows, l[0].peak, l[0].rms, l[0].clips, l[1].peak, l[1].rms, l[1].clips);
+  if (windows != 100 * BLOCK / WINDOW || fabsf(l[0].peak - 0.5f) > 1e-3f || fabsf(l[0].rms - 0.35355f) > 5e-3f ||
+      l[0].clips != 0 || l[1].clips == 0) {
+    printf("  expected %d windows, peak 0.5 and rms 0.354 without clips, then clips\n", 100 * BLOCK / WINDOW);
+    ++failures;
+  }
+  float scope[2 * POINTS];
+  const hv_uint32_t snapshots = hMe_readScope(&meter, scope);
+  printf("%u snapshots, starting %.3f %.3f %.3f\n", snapshots, scope[0], scope[1], scope[2]);
+  if (snapshots == 0 || scope[0] < 0.0f || scope[0] > 0.2f || scope[1] <= scope[0]) {
+    printf("  expected a snapshot starting at a rising zero crossing\n");
+    ++failures;
+  }
+  hMe_free(&meter);
+
+  // a ramp from -0.5 and its negative, published against the reader
+  hMe_init(&meter, 2, WINDOW, POINTS, DECIMATION);
+  pthread_t thread;
+  pthread_create(&thread, NULL, reader, NULL);
+  unsigned long blocks = 0;
+  n = 0;
+  const double t0 = now();
+  while (now() - t0 < seconds) {
+    HvMeterAccum acc[2] = { { 0 } };
+    for (int i = 0; i < BLOCK; ++i, ++n) {
+      const float x = (float) (n % 100000) * RAMP_STEP - 0.5f;
+      hMe_accumulate(&acc[0], x);
+      hMe_accumulate(&acc[1], -x);
+      out[i] = x;
+      out[BLOCK + i] = -x;
+    }
+    hMe_addLevels(&meter, acc, BLOCK);
+    hMe_addScope(&meter, out, BLOCK, BLOCK);
+    ++blocks;
+  }
+  __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+  pthread_join(thread, NULL);
+  printf("%lu blocks published, %lu snapshots read, %lu reads gave up, %lu snapshots and %lu levels torn\n",
+      blocks, reads, gave_up, torn, levels_torn);
+  if (torn || levels_torn) ++failures;
+
+  // the conversion for the DAC, bare and with the meters
+  hv_int16_t pcm[2 * BLOCK];
+  double best[2] = { 1e9, 1e9 };
+  for (int rep = 0; rep < reps; ++rep) {
+    for (int metered = 0; metered < 2; ++metered) {
+      const double a = now();
+      HvMeterAccum acc[2] = { { 0 } };
+      for (int i = 0; i < BLOCK; ++i) {
+        float x = out[i], y = out[BLOCK + i];
+        if (metered) {
+          hMe_accumulate(&acc[0], x);
+          hMe_accumulate(&acc[1], y);
+        }
+        x = (x > 1.0f) ? 1.0f : (x < -1.0f) ? -1.0f : x;
+        y = (y > 1.0f) ? 1.0f : (y < -1.0f) ? -1.0f : y;
+        pcm[2*i] = (hv_int16_t) (x * 32767.0f);
+        pcm[2*i+1] = (hv_int16_t) (y * 32767.0f);
+      }
+      if (metered) hMe_addLevels(&meter, acc, BLOCK);
+      sink = pcm[5];
+      const double d = now() - a;
+      if (d < best[metered]) best[metered] = d;
+    }
+  }
+  hMe_free(&meter);
+  printf("block of %d frames: conversion %.0f ns, with the meters %.0f ns\n",
+      BLOCK, best[0] * 1e9, best[1] * 1e9);
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Host test and benchmark of the MIDI parser (c2espidf/static/HvMidiParser.h).
+ * A stream mixing running status, a clock byte in the middle of a message,
+ * system exclusive and system common messages is parsed in one call, a byte at
+ * a time, and with room for one message at a time, and each way must produce
+ * the same channel messages and the same Heavy messages. Then a stream is
+ * parsed in 128-byte reads, as the UART task does, to measure the throughput.
+ *
+ * Build against a generated runtime, whose static symbols the messages are
+ * built with:
+ *   cc -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvmidi.c main/hvcc/c/HvMidiParser.c main/hvcc/c/HvMessage.c \
+ *      main/hvcc/c/HvSymbolTable.c main/hvcc/c/HvStaticSymbols.c main/hvcc/c/HvUtils.c -lpthread -o hvmidi
+ *
+ *   hvmidi [-n megabytes] [file]
+ *       -n    megabytes of random notes, controllers and clocks to time (30)
+ *       file  times the parser on a file of raw MIDI bytes instead, - for stdin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HvMidiParser.h"
+
+#define READ_SIZE 128
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// parses b in reads of chunk bytes into out, with room for at most room messages per call
+static int parse_all(const hv_uint8_t *b, hv_uint32_t n, hv_uint32_t chunk, hv_uint32_t room,
+    HvMidiMessage *out, int maxOut) {
+  HvMidiParser p;
+  hMi_init(&p);
+  int total = 0;
+  for (hv_uint32_t off = 0; off < n && total < maxOut; ) {
+    const hv_uint32_t len = (n - off < chunk) ? n - off : chunk;
+    const hv_uint32_t max = ((hv_uint32_t) (maxOut - total) < room) ? (hv_uint32_t) (maxOut - total) : room;
+    hv_uint32_t k = 0;
+    const hv_uint32_t used = hMi_parse(&p, b + off, len, out + total, max, &k);
+    for (hv_uint32_t j = 0; j < k; ++j) out[total + j].end += off; // offsets into all of b
+    total += (int) k;
+    off += used;
+  }
+  return total;
+}
+
+typedef struct {
+  hv_uint8_t status, data1, data2;
+  hv_uint32_t end;
+  hv_uint32_t receiver;
+  const char *text;
+} Expected;
+
+static int check_stream(void) {
+  // note on, running status with a clock inside the second note, sysex, running status
+  // cancelled, a program change with running status, a bend, song position, note off
+  static const hv_uint8_t s[] = {
+    0x90, 60, 100, 62, 0xF8, 101, 0x45, 0xF0, 1, 2, 3, 0xF7, 64,
+    0xC3, 5, 6, 0xE0, 0, 0x40, 0xF2, 1, 2, 3, 0x81, 60, 0,
+  };
+  static const Expected expected[] = {
+    { 0x90, 60, 100, 2, HV_MIDI_HASH_NOTEIN, "60 100 0" },
+    { 0x90, 62, 101, 5, HV_MIDI_HASH_NOTEIN, "62 101 0" },
+    { 0xC3, 5, 0, 14, HV_MIDI_HASH_PGMIN, "5 3" },
+    { 0xC3, 6, 0, 15, HV_MIDI_HASH_PGMIN, "6 3" },
+    { 0xE0, 0, 0x40, 18, HV_MIDI_HASH_BENDIN, "8192 0" },
+    { 0x81, 60, 0, 25, HV_MIDI_HASH_NOTEIN, "60 0 1" },
+  };
+  const int num = (int) (sizeof(expected) / sizeof(expected[0]));
+  static const struct { const char *name; hv_uint32_t chunk, room; } ways[] = {
+    { "whole", sizeof(s), 16 },
+    { "byte by byte", 1, 16 },
+    { "one message at a time", sizeof(s), 1 },
+  };
+  int wrong = 0;
+  for (int w = 0; w < 3; ++w) {
+    HvMidiMessage m[16];
+    const int n = parse_all(s, sizeof(s), ways[w].chunk, ways[w].room, m, 16);
+    if (n != num) {
+      printf("%s: %d messages, expected %d\n", ways[w].name, n, num);
+      ++wrong;
+      continue;
+    }
+    for (int i = 0; i < n; ++i) {
+      const Expected *e = &expected[i];
+      HvMidiMessageStorage st;
+      char text[64];
+      const hv_uint32_t receiver = hMi_toMessage(&m[i], &st);
+      msg_toStringBuf(&st.msg, text, sizeof(text));
+      if (m[i].status == e->status && m[i].data1 == e->data1 && m[i].data2 == e->data2 && m[i].end == e->end &&
+          receiver == e->receiver && !strcmp(text, e->text) && msg_getSize(&st.msg) <= sizeof(st)) continue;
+      printf("%s, message %d: %02X %d %d at %u to 0x%08X \"%s\", expected %02X %d %d at %u to 0x%08X \"%s\"\n",
+          ways[w].name, i, m[i].status, m[i].data1, m[i].data2, m[i].end, receiver, text,
+          e->status, e->data1, e->data2, e->end, e->receiver, e->text);
+      ++wrong;
+    }
+  }
+  printf("mixed stream parsed 3 ways, %d wrong\n", wrong);
+  return wrong;
+}
+
+int main(int argc, char **argv) {
+  int megabytes = 30, opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n': megabytes = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n megabytes] [file]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (megabytes < 1 || optind < argc - 1) {
+    fprintf(stderr, "usage: %s [-n megabytes] [file]\n", argv[0]);
+    return 2;
+  }
+
+  const int wrong = check_stream();
+
+  hv_uint8_t *buf;
+  size_t len = 0;
+  if (optind < argc) {
+    FILE *f = strcmp(argv[optind], "-") ? fopen(argv[optind], "rb") : stdin;
+    if (f == NULL) {
+      perror(argv[optind]);
+      return 2;
+    }
+    size_t cap = 1 << 20, r;
+    buf = (hv_uint8_t *) malloc(cap);
+    while ((r = fread(buf + len, 1, cap - len, f)) > 0) {
+      len += r;
+      if (len == cap) buf = (hv_uint8_t *) realloc(buf, cap *= 2);
+    }
+    if (f != stdin) fclose(f);
+  } else {
+    // note ons on four channels and controllers, mostly by running status, and clocks between them
+    const size_t cap = (size_t) megabytes << 20;
+    buf = (hv_uint8_t *) malloc(cap);
+    unsigned int seed = 7;
+    while (len + 4 < cap) {
+      const int k = rand_r(&seed) % 10;
+      if (k < 4) buf[len++] = (hv_uint8_t) (0x90 | k);
+      else if (k == 4) buf[len++] = 0xB0;
+      else if (k == 9) buf[len++] = 0xF8;
+      buf[len++] = (hv_uint8_t) (rand_r(&seed) & 0x7F);
+      buf[len++] = (hv_uint8_t) (rand_r(&seed) & 0x7F);
+    }
+  }
+
+  HvMidiParser p;
+  hMi_init(&p);
+  HvMidiMessage out[64];
+  HvMidiMessageStorage st;
+  size_t events = 0;
+  hv_uint32_t sink = 0;
+  const double t0 = now();
+  for (size_t off = 0; off < len; ) {
+    const hv_uint32_t chunk = (len - off < READ_SIZE) ? (hv_uint32_t) (len - off) : READ_SIZE;
+    hv_uint32_t k;
+    off += hMi_parse(&p, buf + off, chunk, out, 64, &k);
+    for (hv_uint32_t j = 0; j < k; ++j) sink += hMi_toMessage(&out[j], &st);
+    events += k;
+  }
+  const double t = now() - t0;
+  free(buf);
+  printf("%zu bytes, %zu messages in %.3f s: %.1f M messages/s, %.1f MB/s (%u)\n",
+      len, events, t, events / t * 1e-6, len / t * 1e-6, sink & 1);
+
+  return wrong ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Stress test of the lock-free input queue (c2espidf/static/HvMpscPipe.h):
+ * producer threads write records of random sizes, alone or in batches of up to
+ * three, into a small ring while one consumer thread reads them back. Every
+ * record carries its producer and a sequence number and is filled with a
+ * pattern, so the consumer checks that each producer's records come in order,
+ * none is lost or repeated, and none is torn.
+ *
+ *   cc -O2 -Ic2espidf/static host/hvmpsc.c c2espidf/static/HvMpscPipe.c -lpthread -o hvmpsc
+ *
+ * Build with -fsanitize=thread as well to have the pipe's ordering checked by
+ * ThreadSanitizer; it should report nothing.
+ *
+ *   hvmpsc [-p producers] [-n records] [-k ring size]
+ *       -p  producer threads (4)
+ *       -n  records in total, shared between the producers (2000000)
+ *       -k  bytes in the ring, rounded up to a power of two (1024, so it fills up)
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HvMpscPipe.h"
+
+#define MAX_PRODUCERS 64
+#define MAX_FILL 60
+#define MAX_BATCH 3
+
+typedef struct {
+  hv_uint32_t producer;
+  hv_uint32_t seq;
+  hv_uint32_t len;
+  unsigned char fill[MAX_FILL];
+} Record;
+
+static HvMpscPipe pipe_;
+static int num_producers = 4;
+static long num_records = 2000000;
+static int producers_done = 0;
+
+static hv_uint32_t record_bytes(hv_uint32_t len) {
+  return (hv_uint32_t) offsetof(Record, fill) + len;
+}
+
+static unsigned char fill_byte(hv_uint32_t producer, hv_uint32_t seq) {
+  return (unsigned char) (seq * 31 + producer);
+}
+
+static void *producer(void *arg) {
+  const hv_uint32_t id = (hv_uint32_t) (size_t) arg;
+  const hv_uint32_t n = (hv_uint32_t) (num_records / num_producers + (id < num_records % num_producers));
+  hv_uint32_t seq = 0;
+  hv_uint32_t r = id * 7919 + 1;
+  while (seq < n) {
+    r = r * 1103515245 + 12345;
+    int batch = 1 + (int) ((r >> 16) % MAX_BATCH);
+    if (seq + batch > n) batch = (int) (n - seq);
+    hv_uint32_t lens[MAX_BATCH], total = 0;
+    for (int i = 0; i < batch; ++i) {
+      lens[i] = (r >> (8 + i * 4)) % (MAX_FILL + 1);
+      total += hMp_getRecordSize(record_bytes(lens[i]));
+    }
+    char *b = hMp_getWriteBuffer(&pipe_, total);
+    if (b == NULL) { sched_yield(); continue; } // full, as it often is
+    char *const first = b;
+    for (int i = 0; i < batch; ++i) {
+      if (i > 0) b = hMp_getNextBatchBuffer(b, record_bytes(lens[i-1]), record_bytes(lens[i]));
+      Record *x = (Record *) b;
+      x->producer = id;
+      x->seq = seq++;
+      x->len = lens[i];
+      memset(x->fill, fill_byte(id, x->seq), lens[i]);
+    }
+    hMp_produce(&pipe_, first, record_bytes(lens[0]));
+  }
+  __atomic_add_fetch(&producers_done, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  int ring = 1024, opt;
+  while ((opt = getopt(argc, argv, "p:n:k:")) != -1) {
+    switch (opt) {
+      case 'p': num_producers = atoi(optarg); break;
+      case 'n': num_records = atol(optarg); break;
+      case 'k': ring = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-p producers] [-n records] [-k ring size]\n", argv[0]);
+        return 2;
+    }
+  }
+  const hv_uint32_t largest = MAX_BATCH * hMp_getRecordSize(record_bytes(MAX_FILL));
+  if (num_producers < 1 || num_producers > MAX_PRODUCERS || num_records < 0 || ring < (int) largest) {
+    fprintf(stderr, "-p is 1 to %d, -n is not negative, -k is at least %u\n", MAX_PRODUCERS, largest);
+    return 2;
+  }
+  const hv_uint32_t size = hMp_init(&pipe_, (hv_uint32_t) ring);
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  pthread_t threads[MAX_PRODUCERS];
+  for (int i = 0; i < num_producers; ++i) {
+    pthread_create(&threads[i], NULL, producer, (void *) (size_t) i);
+  }
+
+  hv_uint32_t next[MAX_PRODUCERS] = {0};
+  long received = 0, out_of_order = 0, torn = 0;
+  for (;;) {
+    hv_uint32_t n;
+    char *b = hMp_getReadBuffer(&pipe_, &n);
+    if (b == NULL) {
+      // everything the producers wrote is published before they count themselves done
+      if (__atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) == num_producers &&
+          hMp_getReadBuffer(&pipe_, &n) == NULL) break;
+      sched_yield();
+      continue;
+    }
+    const Record *x = (const Record *) b;
+    if (x->producer >= (hv_uint32_t) num_producers || x->len > MAX_FILL || n < record_bytes(x->len)) {
+      ++torn;
+    } else {
+      if (x->seq != next[x->producer]) ++out_of_order;
+      next[x->producer] = x->seq + 1;
+      for (hv_uint32_t i = 0; i < x->len; ++i) {
+        if (x->fill[i] != fill_byte(x->producer, x->seq)) { ++torn; break; }
+      }
+    }
+    ++received;
+    hMp_consume(&pipe_);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  for (int i = 0; i < num_producers; ++i) pthread_join(threads[i], NULL);
+  hMp_free(&pipe_);
+
+  const double s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  printf("%d producers, %ld records through a %u-byte ring in %.2f s (%.2f M records/s)\n",
+      num_producers, received, size, s, received / s * 1e-6);
+  printf("%ld out of order, %ld torn, %ld missing\n", out_of_order, torn, num_records - received);
+  return (out_of_order == 0 && torn == 0 && received == num_records) ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+/*
+ * Host side of the OSC input (c2espidf/static/HvOscParser.h): sends OSC
+ * messages to the board over UDP, and benchmarks the parser the board uses over
+ * the loopback interface.
+ *
+ * Build against a generated runtime, whose static symbols the strings are
+ * resolved with:
+ *   cc -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvosc.c main/hvcc/c/HvOscParser.c main/hvcc/c/HvMessage.c \
+ *      main/hvcc/c/HvSymbolTable.c main/hvcc/c/HvStaticSymbols.c main/hvcc/c/HvUtils.c -lpthread -o hvosc
+ *
+ *   hvosc send [-d ms] <host> <port> <address> [arg...]
+ *       Sends one message. Numbers are sent as floats, anything else as a string.
+ *       -d wraps it in a bundle timetagged that many milliseconds from now.
+ *   hvosc bench [packets]
+ *       Floods bundles through a loopback socket into the parser for throughput,
+ *       then paces them at 1 kHz for the latency from sending to parsed messages.
+ */
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "HvOscParser.h"
+
+static double mono_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// wall clock as an NTP timetag
+static hv_uint64_t timetag_now(double offset_s) {
+  struct timespec t;
+  clock_gettime(CLOCK_REALTIME, &t);
+  const double s = t.tv_sec + t.tv_nsec * 1e-9 + offset_s + 2208988800.0;
+  const hv_uint64_t whole = (hv_uint64_t) s;
+  return (whole << 32) | (hv_uint64_t) ((s - (double) whole) * 4294967296.0);
+}
+
+static hv_int64_t wall_us(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_REALTIME, &t);
+  return (hv_int64_t) t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+// OSC writing, big-endian and padded to 4 bytes
+typedef struct {
+  hv_uint8_t data[1536];
+  hv_uint32_t size;
+} Packet;
+
+static void put32(Packet *p, hv_uint32_t x) {
+  for (int i = 3; i >= 0; --i) p->data[p->size++] = (hv_uint8_t) (x >> (8 * i));
+}
+
+static void put_string(Packet *p, const char *s) {
+  const hv_uint32_t n = (hv_uint32_t) strlen(s) + 1;
+  memcpy(p->data + p->size, s, n);
+  p->size += n;
+  while (p->size & 3) p->data[p->size++] = 0;
+}
+
+static void put_float(Packet *p, float f) {
+  hv_uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  put32(p, bits);
+}
+
+static void begin_bundle(Packet *p, hv_uint64_t timetag) {
+  p->size = 0;
+  put_string(p, "#bundle");
+  put32(p, (hv_uint32_t) (timetag >> 32));
+  put32(p, (hv_uint32_t) timetag);
+}
+
+// starts a bundle element, returns where its size goes
+static hv_uint32_t begin_element(Packet *p) {
+  p->size += 4;
+  return p->size - 4;
+}
+
+static void end_element(Packet *p, hv_uint32_t at) {
+  const hv_uint32_t n = p->size - at - 4, end = p->size;
+  p->size = at;
+  put32(p, n);
+  p->size = end;
+}
+
+static int open_socket(const char *host, const char *port, struct sockaddr_storage *addr, socklen_t *len) {
+  struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_DGRAM }, *res;
+  const int err = getaddrinfo(host, port, &hints, &res);
+  if (err != 0) {
+    fprintf(stderr, "hvosc: %s: %s\n", host, gai_strerror(err));
+    return -1;
+  }
+  const int fd = socket(res->ai_family, SOCK_DGRAM, 0);
+  memcpy(addr, res->ai_addr, res->ai_addrlen);
+  *len = res->ai_addrlen;
+  freeaddrinfo(res);
+  return fd;
+}
+
+static int cmd_send(int argc, char **argv) {
+  double delay_ms = -1.0;
+  if (argc >= 2 && strcmp(argv[0], "-d") == 0) {
+    delay_ms = atof(argv[1]);
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc < 3 || argv[2][0] != '/') {
+    fprintf(stderr, "hvosc: send [-d ms] <host> <port> <address> [arg...]\n");
+    return 2;
+  }
+  Packet p = { .size = 0 };
+  hv_uint32_t at = 0;
+  if (delay_ms >= 0.0) {
+    begin_bundle(&p, timetag_now(delay_ms * 1e-3));
+    at = begin_element(&p);
+  }
+  char types[HV_OSC_MAX_ARGS + 2] = ",";
+  for (int i = 3; i < argc && i - 3 < HV_OSC_MAX_ARGS; ++i) {
+    char *end;
+    strtof(argv[i], &end);
+    strcat(types, (*end == '\0' && end != argv[i]) ? "f" : "s");
+  }
+  put_string(&p, argv[2]);
+  put_string(&p, types);
+  for (int i = 3; i < argc && i - 3 < HV_OSC_MAX_ARGS; ++i) {
+    if (types[i - 2] == 'f') put_float(&p, strtof(argv[i], NULL));
+    else put_string(&p, argv[i]);
+  }
+  if (delay_ms >= 0.0) end_element(&p, at);
+
+  struct sockaddr_storage addr;
+  socklen_t len;
+  const int fd = open_socket(argv[0], argv[1], &addr, &len);
+  if (fd < 0) return 1;
+  if (sendto(fd, p.data, p.size, 0, (struct sockaddr *) &addr, len) < 0) {
+    fprintf(stderr, "hvosc: %s\n", strerror(errno));
+    return 1;
+  }
+  close(fd);
+  return 0;
+}
+
+// bench: every packet is a bundle of MESSAGES_PER_PACKET messages, timetagged with its send time
+#define MESSAGES_PER_PACKET 8
+
+typedef struct {
+  int fd;
+  unsigned long packets, messages, converted, malformed;
+  hv_int64_t latency_us[4096];
+  unsigned long num_latencies;
+  bool measure;
+  hv_uint64_t timetag; // of the packet being parsed
+  double parse_time;
+} Receiver;
+
+static void on_message(void *user, const HvOscMessage *m) {
+  Receiver *r = (Receiver *) user;
+  HvOscMessageStorage s;
+  r->messages++;
+  if (hOs_toMessage(m, &s)) r->converted++;
+  r->timetag = m->timetag;
+}
+
+static void *receiver_thread(void *arg) {
+  Receiver *r = (Receiver *) arg;
+  hv_uint8_t buf[1536];
+  while (1) {
+    const ssize_t n = recv(r->fd, buf, sizeof(buf), 0);
+    if (n <= 0) break;
+    if (n == 8 && memcmp(buf, "/quit\0\0\0", 8) == 0) break;
+    const double t0 = mono_now();
+    if (!hOs_parse(buf, (hv_uint32_t) n, on_message, r)) r->malformed++;
+    r->parse_time += mono_now() - t0;
+    r->packets++;
+    if (r->measure && r->num_latencies < sizeof(r->latency_us) / sizeof(r->latency_us[0])) {
+      r->latency_us[r->num_latencies++] = wall_us() - hOs_timetagToUs(r->timetag);
+    }
+  }
+  return NULL;
+}
+
+static void fill_bench_packet(Packet *p, unsigned long i) {
+  begin_bundle(p, timetag_now(0.0));
+  for (int k = 0; k < MESSAGES_PER_PACKET; ++k) {
+    const hv_uint32_t at = begin_element(p);
+    if (k == 0) {
+      put_string(p, "/button1");
+      put_string(p, ",");
+    } else {
+      put_string(p, (k & 1) ? "/knob1" : "/synth/voice/cutoff");
+      put_string(p, ",fi");
+      put_float(p, (float) i * 0.001f);
+      put32(p, (hv_uint32_t) k);
+    }
+    end_element(p, at);
+  }
+}
+
+static int compare_int64(const void *a, const void *b) {
+  const hv_int64_t x = *(const hv_int64_t *) a, y = *(const hv_int64_t *) b;
+  return (x > y) - (x < y);
+}
+
+static int cmd_bench(unsigned long packets) {
+  Receiver r = { .fd = socket(AF_INET, SOCK_DGRAM, 0) };
+  struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+  socklen_t len = sizeof(addr);
+  const int rcvbuf = 8 << 20;
+  setsockopt(r.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  bind(r.fd, (struct sockaddr *) &addr, len);
+  getsockname(r.fd, (struct sockaddr *) &addr, &len);
+  const int out = socket(AF_INET, SOCK_DGRAM, 0);
+  connect(out, (struct sockaddr *) &addr, len);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, receiver_thread, &r);
+  Packet p;
+
+  // throughput: as fast as the sender goes
+  double t0 = mono_now();
+  for (unsigned long i = 0; i < packets; ++i) {
+    fill_bench_packet(&p, i);
+    send(out, p.data, p.size, 0);
+  }
+  while (r.packets < packets && mono_now() - t0 < 10.0) usleep(1000);
+  const double flood = mono_now() - t0;
+  const unsigned long flood_packets = r.packets, flood_messages = r.messages;
+  printf("flood: %lu of %lu packets (%u bytes) in %.3f s, %.2f M messages/s, %lu converted, %lu malformed\n",
+      flood_packets, packets, p.size, flood, flood_messages / flood * 1e-6, r.converted, r.malformed);
+  printf("parser: %.1f M messages/s\n", flood_messages / r.parse_time * 1e-6);
+
+  // latency: paced at 1 kHz
+  usleep(100000);
+  r.measure = true;
+  const unsigned long paced = sizeof(r.latency_us) / sizeof(r.latency_us[0]);
+  t0 = mono_now();
+  for (unsigned long i = 0; i < paced; ++i) {
+    while (mono_now() < t0 + i * 1e-3) {}
+    fill_bench_packet(&p, i);
+    send(out, p.data, p.size, 0);
+  }
+  usleep(100000);
+  send(out, "/quit\0\0\0", 8, 0);
+  pthread_join(thread, NULL);
+  qsort(r.latency_us, r.num_latencies, sizeof(hv_int64_t), compare_int64);
+  if (r.num_latencies > 0) {
+    printf("paced: %lu packets at 1 kHz, latency send to parsed median %lld us, p99 %lld us, max %lld us\n",
+        r.num_latencies, (long long) r.latency_us[r.num_latencies / 2],
+        (long long) r.latency_us[r.num_latencies * 99 / 100], (long long) r.latency_us[r.num_latencies - 1]);
+  }
+  close(out);
+  close(r.fd);
+  return (r.malformed == 0 && r.converted == r.messages) ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 2 && strcmp(argv[1], "send") == 0) return cmd_send(argc - 2, argv + 2);
+  if (argc >= 2 && strcmp(argv[1], "bench") == 0) return cmd_bench((argc > 2) ? strtoul(argv[2], NULL, 10) : 200000);
+  fprintf(stderr,
+      "usage: hvosc send [-d ms] <host> <port> <address> [arg...]\n"
+      "       hvosc bench [packets]\n");
+  return 2;
+}
@@ -0,0 +1,123 @@
+/*
+ * Host test of the parameter smoother (c2espidf/static/HvSignalSmooth.h), read a
+ * block of HV_N_SIMD samples at a time through __hv_smooth_f() as the generated
+ * process() reads it:
+ *   step     a step from 0 to 1 reaches 1 - 1/e after one time constant, only
+ *            ever rises, and lands exactly on 1 rather than approaching it forever
+ *   retarget a new target mid-glide turns the glide around from where it is
+ *   large    a step to 1000 and back to -1000 also lands exactly
+ *   message  a float message sets the target, a bang leaves it alone
+ *   no time  a time of zero jumps straight to the target
+ *
+ * Build against a generated runtime, whose message functions it uses, once for
+ * each SIMD width the runtime has:
+ *   cc -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvsmooth.c main/hvcc/c/HvSignalSmooth.c main/hvcc/c/HvMessage.c \
+ *      main/hvcc/c/HvSymbolTable.c main/hvcc/c/HvStaticSymbols.c main/hvcc/c/HvUtils.c -lpthread -lm -o hvsmooth
+ * and the same without -DHV_SIMD_NONE but with -msse4.1, then with -mavx.
+ *
+ *   hvsmooth [-t ms] [-r rate]
+ *       -t  time constant in milliseconds (20)
+ *       -r  sample rate in Hz (48000)
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "HvSignalSmooth.h"
+
+static int failures = 0;
+
+static void check(const char *name, int ok, const char *what) {
+  printf("%-9s %s%s\n", name, what, ok ? "" : "  FAIL");
+  if (!ok) ++failures;
+}
+
+// reads n samples rounded up to whole blocks, into out if it isn't NULL, and returns the last
+static float run(SignalSmooth *s, long n, float *out) {
+  hv_bufferf_t b;
+  float last = 0.0f;
+  for (long i = 0; i < n; i += HV_N_SIMD) {
+    __hv_smooth_f(s, VOf(b));
+    const float *f = (const float *) &b;
+    for (int j = 0; j < HV_N_SIMD; ++j) {
+      if (out != NULL && i + j < n) out[i + j] = f[j];
+      last = f[j];
+    }
+  }
+  return last;
+}
+
+int main(int argc, char **argv) {
+  float timeMs = 20.0f;
+  double rate = 48000.0;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:r:")) != -1) {
+    switch (opt) {
+      case 't': timeMs = (float) atof(optarg); break;
+      case 'r': rate = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-t ms] [-r rate]\n", argv[0]);
+        return 2;
+    }
+  }
+  // the time constant in samples, long enough for a glide to span many reads
+  const long n = (long) (timeMs * rate / 1000.0 + 0.5);
+  if (rate <= 0.0 || n < 16 * HV_N_SIMD) {
+    fprintf(stderr, "-t times -r is at least %d samples\n", 16 * HV_N_SIMD);
+    return 2;
+  }
+  printf("%d samples per read, time constant %ld samples\n", HV_N_SIMD, n);
+  char what[128];
+
+  SignalSmooth s;
+  sSmooth_init(&s, 0.0f, timeMs, rate);
+  float *out = (float *) malloc(40 * n * sizeof(float));
+  sSmooth_setTarget(&s, 1.0f);
+  run(&s, 40 * n, out);
+  long settled = -1, falls = 0;
+  for (long i = 0; i < 40 * n; ++i) {
+    if (i > 0 && out[i] < out[i-1]) ++falls;
+    if (settled < 0 && out[i] == 1.0f) settled = i;
+  }
+  const float at = out[n - 1];
+  snprintf(what, sizeof(what), "%.4f after one time constant, exactly 1 after %.1f, %ld falls",
+      at, settled / (double) n, falls);
+  check("step", fabsf(at - (1.0f - expf(-1.0f))) < 2e-3f && settled > 0 && falls == 0 && out[40 * n - 1] == 1.0f,
+      what);
+
+  // from 1 down to 0.5, then back up to 0.95 half a time constant in: on from where it got to
+  sSmooth_setTarget(&s, 0.5f);
+  const float half = run(&s, n / 2, NULL);
+  sSmooth_setTarget(&s, 0.95f);
+  const float first = run(&s, HV_N_SIMD, NULL);
+  const float end = run(&s, 40 * n, NULL);
+  snprintf(what, sizeof(what), "%.4f half a time constant down, then %.4f, settling at %g", half, first, end);
+  check("retarget", half > 0.5f && half < 0.9f && first > half && first < half + 2.0f * HV_N_SIMD * (0.95f - half) / n &&
+      end == 0.95f, what);
+
+  sSmooth_setTarget(&s, 1000.0f);
+  const float up = run(&s, 40 * n, NULL);
+  sSmooth_setTarget(&s, -1000.0f);
+  const float down = run(&s, 40 * n, NULL);
+  snprintf(what, sizeof(what), "settles at %g, then at %g", up, down);
+  check("large", up == 1000.0f && down == -1000.0f, what);
+
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  msg_initWithFloat(m, 0, 0.25f);
+  sSmooth_onMessage(NULL, &s, m);
+  const float target = s.target;
+  msg_initWithBang(m, 0);
+  sSmooth_onMessage(NULL, &s, m);
+  snprintf(what, sizeof(what), "target %g after a float of 0.25, %g after a bang", target, s.target);
+  check("message", target == 0.25f && s.target == 0.25f, what);
+
+  sSmooth_init(&s, 0.0f, 0.0f, rate);
+  sSmooth_setTarget(&s, 0.3f);
+  run(&s, HV_N_SIMD, out);
+  snprintf(what, sizeof(what), "%g on the first sample after a target of 0.3", out[0]);
+  check("no time", out[0] == 0.3f, what);
+
+  free(out);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Host test of the single-precision timing in HeavyContext and HvSignalPhasor,
+ * at the sample rates a patch runs at, against the double-precision formulas
+ * they replace:
+ *   millisecondsToSamples()  same sample as an exact floor(ms*sampleRate/1000),
+ *                            where a plain float product is often one late
+ *   samplesToMilliseconds()  within 2 ulp of 1000*n/sampleRate
+ *   phasor~ frequency        the step sPhasor_k_onMessage() sets, through
+ *                            hv_getSamplePeriod(), within 2^-22 of f*2^32/sampleRate
+ * then times millisecondsToSamples() against the double formula it replaced. A
+ * host has double-precision hardware, and a fused multiply-add only with -mfma,
+ * so the double formula wins here; on the ESP32 it is a call into soft-float.
+ *
+ *   c++ -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvtiming.cpp main/hvcc/c/H*.c main/hvcc/c/H*.cpp -lpthread -o hvtiming
+ *
+ *   hvtiming [-n values]
+ *       -n  values checked per rate and conversion (2000000)
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+#include "Heavy_heavy.hpp"
+#include "HvSignalPhasor.h"
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  int count = 2000000, opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n': count = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n values]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (count < 2) {
+    fprintf(stderr, "-n is at least 2\n");
+    return 2;
+  }
+
+  static const double rates[] = { 8000, 22050, 32000, 44100, 48000, 88200, 96000 };
+  long ms2sOff = 0, plainOff = 0, s2msOff = 0, stepOff = 0;
+  double maxStepHz = 0.0;
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  for (double sr : rates) {
+    Heavy_heavy c(sr);
+
+    // ms over 0 to 60 s in steps that land on many fractions of a sample; ms is a
+    // float and sr an integer, so the long double product is exact
+    const float k = (float) (sr / 1000.0);
+    for (int i = 0; i < count; ++i) {
+      const float ms = (float) i * (60000.0f / (float) count);
+      const hv_uint32_t ref = (hv_uint32_t) floorl((long double) ms * (long double) sr / 1000.0L);
+      if (c.millisecondsToSamples(ms) != ref) {
+        if (ms2sOff++ < 10) printf("%g Hz: %.9g ms is sample %u, expected %u\n", sr, ms, c.millisecondsToSamples(ms), ref);
+      }
+      plainOff += ((hv_uint32_t) (ms * k) != ref);
+    }
+
+    // n over 0 to about 17 minutes at 48 kHz
+    for (int i = 0; i < count; ++i) {
+      const hv_uint32_t n = (hv_uint32_t) i * 25u;
+      const float ref = (float) (1000.0 * n / sr);
+      const float got = c.samplesToMilliseconds(n);
+      if (fabsf(got - ref) > fabsf(ref) * 2.4e-7f) {
+        if (s2msOff++ < 10) printf("%g Hz: sample %u is %.9g ms, expected %.9g\n", sr, n, got, ref);
+      }
+    }
+
+    // frequencies either way up to Nyquist, sent to a phasor~ as the patch would
+    SignalPhasor o;
+    sPhasor_k_init(&o, 0.0f, sr);
+    for (int i = 0; i < count; ++i) {
+      const float f = (float) (i * sr * 0.5 / count) * ((i & 1) ? 1.0f : -1.0f);
+      msg_initWithFloat(m, 0, f);
+      sPhasor_k_onMessage(&c, &o, 0, m);
+      const double ref = f * (4294967296.0 / sr);
+      const double d = fabs((double) o.step.s - (double) (hv_int32_t) ref);
+      if (d > fabs(ref) * 2.4e-7 + 1.0) {
+        if (stepOff++ < 10) printf("%g Hz: %.9g Hz steps by %d, expected %d\n", sr, f, o.step.s, (hv_int32_t) ref);
+      }
+      // a step off by d is a frequency off by d*sr/2^32
+      maxStepHz = fmax(maxStepHz, d * sr / 4294967296.0);
+    }
+  }
+  printf("ms->samples: %ld of %ld off (a plain float product: %ld)\n", ms2sOff, 7L * count, plainOff);
+  printf("samples->ms: %ld of %ld beyond 2 ulp\n", s2msOff, 7L * count);
+  printf("phasor~ step: %ld of %ld beyond 2^-22, at most %.6f Hz off\n", stepOff, 7L * count, maxStepHz);
+
+  // the conversion every delayed message goes through, and the double one it replaced
+  Heavy_heavy c(48000.0);
+  float *values = (float *) malloc(count * sizeof(float));
+  srand(1);
+  for (int i = 0; i < count; ++i) values[i] = (float) (rand() % 100000) * 0.01f;
+  unsigned long total = 0;
+  const double t0 = now();
+  for (int i = 0; i < count; ++i) total += c.millisecondsToSamples(values[i]);
+  const double t1 = now();
+  volatile double rate = c.getSampleRate(); // keeps the division in the loop, as it was
+  for (int i = 0; i < count; ++i) total += (hv_uint32_t) (values[i] * (rate / 1000.0));
+  const double t2 = now();
+  free(values);
+  printf("millisecondsToSamples %.1f ns, double formula %.1f ns per value (%lu)\n",
+      (t1 - t0) / count * 1e9, (t2 - t1) / count * 1e9, total);
+
+  return (ms2sOff == 0 && s2msOff == 0 && stepOff == 0) ? 0 : 1;
+}
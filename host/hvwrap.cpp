@@ -0,0 +1,141 @@
+/*
+ * Host test of message scheduling across the 2^32-sample wrap of the timestamps
+ * (about 24.8 hours at 48 kHz). Checks msg_isTimestampBefore() on times either
+ * side of the wrap, then sets a generated context's clock to 100 blocks before
+ * it and keeps sending messages to [r button1] -> [print button1], by delay and
+ * at a sample, while it processes past the wrap. Each message carries the
+ * sample it is due on, and the print hook checks that it arrives in that block,
+ * in order. Last, the message queue is timed on its own, scheduling and popping
+ * messages away from the wrap and across it.
+ *
+ *   c++ -O2 -DHV_SIMD_NONE -Imain/hvcc/c host/hvwrap.cpp main/hvcc/c/H*.c main/hvcc/c/H*.cpp -lpthread -o hvwrap
+ *
+ *   hvwrap [-n blocks] [-b blocks]
+ *       -n  blocks the context processes, 100 of them before the wrap (400)
+ *       -b  blocks of four messages each to time the queue with (200000)
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+#include "Heavy_heavy.h"
+#include "Heavy_heavy.hpp"
+#include "HvMessageQueue.h"
+
+#define BLOCK 64
+
+static int failures = 0;
+
+#define CHECK(_c) do { if (!(_c)) { fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #_c); ++failures; } } while (0)
+
+// a context whose clock can be moved forward
+class Forward : public Heavy_heavy {
+ public:
+  Forward() : Heavy_heavy(48000.0, 20) {}
+  void setClock(hv_uint32_t t) { blockStartTimestamp = t; }
+};
+
+static long delivered = 0, late = 0, early = 0, disorder = 0;
+static hv_uint32_t lastDue = 0;
+
+static void printHook(HeavyContextInterface *c, const char *name, const char *s, const HvMessage *m) {
+  if (strcmp(name, "button1")) return;
+  // the sample it is due on travels in the payload, 16 bits per float
+  const hv_uint32_t due = ((hv_uint32_t) msg_getFloat(m, 0) << 16) | (hv_uint32_t) msg_getFloat(m, 1);
+  const hv_uint32_t block = hv_getCurrentSample(c);
+  if (msg_isTimestampBefore(due, block)) ++late;
+  else if (due - block >= BLOCK) ++early;
+  if (delivered > 0 && msg_isTimestampBefore(due, lastDue)) ++disorder;
+  lastDue = due;
+  ++delivered;
+}
+
+static void check_compare() {
+  CHECK(msg_isTimestampBefore(0, 1) && !msg_isTimestampBefore(1, 0) && !msg_isTimestampBefore(5, 5));
+  CHECK(msg_isTimestampBefore(0xFFFFFFFFu, 0) && !msg_isTimestampBefore(0, 0xFFFFFFFFu));
+  CHECK(msg_isTimestampBefore(0xFFFFFF00u, 0x100) && !msg_isTimestampBefore(0x100, 0xFFFFFF00u));
+  // up to 2^31 - 1 samples apart, either way round the wrap
+  CHECK(msg_isTimestampBefore(0xC0000000u, 0x3FFFFFFFu) && !msg_isTimestampBefore(0x3FFFFFFFu, 0xC0000000u));
+  CHECK(msg_isTimestampBefore(0, 0x7FFFFFFFu) && !msg_isTimestampBefore(0x7FFFFFFFu, 0));
+}
+
+static void dummy(HeavyContextInterface *c, int letIn, const HvMessage *m) {}
+
+// ns per message scheduled and popped, with the clock starting at start
+static double time_queue(hv_uint32_t start, int blocks) {
+  HvMessageQueue q;
+  mq_initWithPoolSize(&q, 64);
+  HvMessage *m = HV_MESSAGE_ON_STACK(1);
+  srand(3);
+  hv_uint32_t now = start;
+  long n = 0;
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (int k = 0; k < blocks; ++k) {
+    for (int i = 0; i < 4; ++i, ++n) {
+      msg_initWithBang(m, now + rand() % 4096);
+      mq_addMessageByTimestamp(&q, m, 0, &dummy);
+    }
+    now += BLOCK;
+    while (mq_hasMessageBefore(&q, now)) mq_pop(&q);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  mq_free(&q);
+  return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / n;
+}
+
+int main(int argc, char **argv) {
+  int blocks = 400, benchBlocks = 200000, opt;
+  while ((opt = getopt(argc, argv, "n:b:")) != -1) {
+    switch (opt) {
+      case 'n': blocks = atoi(optarg); break;
+      case 'b': benchBlocks = atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n blocks] [-b blocks]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (blocks <= 100 || benchBlocks < 1) {
+    fprintf(stderr, "-n is more than 100, -b is positive\n");
+    return 2;
+  }
+
+  check_compare();
+
+  // three messages a block, two delayed by up to 50 ms and one at a sample up to 50 ms ahead
+  Forward f;
+  HeavyContextInterface *c = &f;
+  hv_setPrintHook(c, &printHook);
+  f.setClock(0u - BLOCK * 100);
+  float out[2 * BLOCK];
+  HvMessage *m = HV_MESSAGE_ON_STACK(2);
+  srand(7);
+  long sent = 0;
+  for (int k = 0; k < blocks + 100; ++k) {
+    for (int i = 0; i < 3 && k < blocks; ++i) {
+      const float ms = (float) (rand() % 5000) / 100.0f;
+      const hv_uint32_t due = (i == 2) ? hv_getCurrentSample(c) + BLOCK + rand() % 2400
+                                       : hv_getCurrentSample(c) + hv_millisecondsToSamples(c, ms);
+      msg_init(m, 2, 0);
+      msg_setFloat(m, 0, (float) (due >> 16));
+      msg_setFloat(m, 1, (float) (due & 0xFFFF));
+      if (i == 2) sent += hv_sendMessageAtSample(c, HV_HEAVY_RECEIVER_BUTTON1, (hv_uint64_t) due, m);
+      else sent += hv_sendMessageToReceiver(c, HV_HEAVY_RECEIVER_BUTTON1, ms, m);
+    }
+    hv_processInline(c, NULL, out, BLOCK); // the last 100 blocks only drain
+  }
+  printf("across the wrap: %ld sent, %ld delivered, %ld late, %ld early, %ld out of order\n",
+      sent, delivered, late, early, disorder);
+  CHECK(delivered == sent && late == 0 && early == 0 && disorder == 0);
+
+  // the comparison is the same instructions either way, so the times should match
+  const double away = time_queue(0x10000000u, benchBlocks);
+  const double across = time_queue(0u - (hv_uint32_t) benchBlocks * BLOCK / 2, benchBlocks);
+  printf("message queue: %.1f ns per message away from the wrap, %.1f ns across it (HvMessage is %d bytes)\n",
+      away, across, (int) sizeof(HvMessage));
+
+  if (failures) fprintf(stderr, "%d checks failed\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// Control surface of the board mapped onto the patch (generated by c2espidf).
+// The tables are const, so they stay in flash.
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include "driver/gpio.h"
+#include "esp_adc/adc_continuous.h"
+#include "hvcc/c/Heavy_heavy.h"
+
+typedef enum {
+    CONTROL_BUTTON_BANG,  // a bang on press
+    CONTROL_BUTTON_LEVEL, // 1 on press, 0 on release
+} ControlButtonMode;
+
+typedef struct {
+    gpio_num_t pin;
+    hv_uint32_t index; // receiver index
+    hv_uint32_t hash;  // receiver hash
+    bool active_low;
+    ControlButtonMode mode;
+} ControlButton;
+
+typedef enum {
+    CONTROL_CURVE_LINEAR, // min + x * scale
+    CONTROL_CURVE_EXP,    // min * exp(x * scale), for ranges on one side of zero
+} ControlCurve;
+
+typedef struct {
+    adc_channel_t ch; // ADC1 channel
+    int param;        // input parameter index
+    hv_uint32_t hash; // receiver hash
+    float min;
+    float scale;
+    ControlCurve curve;
+} ControlKnob;
+
+typedef enum {
+    CONTROL_ENCODER_DELTA,    // the accelerated detents turned, as a float to the receiver
+    CONTROL_ENCODER_ABSOLUTE, // a position kept by the app, as the parameter's value
+} ControlEncoderMode;
+
+typedef struct {
+    gpio_num_t pin_a;
+    gpio_num_t pin_b;
+    ControlEncoderMode mode;
+    hv_uint32_t index; // receiver index
+    int param;         // input parameter index, -1 for delta encoders
+    hv_uint32_t hash;  // receiver hash
+    int counts_per_detent;
+    float acceleration; // gain added per detent per second above the threshold, 0 for none
+    float step;         // position moved per detent, for absolute encoders
+    float start;        // starting position, from the parameter's default
+    float min;
+    float scale;
+    ControlCurve curve;
+} ControlEncoder;
+
+typedef struct {
+    hv_uint32_t hash;    // hv_stringToHash() of the address
+    const char *address;
+    hv_uint32_t index;   // receiver index
+} ControlOscAddress;
+
+#define CONTROL_NUM_BUTTONS 1
+#define CONTROL_NUM_KNOBS 1
+#define CONTROL_NUM_ENCODERS 0
+
+// MIDI input on a UART RX pin, mapped only when the patch has MIDI input objects
+#define CONTROL_MIDI 0
+#define CONTROL_MIDI_UART 0
+#define CONTROL_MIDI_RX_GPIO GPIO_NUM_NC
+
+// Control link (HvControlLink frames) on a UART, for streaming updates from a host
+#define CONTROL_LINK 0
+#define CONTROL_LINK_UART 0
+#define CONTROL_LINK_BAUD 0
+#define CONTROL_LINK_RX_GPIO GPIO_NUM_NC
+// the link addresses receivers by index, so the app needs their count to check them
+#define CONTROL_NUM_RECEIVERS 2
+
+// OSC input over UDP on WiFi, with the network set in menuconfig
+#define CONTROL_OSC 0
+#define CONTROL_OSC_PORT 0
+#define CONTROL_NUM_OSC_ADDRESSES 0
+
+static const ControlButton control_buttons[CONTROL_NUM_BUTTONS > 0 ? CONTROL_NUM_BUTTONS : 1] = {
+    { GPIO_NUM_32, HV_HEAVY_RECEIVER_INDEX_BUTTON1, HV_HEAVY_RECEIVER_BUTTON1, true, CONTROL_BUTTON_BANG }, // button1
+};
+
+static const ControlKnob control_knobs[CONTROL_NUM_KNOBS > 0 ? CONTROL_NUM_KNOBS : 1] = {
+    { ADC_CHANNEL_5, HV_HEAVY_PARAM_INDEX_KNOB1, HV_HEAVY_RECEIVER_KNOB1, 0.0f, 1.0f, CONTROL_CURVE_LINEAR }, // knob1 [0..1 linear]
+};
+
+static const ControlEncoder control_encoders[CONTROL_NUM_ENCODERS > 0 ? CONTROL_NUM_ENCODERS : 1] = {
+    { 0 }, // none
+};
+
+// Maps a position in [0, 1] onto a parameter range.
+static inline float control_scale(float min, float scale, ControlCurve curve, float x) {
+    return (curve == CONTROL_CURVE_EXP) ? min * expf(x * scale) : min + x * scale;
+}
+
+static inline float control_knob_value(const ControlKnob *k, float x) {
+    return control_scale(k->min, k->scale, k->curve, x);
+}
+
+static inline float control_encoder_value(const ControlEncoder *e, float x) {
+    return control_scale(e->min, e->scale, e->curve, x);
+}
+
+// sorted by hash for control_osc_find()
+static const ControlOscAddress control_osc_addresses[CONTROL_NUM_OSC_ADDRESSES > 0 ? CONTROL_NUM_OSC_ADDRESSES : 1] = {
+    { 0 }, // none
+};
+
+// Returns the mapping of an OSC address, or NULL if it has none.
+static inline const ControlOscAddress *control_osc_find(const char *address) {
+    const hv_uint32_t hash = hv_stringToHash(address);
+    int lo = 0, hi = CONTROL_NUM_OSC_ADDRESSES;
+    while (lo < hi) {
+        const int mid = (lo + hi) >> 1;
+        if (control_osc_addresses[mid].hash < hash) lo = mid + 1;
+        else hi = mid;
+    }
+    for (; lo < CONTROL_NUM_OSC_ADDRESSES && control_osc_addresses[lo].hash == hash; ++lo) {
+        if (strcmp(control_osc_addresses[lo].address, address) == 0) return &control_osc_addresses[lo];
+    }
+    return NULL;
+}
\ No newline at end of file
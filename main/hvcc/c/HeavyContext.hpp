@@ -19,11 +19,77 @@
 
 #include "HeavyContextInterface.hpp"
 #include "HvLightPipe.h"
+#include "HvMpscPipe.h"
+#include "HvNotifier.h"
 #include "HvMessageQueue.h"
 #include "HvMath.h"
+#include <atomic>
 
 struct HvTable;
 
+typedef void (HvReceiverTarget_t)(HeavyContextInterface *, int, const HvMessage *);
+
+// Dense receiver table emitted by c2espidf. Receiver i has hash hashes[i] and
+// forwards to targets[offsets[i]] .. targets[offsets[i+1]-1]. hashOrder lists the
+// indices sorted by hash, for a binary search from hash to index.
+typedef struct HvReceiverTable {
+  hv_uint32_t numReceivers;
+  const hv_uint32_t *hashes;
+  const hv_uint32_t *hashOrder;
+  const hv_uint32_t *offsets;
+  HvReceiverTarget_t *const *targets;
+} HvReceiverTable;
+
+// One slot per parameter of the patch. Any thread may store a new value; the store that
+// finds the slot taken queues a marker, and the audio thread forwards the value to the
+// receiver when it reaches the marker, unless the receiver already has it from the bank.
+typedef struct HvParameterSlot {
+  std::atomic<float> value;  // latest value written by setParameterValue()
+  std::atomic<bool> stored;  // set by the store that queues the marker, cleared by the audio thread
+  float applied;             // value last sent to the receiver, audio thread only; NaN if unknown
+  hv_uint32_t receiverIndex; // HV_RECEIVER_INDEX_NONE for parameters that cannot be set
+} HvParameterSlot;
+
+// Parameter index meaning "not a parameter"
+#define HV_PARAMETER_INDEX_NONE 0xFFFFFFFF
+
+// One slot per receiver index. The float that finds the slot empty queues a marker and
+// later ones only replace it, so the latest float is delivered where the first was sent.
+typedef struct HvLatestWinsSlot {
+  std::atomic<hv_uint32_t> value; // bits of the pending float, or HV_LATEST_WINS_EMPTY
+  std::atomic<bool> enabled;      // floats are queued like any message while false
+} HvLatestWinsSlot;
+
+// A NaN pattern, which never reaches a slot
+#define HV_LATEST_WINS_EMPTY 0xFFFFFFFF
+
+// An input queue record standing for the value pending in a latest-wins or parameter
+// slot. It is shorter than any ReceiverMessagePair, which tells the two apart.
+typedef struct HvInputMarker {
+  hv_uint32_t receiverIndex;  // the latest-wins slot, if parameterIndex is HV_PARAMETER_INDEX_NONE
+  hv_uint32_t parameterIndex; // the parameter slot
+} HvInputMarker;
+
+// Sends of the patch emitted by c2espidf, sorted by hash.
+typedef struct HvSendTable {
+  hv_uint32_t numSends;
+  const hv_uint32_t *hashes;
+} HvSendTable;
+
+// One slot per entry of the send table, set by subscribeSend().
+typedef struct HvSendSubscription {
+  std::atomic<HvSendCallback_t *> callback; // nullptr if nobody listens to this send
+  void *userData;
+} HvSendSubscription;
+
+// A block start sample paired with the host time it starts at. Written by the audio
+// thread only; readers retry while sequence is odd or changes under them (a seqlock).
+typedef struct HvSampleClock {
+  std::atomic<hv_uint32_t> sequence;
+  hv_uint64_t sample;
+  hv_int64_t timeUs;
+} HvSampleClock;
+
 class HeavyContext : public HeavyContextInterface {
 
  public:
@@ -35,8 +101,8 @@ class HeavyContext : public HeavyContextInterface {
   double getSampleRate() override { return sampleRate; }
 
   hv_uint32_t getCurrentSample() override { return blockStartTimestamp; }
-  float samplesToMilliseconds(hv_uint32_t numSamples) override { return (float) (1000.0*numSamples/sampleRate); }
-  hv_uint32_t millisecondsToSamples(float ms) override { return (hv_uint32_t) (hv_max_f(0.0f,ms)*sampleRate/1000.0); }
+  float samplesToMilliseconds(hv_uint32_t numSamples) override { return ((float) numSamples)*millisecondsPerSample; }
+  hv_uint32_t millisecondsToSamples(float ms) override;
 
   void setUserData(void *x) override { userData = x; }
   void *getUserData() override { return userData; }
@@ -49,11 +115,19 @@ class HeavyContext : public HeavyContextInterface {
   HvPrintHook_t *getPrintHook() override { return printHook; }
 
   // message scheduling
-  bool sendMessageToReceiver(hv_uint32_t receiverHash, double delayMs, HvMessage *m) override;
-  bool sendMessageToReceiverV(hv_uint32_t receiverHash, double delayMs, const char *fmt, ...) override;
+  bool sendMessageToReceiver(hv_uint32_t receiverHash, float delayMs, HvMessage *m) override;
+  bool sendMessageToReceiverV(hv_uint32_t receiverHash, float delayMs, const char *fmt, ...) override;
   bool sendFloatToReceiver(hv_uint32_t receiverHash, float f) override;
   bool sendBangToReceiver(hv_uint32_t receiverHash) override;
   bool sendSymbolToReceiver(hv_uint32_t receiverHash, const char *symbol) override;
+  bool sendMessageToReceiverIndex(hv_uint32_t receiverIndex, float delayMs, HvMessage *m) override;
+  bool sendFloatToReceiverIndex(hv_uint32_t receiverIndex, float f) override;
+  bool sendBangToReceiverIndex(hv_uint32_t receiverIndex) override;
+  bool sendSymbolToReceiverIndex(hv_uint32_t receiverIndex, const char *symbol) override;
+  int sendBatch(const HvEvent *events, int numEvents) override;
+  bool sendMessageAtSample(hv_uint32_t receiverHash, hv_uint64_t sample, HvMessage *m) override;
+  bool setParameterValue(int index, float value) override;
+  bool setReceiverLatestWins(hv_uint32_t receiverIndex, bool enable) override;
   bool cancelMessage(HvMessage *m, void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *)) override;
 
   // table manipulation
@@ -70,6 +144,17 @@ class HeavyContext : public HeavyContextInterface {
   void setInputMessageQueueSize(int inQueueKb) override;
   void setOutputMessageQueueSize(int outQueueKb) override;
   bool getNextSentMessage(hv_uint32_t *destinationHash, HvMessage *outMsg, hv_size_t msgLength) override;
+  bool subscribeSend(hv_uint32_t sendHash, HvSendCallback_t *f, void *userData) override;
+  int dispatchSentMessages() override;
+  bool waitForSentMessages(hv_uint32_t timeoutMs) override;
+  void setPrintQueueSize(int printQueueKb) override;
+  int dispatchPrints() override;
+  bool waitForPrints(hv_uint32_t timeoutMs) override;
+  hv_uint32_t getDroppedPrintCount() override { return numDroppedPrints.load(std::memory_order_relaxed); }
+
+  // sample clock
+  void setSampleClock(hv_int64_t timeUs) override;
+  hv_uint64_t timeToSample(hv_int64_t timeUs) override;
 
   // utility functions
   static hv_uint32_t getHashForString(const char *str);
@@ -81,6 +166,32 @@ class HeavyContext : public HeavyContextInterface {
   virtual void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) = 0;
   friend void _hv_scheduleMessageForReceiver(HeavyContextInterface *, hv_uint32_t, HvMessage *);
 
+  void scheduleMessageForReceiverIndex(hv_uint32_t receiverIndex, HvMessage *m);
+
+  // forgets the value a parameter's receiver last got from the bank, as a message sent to
+  // the receiver directly may have changed it; the next store is then always forwarded
+  void forgetAppliedParameter(hv_uint32_t receiverIndex);
+
+  // the index of a receiver, or HV_RECEIVER_INDEX_NONE if the patch has no such receiver
+  hv_uint32_t getReceiverIndex(hv_uint32_t receiverHash);
+
+  // moves all pending input messages, and the values their markers stand for, onto the
+  // message queue, called at the start of each block
+  void processInputQueue();
+
+  // sets the receiver table and allocates its latest-wins slots, called by the generated
+  // constructor before anything else uses the table
+  void initReceiverTable(const HvReceiverTable *table);
+
+  // allocates the parameter bank from getParameterInfo(), called by the generated constructor
+  void initParameterBank();
+
+  // allocates a subscription per entry of sendTable, called by the generated constructor
+  void initSendSubscriptions();
+
+  // the subscription for a send, or nullptr if the patch has no such send
+  HvSendSubscription *getSendSubscription(hv_uint32_t sendHash);
+
   HvMessage *scheduleMessageForObject(const HvMessage *,
       void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *),
       int);
@@ -90,18 +201,51 @@ class HeavyContext : public HeavyContextInterface {
 
   friend void defaultSendHook(HeavyContextInterface *, const char *, hv_uint32_t, const HvMessage *);
 
+  // copies a print object's message into printQueue, called on the audio thread
+  bool queuePrint(const char *name, const HvMessage *m);
+  friend bool _hv_queuePrint(HeavyContextInterface *, const char *, const HvMessage *);
+
+  friend float _hv_getSamplePeriod(HeavyContextInterface *);
+
   // object state
   double sampleRate;
+  float samplesPerMillisecond; // conversion factors cached in single precision,
+  float samplesPerMillisecondError; // as the ESP32 FPU has no double-precision support
+  float millisecondsPerSample;
+  float samplePeriod; // 1/sampleRate
   hv_uint32_t blockStartTimestamp;
   hv_size_t numBytes;
   HvMessageQueue mq;
   HvSendHook_t *sendHook;
   HvPrintHook_t *printHook;
   void *userData;
-  HvLightPipe inQueue;
+  HvMpscPipe inQueue;
   HvLightPipe outQueue;
-  hv_atomic_bool inQueueLock;
   hv_atomic_bool outQueueLock;
+  const HvReceiverTable *receiverTable;
+  HvParameterSlot *parameters;
+  hv_uint32_t numParameters;
+  hv_uint32_t *receiverParameters; // per receiver index, its parameter or HV_PARAMETER_INDEX_NONE
+  HvLatestWinsSlot *latestWins; // per receiver index, nullptr if the patch has no receivers
+  std::atomic<hv_uint32_t> numLatestWins; // at least the number of enabled slots
+  const HvSendTable *sendTable;
+  HvSendSubscription *subscriptions;
+  std::atomic<bool> filterSends; // set by the first subscribeSend()
+  HvNotifier outNotifier;        // signalled when the out queue becomes non-empty
+  HvMpscPipe printQueue;         // without a buffer unless setPrintQueueSize() was called
+  std::atomic<hv_uint32_t> numDroppedPrints;
+  HvNotifier printNotifier;
+  hv_uint32_t sampleRateHz;      // rounded, for integer host time conversion
+  HvSampleClock sampleClock;
+
+ private:
+  bool enqueueMessage(hv_uint32_t receiverHash, hv_uint32_t receiverIndex, hv_uint32_t timestamp, HvMessage *m);
+
+  // stores an undelayed float for a latest-wins receiver, returns false if m must be queued
+  bool storeLatestValue(hv_uint32_t receiverIndex, const HvMessage *m);
+
+  // queues the marker of a slot that just took a value, returns false if the queue is full
+  bool queueMarker(hv_uint32_t receiverIndex, hv_uint32_t parameterIndex);
 };
 
 #endif // _HEAVY_CONTEXT_H_
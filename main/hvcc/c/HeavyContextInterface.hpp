@@ -44,6 +44,18 @@ typedef struct HvParameterInfo {
 typedef void (HvSendHook_t) (HeavyContextInterface *context, const char *sendName, hv_uint32_t sendHash, const HvMessage *msg);
 typedef void (HvPrintHook_t) (HeavyContextInterface *context, const char *printName, const char *str, const HvMessage *msg);
 
+// Receiver index meaning "address the receiver by its hash instead"
+#define HV_RECEIVER_INDEX_NONE 0xFFFFFFFF
+
+typedef struct HvEvent {
+  hv_uint32_t receiverHash;  // used when receiverIndex is HV_RECEIVER_INDEX_NONE
+  hv_uint32_t receiverIndex; // dense receiver index, e.g. HV_HEAVY_RECEIVER_INDEX_KNOB1
+  const HvMessage *msg;      // copied into the input queue
+  hv_uint64_t sample;        // absolute sample time to process the event at, 0 for the next block
+} HvEvent;
+
+typedef void (HvSendCallback_t) (HeavyContextInterface *context, hv_uint32_t sendHash, const HvMessage *msg, void *userData);
+
 #endif // _HEAVY_DECLARATIONS_
 
 
@@ -148,7 +160,7 @@ class HeavyContextInterface {
    * @return  True if the message was accepted. False if the message could not fit onto
    *          the message queue to be processed this block.
    */
-  virtual bool sendMessageToReceiver(hv_uint32_t receiverHash, double delayMs, HvMessage *m) = 0;
+  virtual bool sendMessageToReceiver(hv_uint32_t receiverHash, float delayMs, HvMessage *m) = 0;
 
   /**
    * Sends a formatted message to a receiver that can be scheduled for the future.
@@ -158,7 +170,7 @@ class HeavyContextInterface {
    * @return  True if the message was accepted. False if the message could not fit onto
    *          the message queue to be processed this block.
    */
-  virtual bool sendMessageToReceiverV(hv_uint32_t receiverHash, double delayMs, const char *fmt, ...) = 0;
+  virtual bool sendMessageToReceiverV(hv_uint32_t receiverHash, float delayMs, const char *fmt, ...) = 0;
 
   /**
    * A convenience function to send a float to a receiver to be processed immediately.
@@ -190,6 +202,77 @@ class HeavyContextInterface {
    */
   virtual bool sendSymbolToReceiver(hv_uint32_t receiverHash, const char *symbol)  = 0;
 
+  /**
+   * Sends a message to a receiver addressed by its dense index, as generated in the
+   * patch header (e.g. HV_HEAVY_RECEIVER_INDEX_KNOB1). Dispatch is a table lookup
+   * rather than a search over receiver hashes.
+   * This function is thread-safe.
+   *
+   * @return  True if the message was accepted. False if the index is out of range or
+   *          the message could not fit onto the message queue to be processed this block.
+   */
+  virtual bool sendMessageToReceiverIndex(hv_uint32_t receiverIndex, float delayMs, HvMessage *m) = 0;
+
+  /**
+   * A convenience function to send a float to a receiver addressed by its index.
+   * This function is thread-safe.
+   *
+   * @return  True if the message was accepted.
+   */
+  virtual bool sendFloatToReceiverIndex(hv_uint32_t receiverIndex, float f) = 0;
+
+  /**
+   * A convenience function to send a bang to a receiver addressed by its index.
+   * This function is thread-safe.
+   *
+   * @return  True if the message was accepted.
+   */
+  virtual bool sendBangToReceiverIndex(hv_uint32_t receiverIndex) = 0;
+
+  /**
+   * A convenience function to send a symbol to a receiver addressed by its index.
+   * This function is thread-safe.
+   *
+   * @return  True if the message was accepted.
+   */
+  virtual bool sendSymbolToReceiverIndex(hv_uint32_t receiverIndex, const char *symbol) = 0;
+
+  /**
+   * Sends several messages, each processed at its event's sample time or at the start of
+   * the next block if that time has passed. Space in the input queue is reserved once and
+   * all accepted events are published together with one fence.
+   * This function is thread-safe.
+   *
+   * @return  The number of leading events that were accepted. Events from that position on
+   *          were not sent, either because the input queue is full or because the event
+   *          names an invalid receiver index.
+   */
+  virtual int sendBatch(const HvEvent *events, int numEvents) = 0;
+
+  /**
+   * Sends a message to be processed at an absolute sample time, e.g. one returned by
+   * timeToSample(). A time that has already passed is processed at the start of the next block.
+   * Internally times wrap every 2^32 samples, so the sample should be within 2^31 samples
+   * (about 12 hours at 48kHz) of the current time.
+   * This function is thread-safe.
+   *
+   * @return  True if the message was accepted.
+   */
+  virtual bool sendMessageAtSample(hv_uint32_t receiverHash, hv_uint64_t sample, HvMessage *m) = 0;
+
+  /**
+   * Records the host time, in microseconds of any monotonic clock, at which the next
+   * block to be processed starts. Call it from the audio thread before each process().
+   */
+  virtual void setSampleClock(hv_int64_t timeUs) = 0;
+
+  /**
+   * Converts a host time from the clock given to setSampleClock() into an absolute sample
+   * time, extrapolating from the most recent reference. Returns 0 before the first reference.
+   * This function is thread-safe.
+   */
+  virtual hv_uint64_t timeToSample(hv_int64_t timeUs) = 0;
+
   /**
    * Cancels a previously scheduled message.
    *
@@ -208,6 +291,34 @@ class HeavyContextInterface {
    */
   virtual int getParameterInfo(int index, HvParameterInfo *info) = 0;
 
+  /**
+   * Sets an input parameter, addressed by its getParameterInfo() index, e.g.
+   * HV_HEAVY_PARAM_INDEX_KNOB1. The value is an atomic store, and the first store since the
+   * last delivery queues a marker for it. The latest value is sent to the parameter's
+   * receiver where the marker was queued, so it keeps its order with the messages sent
+   * before and after it, unless the receiver already got the same value from the bank and
+   * no other message since (the first store is always sent). Intermediate values stored
+   * before the marker is reached are not seen by the patch.
+   * This function is thread-safe and lock-free.
+   *
+   * @return  False if the index does not name an input parameter, the value is NaN, or
+   *          the input queue has no room for the marker.
+   */
+  virtual bool setParameterValue(int index, float value) = 0;
+
+  /**
+   * Makes a receiver latest-wins: a float sent to it without delay, while an earlier one is
+   * still pending, replaces that float instead of queueing behind it. The latest float is
+   * delivered in the place the first of them took in the input queue, so it keeps its order
+   * with the messages sent before and after it. Bangs, symbols, lists, delayed and batched
+   * messages are queued as usual. A float still pending when it is switched off is delivered
+   * in its place all the same.
+   * This function is thread-safe and lock-free.
+   *
+   * @return  False if the index is out of range.
+   */
+  virtual bool setReceiverLatestWins(hv_uint32_t receiverIndex, bool latestWins) = 0;
+
   /** Returns a pointer to the raw buffer backing this table. DO NOT free it. */
   virtual float *getBufferForTable(hv_uint32_t tableHash) = 0;
 
@@ -228,27 +339,20 @@ class HeavyContextInterface {
   virtual bool setLengthForTable(hv_uint32_t tableHash, hv_uint32_t newSampleLength) = 0;
 
   /**
-   * Acquire the input message queue lock.
-   *
-   * This function will block until the message lock as been acquired.
-   * Typical applications will not require the use of this function.
+   * Does nothing: the input message queue is lock-free, and there is no lock to
+   * acquire. Kept for compatibility with code written for the stock runtime.
    */
   virtual void lockAcquire() = 0;
 
   /**
-   * Try to acquire the input message queue lock.
-   *
-   * If the lock has been acquired, hv_lock_release() must be called to release it.
-   * Typical applications will not require the use of this function.
+   * Does nothing, see lockAcquire().
    *
-   * @return Returns true if the lock has been acquired, false otherwise.
+   * @return Always true.
    */
   virtual bool lockTry() = 0;
 
   /**
-   * Release the input message queue lock.
-   *
-   * Typical applications will not require the use of this function.
+   * Does nothing, see lockAcquire().
    */
   virtual void lockRelease() = 0;
 
@@ -284,6 +388,56 @@ class HeavyContextInterface {
   */
   virtual bool getNextSentMessage(hv_uint32_t *destinationHash, HvMessage *outMsg, hv_size_t msgLengthBytes) = 0;
 
+  /**
+   * Registers a callback for messages sent to a send of the patch. Once any
+   * callback is registered, messages to sends without one are dropped by the
+   * default send hook.
+   *
+   * @param sendHash  The hash of a send known to the patch.
+   * @param f  The callback, or NULL to unsubscribe.
+   * @param userData  Passed to the callback.
+   *
+   * @return  False if the patch has no such send or no outgoing message queue.
+   */
+  virtual bool subscribeSend(hv_uint32_t sendHash, HvSendCallback_t *f, void *userData) = 0;
+
+  /**
+   * Calls the registered callbacks for all queued outgoing messages.
+   *
+   * @return  The number of callbacks made.
+   */
+  virtual int dispatchSentMessages() = 0;
+
+  /**
+   * Blocks until an outgoing message is queued or the timeout passes.
+   *
+   * @return  True if messages were queued since the last wait.
+   */
+  virtual bool waitForSentMessages(hv_uint32_t timeoutMs) = 0;
+
+  /**
+   * Defers print objects to a queue of the given size, so that the audio thread
+   * only copies their messages. Zero turns the queue off.
+   */
+  virtual void setPrintQueueSize(int printQueueKb) = 0;
+
+  /**
+   * Formats the queued print messages and passes them to the print hook.
+   *
+   * @return  The number of messages printed.
+   */
+  virtual int dispatchPrints() = 0;
+
+  /**
+   * Blocks until a print message is queued or the timeout passes.
+   *
+   * @return  True if messages were queued since the last wait.
+   */
+  virtual bool waitForPrints(hv_uint32_t timeoutMs) = 0;
+
+  /** Returns how many print messages were dropped because the print queue was full. */
+  virtual hv_uint32_t getDroppedPrintCount() = 0;
+
   /** Returns a 32-bit hash of any string. Returns 0 if string is NULL. */
   static hv_uint32_t getHashForString(const char *str);
 };
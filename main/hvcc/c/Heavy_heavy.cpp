@@ -83,7 +83,12 @@ extern "C" {
 
 Heavy_heavy::Heavy_heavy(double sampleRate, int poolKb, int inQueueKb, int outQueueKb)
     : HeavyContext(sampleRate, poolKb, inQueueKb, outQueueKb) {
-  numBytes += sPhasor_k_init(&sPhasor_v6LXxBSD, 220.0f, sampleRate);
+  initReceiverTable(&receiverIndexTable);
+  initParameterBank();
+  numBytes += sLine_init(&sLine_lslpgGG9);
+  numBytes += sPhasor_init(&sPhasor_Kx9NGmH8, sampleRate);
+  numBytes += cVar_init_f(&cVar_JJxGO5uD, 1.0f);
+  numBytes += sVarf_init(&sVarf_9Yw9VJv7, 0.0f, 0.0f, false);
   
 }
 
@@ -97,13 +102,53 @@ HvTable *Heavy_heavy::getTableForHash(hv_uint32_t tableHash) {
 
 void Heavy_heavy::scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) {
   switch (receiverHash) {
+    case 0xFB2DC5B6: { // button1
+      mq_addMessageByTimestamp(&mq, m, 0, &cReceive_9XVin2Wu_sendMessage);
+      break;
+    }
+    case 0x3A6EC41A: { // knob1
+      mq_addMessageByTimestamp(&mq, m, 0, &cReceive_k2c9h0Zw_sendMessage);
+      break;
+    }
     default: return;
   }
 }
 
+/*
+ * Receiver index table (generated by c2espidf), ordered as HV_HEAVY_RECEIVER_INDEX_*
+ */
+
+static const hv_uint32_t receiverIndexHashes[] = {
+  0xFB2DC5B6, // button1
+  0x3A6EC41A, // knob1
+};
+
+// indices sorted by hash, for looking up receivers by hash
+static const hv_uint32_t receiverIndexHashOrder[] = { 1, 0 };
+
+static const hv_uint32_t receiverIndexOffsets[] = { 0, 1, 2 };
+
+HvReceiverTarget_t *const Heavy_heavy::receiverIndexTargets[] = {
+  &cReceive_9XVin2Wu_sendMessage, // button1
+  &cReceive_k2c9h0Zw_sendMessage, // knob1
+};
+
+const HvReceiverTable Heavy_heavy::receiverIndexTable = {
+  2, receiverIndexHashes, receiverIndexHashOrder, receiverIndexOffsets, receiverIndexTargets
+};
+
 int Heavy_heavy::getParameterInfo(int index, HvParameterInfo *info) {
   if (info != nullptr) {
     switch (index) {
+      case 0: {
+        info->name = "knob1";
+        info->hash = 0x3A6EC41A;
+        info->type = HvParameterType::HV_PARAM_TYPE_PARAMETER_IN;
+        info->minVal = 0.0f;
+        info->maxVal = 1.0f;
+        info->defaultVal = 0.5f;
+        break;
+      }
       default: {
         info->name = "invalid parameter index";
         info->hash = 0;
@@ -115,7 +160,7 @@ int Heavy_heavy::getParameterInfo(int index, HvParameterInfo *info) {
       }
     }
   }
-  return 0;
+  return 1;
 }
 
 
@@ -125,6 +170,41 @@ int Heavy_heavy::getParameterInfo(int index, HvParameterInfo *info) {
  */
 
 
+void Heavy_heavy::cCast_3KKfB4jm_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *m) {
+  cVar_onMessage(_c, &Context(_c)->cVar_JJxGO5uD, 0, m, &cVar_JJxGO5uD_sendMessage);
+}
+
+void Heavy_heavy::cVar_JJxGO5uD_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *m) {
+  cBinop_k_onMessage(_c, NULL, HV_BINOP_EQ, 0.0f, 0, m, &cBinop_7kLdQtQj_sendMessage);
+  sVarf_onMessage(_c, &Context(_c)->sVarf_9Yw9VJv7, m);
+}
+
+void Heavy_heavy::cBinop_7kLdQtQj_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *m) {
+  cVar_onMessage(_c, &Context(_c)->cVar_JJxGO5uD, 1, m, &cVar_JJxGO5uD_sendMessage);
+}
+
+void Heavy_heavy::cBinop_hFXSBwLf_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *m) {
+  cMsg_dPhd7lA9_sendMessage(_c, 0, m);
+}
+
+void Heavy_heavy::cMsg_dPhd7lA9_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *const n) {
+  HvMessage *m = nullptr;
+  m = HV_MESSAGE_ON_STACK(2);
+  msg_init(m, 2, msg_getTimestamp(n));
+  msg_setElementToFrom(m, 0, n, 0);
+  msg_setFloat(m, 1, 50.0f);
+  sLine_onMessage(_c, &Context(_c)->sLine_lslpgGG9, 0, m, NULL);
+}
+
+void Heavy_heavy::cReceive_k2c9h0Zw_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *m) {
+  cBinop_k_onMessage(_c, NULL, HV_BINOP_MULTIPLY, 1000.0f, 0, m, &cBinop_hFXSBwLf_sendMessage);
+}
+
+void Heavy_heavy::cReceive_9XVin2Wu_sendMessage(HeavyContextInterface *_c, int letIn, const HvMessage *m) {
+  cCast_onMessage(_c, HV_CAST_BANG, 0, m, &cCast_3KKfB4jm_sendMessage);
+  cPrint_onMessage(_c, m, "button1");
+}
+
 
 
 /*
@@ -142,19 +222,13 @@ int Heavy_heavy::getParameterInfo(int index, HvParameterInfo *info) {
  */
 
 int Heavy_heavy::process(float **inputBuffers, float **outputBuffers, int n) {
-  while (hLp_hasData(&inQueue)) {
-    hv_uint32_t numBytes = 0;
-    ReceiverMessagePair *p = reinterpret_cast<ReceiverMessagePair *>(hLp_getReadBuffer(&inQueue, &numBytes));
-    hv_assert(numBytes >= sizeof(ReceiverMessagePair));
-    scheduleMessageForReceiver(p->receiverHash, &p->msg);
-    hLp_consume(&inQueue);
-  }
+  processInputQueue();
 
   sendBangToReceiver(0xDD21C0EB); // send to __hv_bang~ on next cycle
   const int n4 = n & ~HV_N_SIMD_MASK; // ensure that the block size is a multiple of HV_N_SIMD
 
   // temporary signal vars
-  hv_bufferf_t Bf0, Bf1, Bf2, Bf3, Bf4;
+  hv_bufferf_t Bf0, Bf1;
 
   // input and output vars
   hv_bufferf_t O0, O1;
@@ -180,25 +254,14 @@ int Heavy_heavy::process(float **inputBuffers, float **outputBuffers, int n) {
     __hv_zero_f(VOf(O1));
 
     // process all signal functions
-    __hv_phasor_k_f(&sPhasor_v6LXxBSD, VOf(Bf0));
-    __hv_var_k_f(VOf(Bf1), 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f);
-    __hv_sub_f(VIf(Bf0), VIf(Bf1), VOf(Bf1));
-    __hv_abs_f(VIf(Bf1), VOf(Bf1));
-    __hv_var_k_f(VOf(Bf0), 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f);
-    __hv_sub_f(VIf(Bf1), VIf(Bf0), VOf(Bf0));
-    __hv_var_k_f(VOf(Bf1), 6.283185307179586f, 6.283185307179586f, 6.283185307179586f, 6.283185307179586f, 6.283185307179586f, 6.283185307179586f, 6.283185307179586f, 6.283185307179586f);
+    __hv_line_f(&sLine_lslpgGG9, VOf(Bf0));
+    __hv_phasor_f(&sPhasor_Kx9NGmH8, VIf(Bf0), VOf(Bf0));
+    __hv_varread_f(&sVarf_9Yw9VJv7, VOf(Bf1));
     __hv_mul_f(VIf(Bf0), VIf(Bf1), VOf(Bf1));
-    __hv_mul_f(VIf(Bf1), VIf(Bf1), VOf(Bf0));
-    __hv_mul_f(VIf(Bf1), VIf(Bf0), VOf(Bf2));
-    __hv_mul_f(VIf(Bf2), VIf(Bf0), VOf(Bf0));
-    __hv_var_k_f(VOf(Bf3), 0.007833333333333f, 0.007833333333333f, 0.007833333333333f, 0.007833333333333f, 0.007833333333333f, 0.007833333333333f, 0.007833333333333f, 0.007833333333333f);
-    __hv_var_k_f(VOf(Bf4), -0.166666666666667f, -0.166666666666667f, -0.166666666666667f, -0.166666666666667f, -0.166666666666667f, -0.166666666666667f, -0.166666666666667f, -0.166666666666667f);
-    __hv_fma_f(VIf(Bf2), VIf(Bf4), VIf(Bf1), VOf(Bf1));
-    __hv_fma_f(VIf(Bf0), VIf(Bf3), VIf(Bf1), VOf(Bf1));
-    __hv_var_k_f(VOf(Bf3), 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f);
-    __hv_mul_f(VIf(Bf1), VIf(Bf3), VOf(Bf3));
-    __hv_add_f(VIf(Bf3), VIf(O1), VOf(O1));
-    __hv_add_f(VIf(Bf3), VIf(O0), VOf(O0));
+    __hv_var_k_f(VOf(Bf0), 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f, 0.1f);
+    __hv_mul_f(VIf(Bf1), VIf(Bf0), VOf(Bf0));
+    __hv_add_f(VIf(Bf0), VIf(O0), VOf(O0));
+    __hv_add_f(VIf(Bf0), VIf(O1), VOf(O1));
 
     // save output vars to output buffer
     __hv_store_f(outputBuffers[0]+n, VIf(O0));
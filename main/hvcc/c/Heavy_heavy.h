@@ -43,8 +43,28 @@ extern "C" {
 #pragma mark - Heavy Context
 #endif
 
+typedef enum {
+  HV_HEAVY_PARAM_IN_KNOB1 = 0x3A6EC41A, // knob1
+} Hv_heavy_ParameterIn;
 
 
+// Receiver hashes known at generation time (generated by c2espidf)
+typedef enum {
+  HV_HEAVY_RECEIVER_BUTTON1 = 0xFB2DC5B6, // button1
+  HV_HEAVY_RECEIVER_KNOB1 = 0x3A6EC41A, // knob1
+} Hv_heavy_Receiver;
+
+// Receiver indices known at generation time (generated by c2espidf)
+typedef enum {
+  HV_HEAVY_RECEIVER_INDEX_BUTTON1 = 0, // button1
+  HV_HEAVY_RECEIVER_INDEX_KNOB1 = 1, // knob1
+} Hv_heavy_ReceiverIndex;
+
+// Input parameter indices known at generation time (generated by c2espidf)
+typedef enum {
+  HV_HEAVY_PARAM_INDEX_KNOB1 = 0, // knob1
+} Hv_heavy_ParameterIndex;
+
 /**
  * Creates a new patch instance.
  * Sample rate should be positive and in Hertz, e.g. 44100.0.
@@ -35,9 +35,14 @@
 
 // object includes
 #include "HeavyContext.hpp"
-#include "HvMath.h"
-#include "HvSignalVar.h"
+#include "HvSignalLine.h"
+#include "HvControlCast.h"
 #include "HvSignalPhasor.h"
+#include "HvSignalVar.h"
+#include "HvControlBinop.h"
+#include "HvControlPrint.h"
+#include "HvControlVar.h"
+#include "HvMath.h"
 
 class Heavy_heavy : public HeavyContext {
 
@@ -54,10 +59,19 @@ class Heavy_heavy : public HeavyContext {
   int processInlineInterleaved(float *inputBuffers, float *outputBuffer, int n) override;
 
   int getParameterInfo(int index, HvParameterInfo *info) override;
+  struct Parameter {
+    struct In {
+      enum ParameterIn : hv_uint32_t {
+        KNOB1 = 0x3A6EC41A, // knob1
+      };
+    };
+  };
 
  private:
   HvTable *getTableForHash(hv_uint32_t tableHash) override;
   void scheduleMessageForReceiver(hv_uint32_t receiverHash, HvMessage *m) override;
+  static HvReceiverTarget_t *const receiverIndexTargets[];
+  static const HvReceiverTable receiverIndexTable;
 
 
   /*
@@ -71,9 +85,21 @@ class Heavy_heavy : public HeavyContext {
 
 
   // static sendMessage functions
+  static void cCast_3KKfB4jm_sendMessage(HeavyContextInterface *, int, const HvMessage *);
+  static void cVar_JJxGO5uD_sendMessage(HeavyContextInterface *, int, const HvMessage *);
+  static void cBinop_7kLdQtQj_sendMessage(HeavyContextInterface *, int, const HvMessage *);
+  static void cBinop_hFXSBwLf_sendMessage(HeavyContextInterface *, int, const HvMessage *);
+  static void cMsg_dPhd7lA9_sendMessage(HeavyContextInterface *, int, const HvMessage *);
+  static void cReceive_k2c9h0Zw_sendMessage(HeavyContextInterface *, int, const HvMessage *);
+  static void cReceive_9XVin2Wu_sendMessage(HeavyContextInterface *, int, const HvMessage *);
 
   // objects
-  SignalPhasor sPhasor_v6LXxBSD;
+  SignalLine sLine_lslpgGG9;
+  SignalPhasor sPhasor_Kx9NGmH8;
+  ControlVar cVar_JJxGO5uD;
+  ControlBinop cBinop_7kLdQtQj;
+  ControlBinop cBinop_hFXSBwLf;
+  SignalVarf sVarf_9Yw9VJv7;
 };
 
 #endif // _HEAVY_CONTEXT_HEAVY_HPP_
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvAudioIo.h"
+
+void hAi_readS16(float *out, hv_uint32_t numChannels, const hv_int16_t *in, hv_uint32_t numSlots, hv_uint32_t numFrames) {
+  const hv_uint32_t n = (numChannels < numSlots) ? numChannels : numSlots;
+  for (hv_uint32_t i = 0; i < numFrames; ++i, in += numSlots) {
+    for (hv_uint32_t c = 0; c < n; ++c) out[c * numFrames + i] = (float) in[c] * (1.0f / 32768.0f);
+  }
+  if (n < numChannels) hv_memclear(out + n * numFrames, (numChannels - n) * numFrames * sizeof(float));
+}
+
+void hAi_readS32(float *out, hv_uint32_t numChannels, const hv_int32_t *in, hv_uint32_t numSlots, hv_uint32_t numFrames) {
+  const hv_uint32_t n = (numChannels < numSlots) ? numChannels : numSlots;
+  for (hv_uint32_t i = 0; i < numFrames; ++i, in += numSlots) {
+    for (hv_uint32_t c = 0; c < n; ++c) out[c * numFrames + i] = (float) in[c] * (1.0f / 2147483648.0f);
+  }
+  if (n < numChannels) hv_memclear(out + n * numFrames, (numChannels - n) * numFrames * sizeof(float));
+}
+
+static HV_FORCE_INLINE float hAi_clip(float x) {
+  return (x > 1.0f) ? 1.0f : ((x < -1.0f) ? -1.0f : x);
+}
+
+// Meters are summed in locals up to this many channels. As far as the compiler
+// knows, the input may alias them, which would keep them in memory.
+#define HV_AUDIO_IO_LOCAL_METERS 8
+
+// Slot c < n takes channel c at in + c * stride, or the one channel with a stride
+// of 0, and the remaining slots are silent. Inlined with constant slot counts,
+// so that the fast paths unroll.
+static HV_FORCE_INLINE void hAi_framesS16(hv_int16_t *out, hv_uint32_t numSlots, hv_uint32_t n, const float *in,
+    hv_uint32_t stride, hv_uint32_t numFrames, HvMeterAccum *accum) {
+  HvMeterAccum local[HV_AUDIO_IO_LOCAL_METERS];
+  HvMeterAccum *a = (accum != NULL && n <= HV_AUDIO_IO_LOCAL_METERS) ? local : accum;
+  if (a == local) hv_memcpy(local, accum, n * sizeof(HvMeterAccum));
+  for (hv_uint32_t i = 0; i < numFrames; ++i, out += numSlots) {
+    for (hv_uint32_t c = 0; c < n; ++c) {
+      const float x = in[c * stride + i];
+      if (a != NULL) hMe_accumulate(&a[c], x);
+      out[c] = (hv_int16_t) (hAi_clip(x) * 32767.0f);
+    }
+    for (hv_uint32_t c = n; c < numSlots; ++c) out[c] = 0;
+  }
+  if (a == local) hv_memcpy(accum, local, n * sizeof(HvMeterAccum));
+}
+
+static HV_FORCE_INLINE void hAi_framesS32(hv_int32_t *out, hv_uint32_t numSlots, hv_uint32_t n, const float *in,
+    hv_uint32_t stride, hv_uint32_t numFrames, HvMeterAccum *accum) {
+  HvMeterAccum local[HV_AUDIO_IO_LOCAL_METERS];
+  HvMeterAccum *a = (accum != NULL && n <= HV_AUDIO_IO_LOCAL_METERS) ? local : accum;
+  if (a == local) hv_memcpy(local, accum, n * sizeof(HvMeterAccum));
+  for (hv_uint32_t i = 0; i < numFrames; ++i, out += numSlots) {
+    for (hv_uint32_t c = 0; c < n; ++c) {
+      const float x = in[c * stride + i];
+      if (a != NULL) hMe_accumulate(&a[c], x);
+      out[c] = (hv_int32_t) (hAi_clip(x) * 2147483520.0f); // the largest float below 2^31
+    }
+    for (hv_uint32_t c = n; c < numSlots; ++c) out[c] = 0;
+  }
+  if (a == local) hv_memcpy(accum, local, n * sizeof(HvMeterAccum));
+}
+
+void hAi_writeS16(hv_int16_t *out, hv_uint32_t numSlots, const float *in, hv_uint32_t numChannels, hv_uint32_t numFrames,
+    HvMeterAccum *accum) {
+  const hv_uint32_t stride = (numChannels == 1) ? 0 : numFrames;
+  if (numChannels == numSlots || numChannels == 1) {
+    switch (numSlots) {
+      case 2: hAi_framesS16(out, 2, 2, in, stride, numFrames, accum); return;
+      case 4: hAi_framesS16(out, 4, 4, in, stride, numFrames, accum); return;
+      case 8: hAi_framesS16(out, 8, 8, in, stride, numFrames, accum); return;
+      default: break;
+    }
+  }
+  const hv_uint32_t n = (numChannels == 1 || numChannels > numSlots) ? numSlots : numChannels;
+  hAi_framesS16(out, numSlots, n, in, stride, numFrames, accum);
+}
+
+void hAi_writeS32(hv_int32_t *out, hv_uint32_t numSlots, const float *in, hv_uint32_t numChannels, hv_uint32_t numFrames,
+    HvMeterAccum *accum) {
+  const hv_uint32_t stride = (numChannels == 1) ? 0 : numFrames;
+  if (numChannels == numSlots || numChannels == 1) {
+    switch (numSlots) {
+      case 2: hAi_framesS32(out, 2, 2, in, stride, numFrames, accum); return;
+      case 4: hAi_framesS32(out, 4, 4, in, stride, numFrames, accum); return;
+      case 8: hAi_framesS32(out, 8, 8, in, stride, numFrames, accum); return;
+      default: break;
+    }
+  }
+  const hv_uint32_t n = (numChannels == 1 || numChannels > numSlots) ? numSlots : numChannels;
+  hAi_framesS32(out, numSlots, n, in, stride, numFrames, accum);
+}
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvControlLink.h"
+
+// CRC-16/CCITT-FALSE, a byte at a time without a table
+static inline hv_uint16_t hCl_crc(hv_uint16_t crc, hv_uint8_t b) {
+  hv_uint8_t x = (hv_uint8_t) ((crc >> 8) ^ b);
+  x ^= x >> 4;
+  return (hv_uint16_t) ((crc << 8) ^ ((hv_uint16_t) x << 12) ^ ((hv_uint16_t) x << 5) ^ x);
+}
+
+static hv_uint16_t hCl_crcOf(const hv_uint8_t *bytes, hv_uint32_t numBytes) {
+  hv_uint16_t crc = 0xFFFF;
+  for (hv_uint32_t i = 0; i < numBytes; ++i) crc = hCl_crc(crc, bytes[i]);
+  return crc;
+}
+
+void hCl_init(HvControlLink *o) {
+  hCl_reset(o);
+  o->started = false;
+  o->seq = 0;
+  o->numFrames = 0;
+  o->numBadFrames = 0;
+  o->numLostFrames = 0;
+}
+
+void hCl_reset(HvControlLink *o) {
+  o->length = 0;
+  o->expected = 0;
+  o->sync = false;
+}
+
+hv_uint32_t hCl_parse(HvControlLink *o, const hv_uint8_t *bytes, hv_uint32_t numBytes, hv_uint32_t *numUpdates) {
+  *numUpdates = 0;
+  for (hv_uint32_t i = 0; i < numBytes; ++i) {
+    const hv_uint8_t b = bytes[i];
+    if (o->expected == 0) {
+      if (o->sync && b == HV_CONTROL_LINK_SYNC1) {
+        o->length = 0;
+        o->expected = 2; // seq and count, then the length is known
+        o->sync = false;
+      } else {
+        o->sync = (b == HV_CONTROL_LINK_SYNC0);
+      }
+      continue;
+    }
+
+    o->frame[o->length++] = b;
+    if (o->length == 2) {
+      if (b == 0 || b > HV_CONTROL_LINK_MAX_UPDATES) {
+        o->numBadFrames++;
+        o->expected = 0;
+        continue;
+      }
+      o->expected = 2 + b * HV_CONTROL_LINK_UPDATE_BYTES + 2;
+    }
+    if (o->length < o->expected) continue;
+
+    o->expected = 0;
+    const hv_uint32_t n = o->length - 2;
+    const hv_uint16_t crc = (hv_uint16_t) (o->frame[n] | (o->frame[n + 1] << 8));
+    if (hCl_crcOf(o->frame, n) != crc) {
+      o->numBadFrames++;
+      continue;
+    }
+    const hv_uint8_t seq = o->frame[0];
+    if (o->started) o->numLostFrames += (hv_uint8_t) (seq - o->seq - 1);
+    o->started = true;
+    o->seq = seq;
+    o->numFrames++;
+    *numUpdates = o->frame[1];
+    return i + 1;
+  }
+  return numBytes;
+}
+
+HvControlUpdate hCl_getUpdate(const HvControlLink *o, hv_uint32_t i) {
+  const hv_uint8_t *p = o->frame + 2 + i * HV_CONTROL_LINK_UPDATE_BYTES;
+  const hv_uint32_t bits = (hv_uint32_t) p[2] | ((hv_uint32_t) p[3] << 8) | ((hv_uint32_t) p[4] << 16) | ((hv_uint32_t) p[5] << 24);
+  HvControlUpdate u;
+  u.index = (hv_uint16_t) (p[0] | (p[1] << 8));
+  hv_memcpy(&u.value, &bits, sizeof(float));
+  return u;
+}
+
+hv_uint32_t hCl_encode(hv_uint8_t *out, hv_uint8_t seq, const HvControlUpdate *updates, hv_uint32_t numUpdates) {
+  hv_assert(numUpdates > 0 && numUpdates <= HV_CONTROL_LINK_MAX_UPDATES);
+  hv_uint8_t *p = out;
+  *p++ = HV_CONTROL_LINK_SYNC0;
+  *p++ = HV_CONTROL_LINK_SYNC1;
+  *p++ = seq;
+  *p++ = (hv_uint8_t) numUpdates;
+  for (hv_uint32_t i = 0; i < numUpdates; ++i) {
+    hv_uint32_t bits;
+    hv_memcpy(&bits, &updates[i].value, sizeof(float));
+    *p++ = (hv_uint8_t) updates[i].index;
+    *p++ = (hv_uint8_t) (updates[i].index >> 8);
+    for (int k = 0; k < 4; ++k) *p++ = (hv_uint8_t) (bits >> (8 * k));
+  }
+  const hv_uint16_t crc = hCl_crcOf(out + 2, (hv_uint32_t) (p - out - 2));
+  *p++ = (hv_uint8_t) crc;
+  *p++ = (hv_uint8_t) (crc >> 8);
+  return (hv_uint32_t) (p - out);
+}
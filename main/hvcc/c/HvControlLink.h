@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_CONTROL_LINK_H_
+#define _HEAVY_CONTROL_LINK_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A framed binary protocol for streaming control updates from a host, e.g.
+ * over a UART. A frame batches up to HV_CONTROL_LINK_MAX_UPDATES updates:
+ *
+ *   0xA5 0x5A | seq | count | count x (index: u16, value: f32) | crc: u16
+ *
+ * Multi-byte fields are little-endian. The CRC is CRC-16/CCITT-FALSE over
+ * seq, count and the updates. An index addresses a receiver by its dense
+ * receiver index, or an input parameter by its hv_getParameterInfo() index
+ * when HV_CONTROL_LINK_PARAMETER is set. seq counts frames, so frames lost
+ * on the way show up even when no corrupted bytes arrive.
+ *
+ * The parser walks the bytes where they are and keeps only the frame being
+ * received. A frame with a bad CRC or count is dropped and the parser hunts for
+ * the next sync from the byte after it.
+ *
+ * There is nothing platform-specific here, so the host side encodes with the
+ * same code.
+ */
+#define HV_CONTROL_LINK_SYNC0 0xA5
+#define HV_CONTROL_LINK_SYNC1 0x5A
+#define HV_CONTROL_LINK_MAX_UPDATES 64
+#define HV_CONTROL_LINK_PARAMETER 0x8000
+#define HV_CONTROL_LINK_UPDATE_BYTES 6
+#define HV_CONTROL_LINK_MAX_FRAME (6 + HV_CONTROL_LINK_MAX_UPDATES * HV_CONTROL_LINK_UPDATE_BYTES)
+
+typedef struct HvControlUpdate {
+  hv_uint16_t index; // receiver index, or parameter index | HV_CONTROL_LINK_PARAMETER
+  float value;
+} HvControlUpdate;
+
+typedef struct HvControlLink {
+  hv_uint8_t frame[HV_CONTROL_LINK_MAX_FRAME - 2]; // seq, count, updates and crc, without the sync
+  hv_uint32_t length;   // bytes of frame received
+  hv_uint32_t expected; // bytes of frame to receive, 0 while hunting for the sync
+  bool sync;            // the first sync byte was seen while hunting
+  bool started;         // a frame has been received, so seq can be checked
+  hv_uint8_t seq;       // of the last good frame
+  hv_uint32_t numFrames;
+  hv_uint32_t numBadFrames;
+  hv_uint32_t numLostFrames;
+} HvControlLink;
+
+void hCl_init(HvControlLink *o);
+
+/**
+ * Parses bytes until they run out or a frame is complete.
+ *
+ * @param numUpdates  Filled with the number of updates of the completed frame,
+ *                    to be read with hCl_getUpdate(), or 0 if none completed.
+ * @return  The number of bytes consumed. Less than numBytes only if a frame
+ *          completed, in which case the rest should be passed again once the
+ *          frame has been read.
+ */
+hv_uint32_t hCl_parse(HvControlLink *o, const hv_uint8_t *bytes, hv_uint32_t numBytes, hv_uint32_t *numUpdates);
+
+/**
+ * Decodes update i of the frame completed by the last hCl_parse() call.
+ */
+HvControlUpdate hCl_getUpdate(const HvControlLink *o, hv_uint32_t i);
+
+/**
+ * Drops any partial frame, e.g. after the input overflowed.
+ */
+void hCl_reset(HvControlLink *o);
+
+/**
+ * Writes a frame of up to HV_CONTROL_LINK_MAX_UPDATES updates into out, which
+ * must have room for HV_CONTROL_LINK_MAX_FRAME bytes.
+ *
+ * @return  The length of the frame in bytes.
+ */
+hv_uint32_t hCl_encode(hv_uint8_t *out, hv_uint8_t seq, const HvControlUpdate *updates, hv_uint32_t numUpdates);
+
+static inline hv_uint32_t hCl_getFrameCount(const HvControlLink *o) {
+  return o->numFrames;
+}
+
+// frames dropped for a bad CRC or count
+static inline hv_uint32_t hCl_getBadFrameCount(const HvControlLink *o) {
+  return o->numBadFrames;
+}
+
+// frames missing from the sequence, the bad ones included
+static inline hv_uint32_t hCl_getLostFrameCount(const HvControlLink *o) {
+  return o->numLostFrames;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_CONTROL_LINK_H_
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvDebounce.h"
+
+hv_uint32_t hDb_init(HvDebounce *o, hv_uint32_t numButtons, hv_uint32_t numEdges, hv_int64_t period) {
+  hv_uint32_t len = 1;
+  while (len < numEdges) len <<= 1;
+  o->ring = (HvDebounceEdge *) hv_malloc(len * sizeof(HvDebounceEdge));
+  hv_assert(o->ring != NULL);
+  o->mask = len - 1;
+  o->head = 0;
+  o->tail = 0;
+  o->dropped = 0;
+  o->buttons = (HvDebounceButton *) hv_malloc((numButtons > 0 ? numButtons : 1) * sizeof(HvDebounceButton));
+  hv_assert(o->buttons != NULL);
+  hv_memclear(o->buttons, (numButtons > 0 ? numButtons : 1) * sizeof(HvDebounceButton));
+  o->numButtons = numButtons;
+  o->period = period;
+  return len;
+}
+
+void hDb_free(HvDebounce *o) {
+  hv_free(o->buttons);
+  hv_free(o->ring);
+}
+
+void hDb_setLevel(HvDebounce *o, hv_uint32_t button, hv_uint32_t level) {
+  hv_assert(button < o->numButtons);
+  HvDebounceButton *b = o->buttons + button;
+  b->level = b->lastLevel = level ? 1 : 0;
+  b->settling = 0;
+}
+
+// ends settling, reporting the level the button settled at if it was not reported yet
+static void hDb_settle(HvDebounceButton *b, hv_uint32_t button, HvDebounceHook_t *hook, void *user) {
+  b->settling = 0;
+  if (b->lastLevel != b->level) {
+    b->level = b->lastLevel;
+    hook(user, button, b->level, b->lastTime);
+  }
+}
+
+hv_int64_t hDb_process(HvDebounce *o, hv_int64_t now, HvDebounceHook_t *hook, void *user) {
+  // acquire pairs with hDb_pushEdge(), so the edges up to head are written
+  const hv_uint32_t head = __atomic_load_n(&o->head, __ATOMIC_ACQUIRE);
+  hv_uint32_t tail = o->tail;
+  for (; tail != head; ++tail) {
+    const HvDebounceEdge *e = o->ring + (tail & o->mask);
+    if (e->button >= o->numButtons) continue;
+    HvDebounceButton *b = o->buttons + e->button;
+    // an edge that arrives after its button's deadline finds it stable again
+    if (b->settling && e->time - b->deadline >= 0) hDb_settle(b, e->button, hook, user);
+    if (b->settling) {
+      b->lastLevel = (hv_uint8_t) e->level;
+      b->lastTime = e->time;
+      b->deadline = e->time + o->period;
+    } else if (e->level != b->level) {
+      b->level = b->lastLevel = (hv_uint8_t) e->level;
+      b->lastTime = e->time;
+      b->deadline = e->time + o->period;
+      b->settling = 1;
+      hook(user, e->button, b->level, e->time);
+    }
+  }
+  // release hands the drained slots back to the producer
+  __atomic_store_n(&o->tail, tail, __ATOMIC_RELEASE);
+
+  hv_int64_t next = HV_DEBOUNCE_IDLE;
+  for (hv_uint32_t i = 0; i < o->numButtons; ++i) {
+    HvDebounceButton *b = o->buttons + i;
+    if (!b->settling) continue;
+    if (now - b->deadline >= 0) {
+      hDb_settle(b, i, hook, user);
+    } else if (next == HV_DEBOUNCE_IDLE || b->deadline < next) {
+      next = b->deadline;
+    }
+  }
+  return next;
+}
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_ENCODER_H_
+#define _HEAVY_ENCODER_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Turns the running count of a quadrature counter into accelerated detent
+ * steps. The counting itself is left to hardware (PCNT on ESP32), so the
+ * CPU only looks at the count when it polls. Between two polls the counts
+ * are converted into whole detents, keeping the remainder for the next poll.
+ * The detent rate, measured from one detent to the next, is smoothed into a
+ * velocity. Above a threshold velocity
+ * each detent counts for more, up to a maximum gain, so a fast turn covers a
+ * long range while a slow one still moves by single steps. Reversing the
+ * direction drops the velocity, so that it starts slow again.
+ *
+ * There is nothing platform-specific here: any counter, such as a simulated
+ * one on a host, can feed hEn_update().
+ */
+typedef struct HvEncoder {
+  hv_int32_t count;     // count at the last update
+  hv_int32_t remainder; // counts since the last whole detent
+  hv_int32_t countsPerDetent;
+  hv_int64_t time;      // time of the last whole detent
+  float velocity;       // smoothed detents per second, signed
+  float threshold;      // detents per second at which acceleration starts
+  float acceleration;   // gain added per detent per second above the threshold
+  float maxGain;
+} HvEncoder;
+
+// time constant of the velocity smoothing, in seconds
+#define HV_ENCODER_SMOOTHING 0.05f
+
+/**
+ * @param count  The current count of the counter.
+ * @param time  The current time, in microseconds.
+ * @param acceleration  Zero turns acceleration off.
+ */
+void hEn_init(HvEncoder *o, hv_int32_t count, hv_int64_t time, hv_int32_t countsPerDetent,
+    float threshold, float acceleration, float maxGain);
+
+/**
+ * Takes a new reading of the counter. The count may wrap around.
+ *
+ * @param time  The time of the reading, in microseconds.
+ * @return  The detents turned since the last update, multiplied by the
+ *          acceleration gain. Negative when turned backwards, 0 if the
+ *          encoder didn't move a whole detent.
+ */
+float hEn_update(HvEncoder *o, hv_int32_t count, hv_int64_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_ENCODER_H_
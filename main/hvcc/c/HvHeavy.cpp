@@ -113,6 +113,10 @@ HV_EXPORT char *hv_msg_toString(const HvMessage *const m) {
   return msg_toString(m);
 }
 
+HV_EXPORT hv_uint32_t hv_msg_toStringBuf(const HvMessage *const m, char *buf, hv_uint32_t len) {
+  return (hv_uint32_t) msg_toStringBuf(m, buf, len);
+}
+
 HV_EXPORT HvMessage *hv_msg_copy(const HvMessage *const m) {
   return msg_copy(m);
 }
@@ -182,16 +186,16 @@ HV_EXPORT bool hv_sendSymbolToReceiver(HeavyContextInterface *c, hv_uint32_t rec
 }
 
 HV_EXPORT bool hv_sendMessageToReceiverV(
-    HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, const char *format, ...) {
+    HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, const char *format, ...) {
   hv_assert(c != nullptr);
-  hv_assert(delayMs >= 0.0);
+  hv_assert(delayMs >= 0.0f);
   hv_assert(format != nullptr);
 
   va_list ap;
   va_start(ap, format);
   const int numElem = (int) hv_strlen(format);
   HvMessage *m = HV_MESSAGE_ON_STACK(numElem);
-  msg_init(m, numElem, c->getCurrentSample() + (hv_uint32_t) (hv_max_d(0.0, delayMs)*c->getSampleRate()/1000.0));
+  msg_init(m, numElem, c->getCurrentSample() + c->millisecondsToSamples(delayMs));
   for (int i = 0; i < numElem; i++) {
     switch (format[i]) {
       case 'b': msg_setBang(m, i); break;
@@ -207,40 +211,82 @@ HV_EXPORT bool hv_sendMessageToReceiverV(
 }
 
 HV_EXPORT bool hv_sendMessageToReceiverFF(
-    HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, double data1, double data2) {
+    HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, float data1, float data2) {
   hv_assert(c != nullptr);
-  hv_assert(delayMs >= 0.0);
+  hv_assert(delayMs >= 0.0f);
 
   const int numElem = (int) 2;
   HvMessage *m = HV_MESSAGE_ON_STACK(numElem);
-  msg_init(m, numElem, c->getCurrentSample() + (hv_uint32_t) (hv_max_d(0.0, delayMs)*c->getSampleRate()/1000.0));
-  msg_setFloat(m, 0, (float) data1);
-  msg_setFloat(m, 1, (float) data2);
+  msg_init(m, numElem, c->getCurrentSample() + c->millisecondsToSamples(delayMs));
+  msg_setFloat(m, 0, data1);
+  msg_setFloat(m, 1, data2);
 
   return c->sendMessageToReceiver(receiverHash, delayMs, m);
 }
 
 HV_EXPORT bool hv_sendMessageToReceiverFFF(
-    HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, double data1, double data2, double data3) {
+    HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, float data1, float data2, float data3) {
   hv_assert(c != nullptr);
-  hv_assert(delayMs >= 0.0);
+  hv_assert(delayMs >= 0.0f);
 
   const int numElem = (int) 3;
   HvMessage *m = HV_MESSAGE_ON_STACK(numElem);
-  msg_init(m, numElem, c->getCurrentSample() + (hv_uint32_t) (hv_max_d(0.0, delayMs)*c->getSampleRate()/1000.0));
-  msg_setFloat(m, 0, (float) data1);
-  msg_setFloat(m, 1, (float) data2);
-  msg_setFloat(m, 2, (float) data3);
+  msg_init(m, numElem, c->getCurrentSample() + c->millisecondsToSamples(delayMs));
+  msg_setFloat(m, 0, data1);
+  msg_setFloat(m, 1, data2);
+  msg_setFloat(m, 2, data3);
 
   return c->sendMessageToReceiver(receiverHash, delayMs, m);
 }
 
 HV_EXPORT bool hv_sendMessageToReceiver(
-    HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, HvMessage *m) {
+    HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, HvMessage *m) {
   hv_assert(c != nullptr);
   return c->sendMessageToReceiver(receiverHash, delayMs, m);
 }
 
+HV_EXPORT bool hv_sendMessageToReceiverIndex(
+    HeavyContextInterface *c, hv_uint32_t receiverIndex, float delayMs, HvMessage *m) {
+  hv_assert(c != nullptr);
+  return c->sendMessageToReceiverIndex(receiverIndex, delayMs, m);
+}
+
+HV_EXPORT bool hv_sendBangToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex) {
+  hv_assert(c != nullptr);
+  return c->sendBangToReceiverIndex(receiverIndex);
+}
+
+HV_EXPORT bool hv_sendFloatToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, float x) {
+  hv_assert(c != nullptr);
+  return c->sendFloatToReceiverIndex(receiverIndex, x);
+}
+
+HV_EXPORT bool hv_sendSymbolToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, char *s) {
+  hv_assert(c != nullptr);
+  return c->sendSymbolToReceiverIndex(receiverIndex, s);
+}
+
+HV_EXPORT int hv_sendBatch(HeavyContextInterface *c, const HvEvent *events, int numEvents) {
+  hv_assert(c != nullptr);
+  return c->sendBatch(events, numEvents);
+}
+
+HV_EXPORT bool hv_sendMessageAtSample(
+    HeavyContextInterface *c, hv_uint32_t receiverHash, hv_uint64_t sample, HvMessage *m) {
+  hv_assert(c != nullptr);
+  return c->sendMessageAtSample(receiverHash, sample, m);
+}
+
+HV_EXPORT void hv_setSampleClock(HeavyContextInterface *c, hv_int64_t timeUs) {
+  hv_assert(c != nullptr);
+  c->setSampleClock(timeUs);
+}
+
+HV_EXPORT hv_uint64_t hv_timeToSample(HeavyContextInterface *c, hv_int64_t timeUs) {
+  hv_assert(c != nullptr);
+  return c->timeToSample(timeUs);
+}
+
 HV_EXPORT void hv_cancelMessage(HeavyContextInterface *c, HvMessage *m, void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *)) {
   hv_assert(c != nullptr);
   c->cancelMessage(m, sendMessage);
@@ -263,7 +309,8 @@ HV_EXPORT void *hv_getUserData(HeavyContextInterface *c) {
 
 HV_EXPORT double hv_getCurrentTime(HeavyContextInterface *c) {
   hv_assert(c != nullptr);
-  return (double) c->samplesToMilliseconds(c->getCurrentSample());
+  // not a hot path; in double the time keeps sub-sample resolution up to the wrap
+  return 1000.0 * (double) c->getCurrentSample() / c->getSampleRate();
 }
 
 HV_EXPORT hv_uint32_t hv_getCurrentSample(HeavyContextInterface *c) {
@@ -286,6 +333,16 @@ HV_EXPORT int hv_getParameterInfo(HeavyContextInterface *c, int index, HvParamet
   return c->getParameterInfo(index, info);
 }
 
+HV_EXPORT bool hv_setParameterValue(HeavyContextInterface *c, int index, float value) {
+  hv_assert(c != nullptr);
+  return c->setParameterValue(index, value);
+}
+
+HV_EXPORT bool hv_setReceiverLatestWins(HeavyContextInterface *c, hv_uint32_t receiverIndex, bool latestWins) {
+  hv_assert(c != nullptr);
+  return c->setReceiverLatestWins(receiverIndex, latestWins);
+}
+
 HV_EXPORT void hv_lock_acquire(HeavyContextInterface *c) {
   hv_assert(c != nullptr);
   c->lockAcquire();
@@ -318,6 +375,41 @@ HV_EXPORT bool hv_getNextSentMessage(HeavyContextInterface *c, hv_uint32_t *dest
   return c->getNextSentMessage(destinationHash, outMsg, msgLength);
 }
 
+HV_EXPORT bool hv_subscribeSend(HeavyContextInterface *c, hv_uint32_t sendHash, HvSendCallback_t *f, void *userData) {
+  hv_assert(c != nullptr);
+  return c->subscribeSend(sendHash, f, userData);
+}
+
+HV_EXPORT int hv_dispatchSentMessages(HeavyContextInterface *c) {
+  hv_assert(c != nullptr);
+  return c->dispatchSentMessages();
+}
+
+HV_EXPORT bool hv_waitForSentMessages(HeavyContextInterface *c, hv_uint32_t timeoutMs) {
+  hv_assert(c != nullptr);
+  return c->waitForSentMessages(timeoutMs);
+}
+
+HV_EXPORT void hv_setPrintQueueSize(HeavyContextInterface *c, hv_uint32_t printQueueKb) {
+  hv_assert(c != nullptr);
+  c->setPrintQueueSize(printQueueKb);
+}
+
+HV_EXPORT int hv_dispatchPrints(HeavyContextInterface *c) {
+  hv_assert(c != nullptr);
+  return c->dispatchPrints();
+}
+
+HV_EXPORT bool hv_waitForPrints(HeavyContextInterface *c, hv_uint32_t timeoutMs) {
+  hv_assert(c != nullptr);
+  return c->waitForPrints(timeoutMs);
+}
+
+HV_EXPORT hv_uint32_t hv_getDroppedPrintCount(HeavyContextInterface *c) {
+  hv_assert(c != nullptr);
+  return c->getDroppedPrintCount();
+}
+
 
 #if HV_APPLE
 #pragma mark - Heavy Common
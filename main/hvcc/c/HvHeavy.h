@@ -53,6 +53,18 @@ typedef struct HvParameterInfo {
 typedef void (HvSendHook_t) (HeavyContextInterface *context, const char *sendName, hv_uint32_t sendHash, const HvMessage *msg);
 typedef void (HvPrintHook_t) (HeavyContextInterface *context, const char *printName, const char *str, const HvMessage *msg);
 
+// Receiver index meaning "address the receiver by its hash instead"
+#define HV_RECEIVER_INDEX_NONE 0xFFFFFFFF
+
+typedef struct HvEvent {
+  hv_uint32_t receiverHash;  // used when receiverIndex is HV_RECEIVER_INDEX_NONE
+  hv_uint32_t receiverIndex; // dense receiver index, e.g. HV_HEAVY_RECEIVER_INDEX_KNOB1
+  const HvMessage *msg;      // copied into the input queue
+  hv_uint64_t sample;        // absolute sample time to process the event at, 0 for the next block
+} HvEvent;
+
+typedef void (HvSendCallback_t) (HeavyContextInterface *context, hv_uint32_t sendHash, const HvMessage *msg, void *userData);
+
 #endif // _HEAVY_DECLARATIONS_
 
 
@@ -187,7 +199,7 @@ bool hv_sendSymbolToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash,
  * @return  True if the message was accepted. False if the message could not fit onto
  *          the message queue to be processed this block.
  */
-bool hv_sendMessageToReceiverV(HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, const char *format, ...);
+bool hv_sendMessageToReceiverV(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, const char *format, ...);
 
 /**
  * Sends a fixed formatted message of two floats to a receiver that can be scheduled for the future.
@@ -197,7 +209,7 @@ bool hv_sendMessageToReceiverV(HeavyContextInterface *c, hv_uint32_t receiverHas
  * @return  True if the message was accepted. False if the message could not fit onto
  *          the message queue to be processed this block.
  */
-bool hv_sendMessageToReceiverFF(HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, double data1, double data2);
+bool hv_sendMessageToReceiverFF(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, float data1, float data2);
 
 /**
  * Sends a fixed formatted message of three floats to a receiver that can be scheduled for the future.
@@ -207,7 +219,7 @@ bool hv_sendMessageToReceiverFF(HeavyContextInterface *c, hv_uint32_t receiverHa
  * @return  True if the message was accepted. False if the message could not fit onto
  *          the message queue to be processed this block.
  */
-bool hv_sendMessageToReceiverFFF(HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, double data1, double data2, double data3);
+bool hv_sendMessageToReceiverFFF(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, float data1, float data2, float data3);
 
 /**
  * Sends a message to a receiver that can be scheduled for the future.
@@ -217,7 +229,80 @@ bool hv_sendMessageToReceiverFFF(HeavyContextInterface *c, hv_uint32_t receiverH
  * @return  True if the message was accepted. False if the message could not fit onto
  *          the message queue to be processed this block.
  */
-bool hv_sendMessageToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, double delayMs, HvMessage *m);
+bool hv_sendMessageToReceiver(HeavyContextInterface *c, hv_uint32_t receiverHash, float delayMs, HvMessage *m);
+
+/**
+ * Sends a message to a receiver addressed by its dense index rather than its hash.
+ * Receiver indices are generated into the patch header, e.g. HV_HEAVY_RECEIVER_INDEX_KNOB1,
+ * and dispatch through a table instead of searching the receiver hashes.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the index is out of range or
+ *          the message could not fit onto the message queue to be processed this block.
+ */
+bool hv_sendMessageToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, float delayMs, HvMessage *m);
+
+/**
+ * A convenience function to send a bang to a receiver addressed by its index.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted.
+ */
+bool hv_sendBangToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex);
+
+/**
+ * A convenience function to send a float to a receiver addressed by its index.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted.
+ */
+bool hv_sendFloatToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, const float x);
+
+/**
+ * A convenience function to send a symbol to a receiver addressed by its index.
+ * This function is thread-safe.
+ *
+ * @return  True if the message was accepted.
+ */
+bool hv_sendSymbolToReceiverIndex(HeavyContextInterface *c, hv_uint32_t receiverIndex, char *s);
+
+/**
+ * Sends several messages, each processed at its event's sample time or at the start of
+ * the next block if that time has passed. Space in the input queue is reserved once and
+ * all accepted events are published together with one fence.
+ * This function is thread-safe.
+ *
+ * @return  The number of leading events that were accepted. Events from that position on
+ *          were not sent, either because the input queue is full or because the event
+ *          names an invalid receiver index.
+ */
+int hv_sendBatch(HeavyContextInterface *c, const HvEvent *events, int numEvents);
+
+/**
+ * Sends a message to be processed at an absolute sample time, e.g. one returned by
+ * hv_timeToSample(). A time that has already passed is processed at the start of the
+ * next block. Internally times wrap every 2^32 samples, so the sample should be within
+ * 2^31 samples (about 12 hours at 48kHz) of the current time. This function is thread-safe.
+ *
+ * @return  True if the message was accepted. False if the message could not fit onto
+ *          the message queue.
+ */
+bool hv_sendMessageAtSample(HeavyContextInterface *c, hv_uint32_t receiverHash, hv_uint64_t sample, HvMessage *m);
+
+/**
+ * Records the host time, in microseconds of any monotonic clock (e.g. esp_timer_get_time()
+ * or CLOCK_MONOTONIC), at which the next block to be processed starts. Call it from the
+ * audio thread before each hv_process*(), at a point paced by the audio hardware.
+ */
+void hv_setSampleClock(HeavyContextInterface *c, hv_int64_t timeUs);
+
+/**
+ * Converts a host time from the clock given to hv_setSampleClock() into an absolute
+ * sample time, so that producers can timestamp events when they are captured.
+ * Returns 0, i.e. the next block, before the first hv_setSampleClock() call.
+ * This function is thread-safe.
+ */
+hv_uint64_t hv_timeToSample(HeavyContextInterface *c, hv_int64_t timeUs);
 
 /**
  * Cancels a previously scheduled message.
@@ -252,6 +337,35 @@ hv_uint32_t hv_getCurrentSample(HeavyContextInterface *c);
  */
 int hv_getParameterInfo(HeavyContextInterface *c, int index, HvParameterInfo *info);
 
+/**
+ * Sets an input parameter, addressed by its hv_getParameterInfo() index, e.g.
+ * HV_HEAVY_PARAM_INDEX_KNOB1. The value is an atomic store, and the first store since the
+ * last delivery queues a marker for it. The latest value is sent to the parameter's
+ * receiver where the marker was queued, so it keeps its order with the messages sent
+ * before and after it, unless the receiver already got the same value from the bank and
+ * no other message since (the first store is always sent). Intermediate values stored
+ * before the marker is reached are not seen by the patch.
+ * This function is thread-safe and lock-free.
+ *
+ * @return  False if the index does not name an input parameter, the value is NaN, or
+ *          the input queue has no room for the marker.
+ */
+bool hv_setParameterValue(HeavyContextInterface *c, int index, float value);
+
+/**
+ * Makes a receiver, addressed by its index, latest-wins: a float sent to it without delay,
+ * while an earlier one is still pending, replaces that float instead of queueing behind it.
+ * The float that found nothing pending holds a place in the input queue, and the latest one
+ * is delivered there, so it keeps its order with the messages sent before and after it.
+ * Bangs, symbols, lists, delayed and batched messages keep going through the input queue
+ * in order. This bounds queue growth for controls that are scanned faster than they matter.
+ * A float still pending when it is switched off is delivered in its place all the same.
+ * This function is thread-safe and lock-free.
+ *
+ * @return  False if the index is out of range.
+ */
+bool hv_setReceiverLatestWins(HeavyContextInterface *c, hv_uint32_t receiverIndex, bool latestWins);
+
 /** */
 float hv_samplesToMilliseconds(HeavyContextInterface *c, hv_uint32_t numSamples);
 
@@ -259,31 +373,24 @@ float hv_samplesToMilliseconds(HeavyContextInterface *c, hv_uint32_t numSamples)
 hv_uint32_t hv_millisecondsToSamples(HeavyContextInterface *c, float ms);
 
 /**
- * Acquire the input message queue lock.
- *
- * This function will block until the message lock as been acquired.
- * Typical applications will not require the use of this function.
+ * Does nothing: the input message queue is lock-free, and there is no lock to
+ * acquire. Kept for compatibility with code written for the stock runtime.
  *
  * @param c  A Heavy context.
  */
 void hv_lock_acquire(HeavyContextInterface *c);
 
 /**
- * Try to acquire the input message queue lock.
- *
- * If the lock has been acquired, hv_lock_release() must be called to release it.
- * Typical applications will not require the use of this function.
+ * Does nothing, see hv_lock_acquire().
  *
  * @param c  A Heavy context.
  *
- * @return Returns true if the lock has been acquired, false otherwise.
+ * @return Always true.
  */
 bool hv_lock_try(HeavyContextInterface *c);
 
 /**
- * Release the input message queue lock.
- *
- * Typical applications will not require the use of this function.
+ * Does nothing, see hv_lock_acquire().
  *
  * @param c  A Heavy context.
  */
@@ -324,6 +431,84 @@ void hv_setOutputMessageQueueSize(HeavyContextInterface *c, hv_uint32_t outQueue
 */
 bool hv_getNextSentMessage(HeavyContextInterface *c, hv_uint32_t *destinationHash, HvMessage *outMsg, hv_uint32_t msgLength);
 
+/**
+ * Registers a callback for messages sent to a send of the patch, e.g.
+ * HV_HEAVY_SEND_METER. Once any callback is registered, the default send hook
+ * drops messages to sends without one instead of queueing them, and
+ * hv_dispatchSentMessages() takes the place of hv_getNextSentMessage().
+ * Requires an outgoing message queue (see hv_<name>_new_with_options()).
+ * Register callbacks before another thread starts dispatching.
+ *
+ * @param c  A Heavy context.
+ * @param sendHash  The hash of a send known to the patch.
+ * @param f  The callback, or NULL to unsubscribe.
+ * @param userData  Passed to the callback.
+ *
+ * @return  False if the patch has no such send or no outgoing message queue.
+ */
+bool hv_subscribeSend(HeavyContextInterface *c, hv_uint32_t sendHash, HvSendCallback_t *f, void *userData);
+
+/**
+ * Calls the registered callbacks for all queued outgoing messages and consumes
+ * them. Call this from a single low-priority thread.
+ *
+ * @param c  A Heavy context.
+ *
+ * @return  The number of callbacks made.
+ */
+int hv_dispatchSentMessages(HeavyContextInterface *c);
+
+/**
+ * Blocks until the patch queues an outgoing message or until the timeout passes.
+ * Only the dispatching thread may wait.
+ *
+ * @param c  A Heavy context.
+ * @param timeoutMs  The longest time to wait, in milliseconds.
+ *
+ * @return  True if messages were queued since the last wait.
+ */
+bool hv_waitForSentMessages(HeavyContextInterface *c, hv_uint32_t timeoutMs);
+
+/**
+ * Defers print objects to a queue of the given size, so that the audio thread
+ * only copies their messages. The print hook is then called by
+ * hv_dispatchPrints() instead of from within processing. Zero turns the queue off.
+ * Call this before processing starts.
+ *
+ * @param c  A Heavy context.
+ * @param printQueueKb  The size of the print queue in kilobytes.
+ */
+void hv_setPrintQueueSize(HeavyContextInterface *c, hv_uint32_t printQueueKb);
+
+/**
+ * Formats the queued print messages and passes them to the print hook.
+ * Call this from a single low-priority thread.
+ *
+ * @param c  A Heavy context.
+ *
+ * @return  The number of messages printed.
+ */
+int hv_dispatchPrints(HeavyContextInterface *c);
+
+/**
+ * Blocks until a print object queues a message or until the timeout passes.
+ * Only the thread calling hv_dispatchPrints() may wait.
+ *
+ * @param c  A Heavy context.
+ * @param timeoutMs  The longest time to wait, in milliseconds.
+ *
+ * @return  True if messages were queued since the last wait.
+ */
+bool hv_waitForPrints(HeavyContextInterface *c, hv_uint32_t timeoutMs);
+
+/**
+ * Returns how many print messages were dropped because the print queue was
+ * full, since the context was created.
+ *
+ * @param c  A Heavy context.
+ */
+hv_uint32_t hv_getDroppedPrintCount(HeavyContextInterface *c);
+
 
 
 #if HV_APPLE
@@ -395,6 +580,14 @@ bool hv_msg_hasFormat(const HvMessage *const m, const char *fmt);
  */
 char *hv_msg_toString(const HvMessage *const m);
 
+/**
+ * Writes a basic string representation of the message into buf, without
+ * allocating. The string is truncated to len-1 characters and null-terminated.
+ *
+ * @return  The length of the untruncated string.
+ */
+hv_uint32_t hv_msg_toStringBuf(const HvMessage *const m, char *buf, hv_uint32_t len);
+
 /** Copy a message onto the stack. The message persists. */
 HvMessage *hv_msg_copy(const HvMessage *const m);
 
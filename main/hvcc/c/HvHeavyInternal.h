@@ -44,6 +44,20 @@ HvMessage *hv_scheduleMessageForObject(HeavyContextInterface *c, const HvMessage
     void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *),
     int letIndex);
 
+/**
+ * Copies a message for a print object into the print queue, if the context
+ * has one. The message is formatted and printed later by hv_dispatchPrints().
+ *
+ * @return  True if printing is deferred, whether or not the message fit.
+ */
+bool hv_queuePrint(HeavyContextInterface *c, const char *name, const HvMessage *m);
+
+/**
+ * Returns 1/sampleRate in single precision, cached when the context is created,
+ * so that objects can convert frequencies without double-precision arithmetic.
+ */
+float hv_getSamplePeriod(HeavyContextInterface *c);
+
 #ifdef __cplusplus
 }
 #endif
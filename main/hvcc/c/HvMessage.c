@@ -42,11 +42,19 @@ HvMessage *msg_initWithBang(HvMessage *m, hv_uint32_t timestamp) {
 HvMessage *msg_initWithSymbol(HvMessage *m, hv_uint32_t timestamp, const char *s) {
   m->timestamp = timestamp;
   m->numElements = 1;
-  m->numBytes = sizeof(HvMessage) + (hv_uint16_t) hv_strlen(s);
+  m->numBytes = sizeof(HvMessage);
   msg_setSymbol(m, 0, s);
   return m;
 }
 
+HvMessage *msg_initWithInternedSymbol(HvMessage *m, hv_uint32_t timestamp, const HvSymbol *s) {
+  m->timestamp = timestamp;
+  m->numElements = 1;
+  m->numBytes = sizeof(HvMessage);
+  msg_setInternedSymbol(m, 0, s);
+  return m;
+}
+
 HvMessage *msg_initWithHash(HvMessage *m, hv_uint32_t timestamp, hv_uint32_t h) {
   m->timestamp = timestamp;
   m->numElements = 1;
@@ -63,25 +71,12 @@ void msg_copyToBuffer(const HvMessage *m, char *buffer, hv_size_t len) {
   // assert that the message is not already larger than the length of the buffer
   hv_assert(len_r <= len);
 
-  // copy the basic message to the buffer
+  // copy the message to the buffer, symbols are interned and only their pointers are copied
   hv_memcpy(r, m, len_r);
 
-  char *p = buffer + len_r; // points to the end of the base message
-  for (int i = 0; i < msg_getNumElements(m); ++i) {
-    if (msg_isSymbol(m,i)) {
-      const hv_size_t symLen = (hv_size_t) hv_strlen(msg_getSymbol(m,i)) + 1; // include the trailing null char
-      hv_assert(len_r + symLen <= len); // stay safe!
-      hv_strncpy(p, msg_getSymbol(m,i), symLen);
-      msg_setSymbol(r, i, p);
-      p += symLen;
-      len_r += symLen;
-    }
-  }
-
   r->numBytes = (hv_uint16_t) len_r; // update the message size in memory
 }
 
-// the message is serialised such that all symbol elements are placed in order at the end of the buffer
 HvMessage *msg_copy(const HvMessage *m) {
   const hv_uint32_t heapSize = msg_getSize(m);
   char *r = (char *) hv_malloc(heapSize);
@@ -111,7 +106,10 @@ bool msg_hasFormat(const HvMessage *m, const char *fmt) {
 
 bool msg_compareSymbol(const HvMessage *m, int i, const char *s) {
   switch (msg_getType(m,i)) {
-    case HV_MSG_SYMBOL: return !hv_strcmp(msg_getSymbol(m, i), s);
+    case HV_MSG_SYMBOL: {
+      const HvSymbol *sym = msg_getInternedSymbol(m,i);
+      return (sym->hash == hv_string_to_hash(s)) && !hv_strcmp(sym->str, s);
+    }
     case HV_MSG_HASH: return (msg_getHash(m,i) == hv_string_to_hash(s));
     default: return false;
   }
@@ -123,7 +121,7 @@ bool msg_equalsElement(const HvMessage *m, int i_m, const HvMessage *n, int i_n)
       switch (msg_getType(m, i_m)) {
         case HV_MSG_BANG: return true;
         case HV_MSG_FLOAT: return (msg_getFloat(m, i_m) == msg_getFloat(n, i_n));
-        case HV_MSG_SYMBOL: return msg_compareSymbol(m, i_m, msg_getSymbol(n, i_n));
+        case HV_MSG_SYMBOL: return msg_getInternedSymbol(m, i_m) == msg_getInternedSymbol(n, i_n);
         case HV_MSG_HASH: return msg_getHash(m,i_m) == msg_getHash(n,i_n);
         default: break;
       }
@@ -136,7 +134,7 @@ void msg_setElementToFrom(HvMessage *n, int i_n, const HvMessage *const m, int i
   switch (msg_getType(m, i_m)) {
     case HV_MSG_BANG: msg_setBang(n, i_n); break;
     case HV_MSG_FLOAT: msg_setFloat(n, i_n, msg_getFloat(m, i_m)); break;
-    case HV_MSG_SYMBOL: msg_setSymbol(n, i_n, msg_getSymbol(m, i_m)); break;
+    case HV_MSG_SYMBOL: msg_setInternedSymbol(n, i_n, msg_getInternedSymbol(m, i_m)); break;
     case HV_MSG_HASH: msg_setHash(n, i_n, msg_getHash(m, i_m));
     default: break;
   }
@@ -151,50 +149,163 @@ hv_uint32_t msg_getHash(const HvMessage *const m, int i) {
       fhash.f = msg_getFloat(m,i);
       return fhash.u;
     }
-    case HV_MSG_SYMBOL: return hv_string_to_hash(msg_getSymbol(m,i));
-    case HV_MSG_HASH: return (&(m->elem)+i)->data.h;
+    case HV_MSG_SYMBOL: return msg_getInternedSymbol(m,i)->hash;
+    case HV_MSG_HASH: return msg_getData(m,i)->h;
     default: return 0;
   }
 }
 
-char *msg_toString(const HvMessage *m) {
-  hv_assert(msg_getNumElements(m) > 0);
-  int *len = (int *) hv_alloca(msg_getNumElements(m)*sizeof(int));
-  int size = 0; // the total length of our final buffer
+// Returns round(v * 2^e * 10^k), rounding half to even like printf. v is kept as
+// wide as possible while scaling, so only exponents far outside the 6 printed
+// digits lose any precision, and none is lost for k between 0 and 9.
+static hv_uint64_t msg_scaleToDigits(hv_uint64_t v, int e, int k) {
+  for (; k > 0; --k) {
+    while (v > 0x1999999999999999ULL) { v >>= 1; ++e; } // room for * 10
+    v *= 10;
+  }
+  for (; k < 0; ++k) {
+    while (v < 0x8000000000000000ULL) { v <<= 1; --e; }
+    v /= 10;
+  }
+  if (e >= 0) return (e < 64 && (v >> (63 - e)) == 0) ? (v << e) : ~(hv_uint64_t) 0;
+  const int s = -e;
+  if (s > 63) return 0;
+  const hv_uint64_t q = v >> s;
+  const hv_uint64_t r = v - (q << s);
+  const hv_uint64_t half = (hv_uint64_t) 1 << (s-1);
+  return q + ((r > half || (r == half && (q & 1))) ? 1 : 0);
+}
 
-  // loop through every element in our list of atoms
-  // first loop figures out how long our buffer should be
+// Writes f like printf("%g") does (6 significant digits) into buf, which must
+// hold 16 characters, and returns the length. Uses integer arithmetic only.
+static int msg_formatFloat(float f, char *buf) {
+  int n = 0;
+  union { float f; hv_uint32_t u; } x = { f };
+  if (x.u >> 31) buf[n++] = '-';
+  x.u &= 0x7FFFFFFF;
+  if (x.u >= 0x7F800000) {
+    hv_memcpy(buf+n, (x.u == 0x7F800000) ? "inf" : "nan", 3);
+    return n+3;
+  }
+  if (x.u == 0) {
+    buf[n++] = '0';
+    return n;
+  }
+
+  // |f| = m * 2^e exactly
+  const hv_uint64_t m = (x.u & 0x7FFFFF) | ((x.u >> 23) ? 0x800000 : 0);
+  const int e = (int) ((x.u >> 23) ? (x.u >> 23) : 1) - 150;
+
+  // estimate the decimal exponent from the binary one (78913/2^18 ~ log10(2)),
+  // then correct it until there are exactly 6 digits
+  int top = 0;
+  while ((m >> (top+1)) != 0) ++top;
+  const int b = (e + top) * 78913;
+  int exp10 = (b >= 0) ? (b >> 18) : -((-b + (1 << 18) - 1) >> 18);
+  hv_uint64_t digits = 0;
+  for (int i = 0; i < 4; ++i) {
+    digits = msg_scaleToDigits(m, e, 5 - exp10);
+    if (digits >= 1000000) ++exp10;
+    else if (digits < 100000) --exp10;
+    else break;
+  }
+
+  char d[6];
+  for (int i = 5; i >= 0; --i) {
+    d[i] = (char) ('0' + (int) (digits % 10));
+    digits /= 10;
+  }
+  int numDigits = 6;
+  while (numDigits > 1 && d[numDigits-1] == '0') --numDigits;
+
+  if (exp10 < -4 || exp10 >= 6) {
+    buf[n++] = d[0];
+    if (numDigits > 1) {
+      buf[n++] = '.';
+      for (int i = 1; i < numDigits; ++i) buf[n++] = d[i];
+    }
+    buf[n++] = 'e';
+    buf[n++] = (exp10 < 0) ? '-' : '+';
+    int ex = (exp10 < 0) ? -exp10 : exp10;
+    if (ex >= 10) {
+      buf[n++] = (char) ('0' + ex/10);
+      ex %= 10;
+    } else {
+      buf[n++] = '0';
+    }
+    buf[n++] = (char) ('0' + ex);
+  } else if (exp10 >= 0) {
+    for (int i = 0; i <= exp10; ++i) buf[n++] = d[i];
+    if (numDigits > exp10+1) {
+      buf[n++] = '.';
+      for (int i = exp10+1; i < numDigits; ++i) buf[n++] = d[i];
+    }
+  } else {
+    buf[n++] = '0';
+    buf[n++] = '.';
+    for (int i = -1; i > exp10; --i) buf[n++] = '0';
+    for (int i = 0; i < numDigits; ++i) buf[n++] = d[i];
+  }
+  return n;
+}
+
+void msg_format(const HvMessage *m, HvMessageWriter_t *writer, void *userData) {
+  char buf[16];
   for (int i = 0; i < msg_getNumElements(m); i++) {
-    // length of our string is each atom plus a space, or \0 on the end
+    if (i > 0) writer(userData, " ", 1);
     switch (msg_getType(m, i)) {
-      case HV_MSG_BANG: len[i] = hv_snprintf(NULL, 0, "%s", "bang") + 1; break;
-      case HV_MSG_FLOAT: len[i] = hv_snprintf(NULL, 0, "%g", msg_getFloat(m, i)) + 1; break;
-      case HV_MSG_SYMBOL: len[i] = hv_snprintf(NULL, 0, "%s", msg_getSymbol(m, i)) + 1; break;
-      case HV_MSG_HASH: len[i] = hv_snprintf(NULL, 0, "0x%" PRIX32, msg_getHash(m, i)) + 1; break;
+      case HV_MSG_BANG: writer(userData, "bang", 4); break;
+      case HV_MSG_FLOAT: writer(userData, buf, (hv_size_t) msg_formatFloat(msg_getFloat(m, i), buf)); break;
+      case HV_MSG_SYMBOL: {
+        const char *s = msg_getSymbol(m, i);
+        writer(userData, s, hv_strlen(s));
+        break;
+      }
+      case HV_MSG_HASH: {
+        static const char hex[] = "0123456789ABCDEF";
+        const hv_uint32_t h = msg_getHash(m, i);
+        int n = 0;
+        buf[n++] = '0';
+        buf[n++] = 'x';
+        int shift = 28;
+        while (shift > 0 && ((h >> shift) & 0xF) == 0) shift -= 4; // like "%X", no leading zeros
+        for (; shift >= 0; shift -= 4) buf[n++] = hex[(h >> shift) & 0xF];
+        writer(userData, buf, (hv_size_t) n);
+        break;
+      }
       default: break;
     }
-    size += len[i];
   }
+}
+
+typedef struct MsgStringBuf {
+  char *buf;
+  hv_size_t len;  // capacity of buf, including the terminator
+  hv_size_t size; // length of the full text so far
+} MsgStringBuf;
+
+static void msg_writeToBuf(void *userData, const char *str, hv_size_t len) {
+  MsgStringBuf *b = (MsgStringBuf *) userData;
+  if (b->size+1 < b->len) {
+    const hv_size_t n = hv_min_ui((hv_uint32_t) len, (hv_uint32_t) (b->len - 1 - b->size));
+    hv_memcpy(b->buf + b->size, str, n);
+  }
+  b->size += len;
+}
 
-  hv_assert(size > 0);
+hv_size_t msg_toStringBuf(const HvMessage *m, char *buf, hv_size_t len) {
+  MsgStringBuf b = { buf, len, 0 };
+  msg_format(m, &msg_writeToBuf, &b);
+  if (len > 0) buf[hv_min_ui((hv_uint32_t) b.size, (hv_uint32_t) (len - 1))] = '\0';
+  return b.size;
+}
 
-  // now we do the piecewise concatenation into our final string
-  // the final buffer we will pass back after concatenating all strings - user should free it
+char *msg_toString(const HvMessage *m) {
+  hv_assert(msg_getNumElements(m) > 0);
+  // the final buffer we will pass back - user should free it
+  const hv_size_t size = msg_toStringBuf(m, NULL, 0) + 1;
   char *finalString = (char *) hv_malloc(size*sizeof(char));
   hv_assert(finalString != NULL);
-  int pos = 0;
-  for (int i = 0; i < msg_getNumElements(m); i++) {
-    // put a string representation of each atom into the final string
-    switch (msg_getType(m, i)) {
-      case HV_MSG_BANG: hv_snprintf(finalString+pos, len[i], "%s", "bang"); break;
-      case HV_MSG_FLOAT: hv_snprintf(finalString+pos, len[i], "%g", msg_getFloat(m, i)); break;
-      case HV_MSG_SYMBOL: hv_snprintf(finalString+pos, len[i], "%s", msg_getSymbol(m, i)); break;
-      case HV_MSG_HASH: hv_snprintf(finalString+pos, len[i], "0x%" PRIX32, msg_getHash(m, i)); break;
-      default: break;
-    }
-    pos += len[i];
-    finalString[pos-1] = 32; // ASCII space
-  }
-  finalString[size-1] = '\0'; // ensure that the string is null terminated
+  msg_toStringBuf(m, finalString, size);
   return finalString;
 }
@@ -18,6 +18,8 @@
 #define _HEAVY_MESSAGE_H_
 
 #include "HvUtils.h"
+#include "HvSymbolTable.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,38 +32,62 @@ typedef enum ElementType {
   HV_MSG_HASH = 3
 } ElementType;
 
+typedef union ElementData {
+  float f; // float
+  const HvSymbol *s; // interned symbol
+  hv_uint32_t h; // hash
+} ElementData;
+
 typedef struct Element {
   ElementType type;
-  union {
-    float f; // float
-    const char *s; // symbol
-    hv_uint32_t h; // hash
-  } data;
+  ElementData data;
 } Element;
 
+/**
+ * Messages are laid out compactly: a packed array of one-byte type tags, padded
+ * to the payload alignment, is followed by the element payloads. The struct
+ * describes a one-element message; larger messages extend past its end.
+ */
 typedef struct HvMessage {
   hv_uint32_t timestamp; // the sample at which this message should be processed
   hv_uint16_t numElements;
-  hv_uint16_t numBytes; // the total number of bytes that this message occupies in memory, including strings
-  Element elem;
+  hv_uint16_t numBytes; // the total number of bytes that this message occupies in memory
+  hv_uint8_t types[sizeof(ElementData)]; // element type tags
+  ElementData data; // element payloads
 } HvMessage;
 
 typedef struct ReceiverMessagePair {
   hv_uint32_t receiverHash;
+  hv_uint32_t receiverIndex; // dense receiver index, or HV_RECEIVER_INDEX_NONE to dispatch by hash
   HvMessage msg;
 } ReceiverMessagePair;
 
 #define HV_MESSAGE_ON_STACK(_x) (HvMessage *) hv_alloca(msg_getCoreSize(_x))
 
-/** Returns the number of bytes that this message consumes in memory, not including strings. */
+/** Returns the number of bytes occupied by the type tags, padded to the payload alignment. */
+static inline hv_size_t msg_getTypesSize(hv_size_t numElements) {
+  return (numElements + sizeof(ElementData) - 1) & ~(sizeof(ElementData) - 1);
+}
+
+/** Returns the number of bytes that this message consumes in memory. Symbols are interned, not stored inline. */
 static inline hv_size_t msg_getCoreSize(hv_size_t numElements) {
   hv_assert(numElements > 0);
-  return sizeof(HvMessage) + ((numElements-1) * sizeof(Element));
+  return offsetof(HvMessage, types) + msg_getTypesSize(numElements) + (numElements * sizeof(ElementData));
+}
+
+/** Returns a pointer to the packed type tags of the message. */
+static inline hv_uint8_t *msg_getTypes(const HvMessage *m) {
+  return (hv_uint8_t *) m + offsetof(HvMessage, types);
+}
+
+/** Returns a pointer to the payload of the indexed element. */
+static inline ElementData *msg_getData(const HvMessage *m, int index) {
+  return ((ElementData *) (msg_getTypes(m) + msg_getTypesSize(m->numElements))) + index;
 }
 
 HvMessage *msg_copy(const HvMessage *m);
 
-/** Copies the message into the given buffer. The buffer must be at least as large as msg_getNumHeapBytes(). */
+/** Copies the message into the given buffer. The buffer must be at least as large as msg_getSize(). */
 void msg_copyToBuffer(const HvMessage *m, char *buffer, hv_size_t len);
 
 void msg_setElementToFrom(HvMessage *n, int indexN, const HvMessage *const m, int indexM);
@@ -77,6 +103,8 @@ HvMessage *msg_initWithBang(HvMessage *m, hv_uint32_t timestamp);
 
 HvMessage *msg_initWithSymbol(HvMessage *m, hv_uint32_t timestamp, const char *s);
 
+HvMessage *msg_initWithInternedSymbol(HvMessage *m, hv_uint32_t timestamp, const HvSymbol *s);
+
 HvMessage *msg_initWithHash(HvMessage *m, hv_uint32_t timestamp, hv_uint32_t h);
 
 static inline hv_uint32_t msg_getTimestamp(const HvMessage *m) {
@@ -87,6 +115,15 @@ static inline void msg_setTimestamp(HvMessage *m, hv_uint32_t timestamp) {
   m->timestamp = timestamp;
 }
 
+/**
+ * Returns true if timestamp a is earlier than timestamp b. Timestamps wrap after 2^32
+ * samples (about 24.8 hours at 48kHz), so they are compared as serial numbers. This
+ * holds as long as the compared times are less than 2^31 samples apart.
+ */
+static inline bool msg_isTimestampBefore(hv_uint32_t a, hv_uint32_t b) {
+  return (hv_int32_t) (a - b) < 0;
+}
+
 static inline int msg_getNumElements(const HvMessage *m) {
   return (int) m->numElements;
 }
@@ -98,13 +135,13 @@ static inline hv_uint32_t msg_getSize(const HvMessage *m) {
 
 static inline ElementType msg_getType(const HvMessage *m, int index) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
-  return (&(m->elem)+index)->type;
+  return (ElementType) msg_getTypes(m)[index];
 }
 
 static inline void msg_setBang(HvMessage *m, int index) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
-  (&(m->elem)+index)->type = HV_MSG_BANG;
-  (&(m->elem)+index)->data.s = NULL;
+  msg_getTypes(m)[index] = HV_MSG_BANG;
+  msg_getData(m, index)->s = NULL;
 }
 
 static inline bool msg_isBang(const HvMessage *m, int index) {
@@ -113,13 +150,13 @@ static inline bool msg_isBang(const HvMessage *m, int index) {
 
 static inline void msg_setFloat(HvMessage *m, int index, float f) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
-  (&(m->elem)+index)->type = HV_MSG_FLOAT;
-  (&(m->elem)+index)->data.f = f;
+  msg_getTypes(m)[index] = HV_MSG_FLOAT;
+  msg_getData(m, index)->f = f;
 }
 
 static inline float msg_getFloat(const HvMessage *const m, int index) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
-  return (&(m->elem)+index)->data.f;
+  return msg_getData(m, index)->f;
 }
 
 static inline bool msg_isFloat(const HvMessage *const m, int index) {
@@ -128,8 +165,8 @@ static inline bool msg_isFloat(const HvMessage *const m, int index) {
 
 static inline void msg_setHash(HvMessage *m, int index, hv_uint32_t h) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
-  (&(m->elem)+index)->type = HV_MSG_HASH;
-  (&(m->elem)+index)->data.h = h;
+  msg_getTypes(m)[index] = HV_MSG_HASH;
+  msg_getData(m, index)->h = h;
 }
 
 static inline bool msg_isHash(const HvMessage *m, int index) {
@@ -144,32 +181,90 @@ static inline bool msg_isHashLike(const HvMessage *m, int index) {
 /** Returns a 32-bit hash of the given element. */
 hv_uint32_t msg_getHash(const HvMessage *const m, int i);
 
-static inline void msg_setSymbol(HvMessage *m, int index, const char *s) {
+static inline void msg_setInternedSymbol(HvMessage *m, int index, const HvSymbol *s) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
   hv_assert(s != NULL);
-  (&(m->elem)+index)->type = HV_MSG_SYMBOL;
-  (&(m->elem)+index)->data.s = s;
-  // NOTE(mhroth): if the same message container is reused and string reset,
-  // then the message size will be overcounted
-  m->numBytes += (hv_uint16_t) (hv_strlen(s) + 1); // also count '\0'
+  msg_getTypes(m)[index] = HV_MSG_SYMBOL;
+  msg_getData(m, index)->s = s;
 }
 
-static inline const char *msg_getSymbol(const HvMessage *m, int index) {
+/**
+ * Interns s, which costs a hash and a table lookup, and copies strings never seen
+ * before to the heap. Meant for strings only known at runtime, off the audio
+ * thread; the generator turns literals into msg_setInternedSymbol() calls with
+ * entries of hv_staticSymbols.
+ */
+static inline void msg_setSymbol(HvMessage *m, int index, const char *s) {
+  msg_setInternedSymbol(m, index, hSym_intern(s));
+}
+
+static inline const HvSymbol *msg_getInternedSymbol(const HvMessage *m, int index) {
   hv_assert(index < msg_getNumElements(m)); // invalid index
-  return (&(m->elem)+index)->data.s;
+  return msg_getData(m, index)->s;
+}
+
+static inline const char *msg_getSymbol(const HvMessage *m, int index) {
+  return msg_getInternedSymbol(m, index)->str;
 }
 
 static inline bool msg_isSymbol(const HvMessage *m, int index) {
   return (index < msg_getNumElements(m)) ? (msg_getType(m, index) == HV_MSG_SYMBOL) : false;
 }
 
+/**
+ * Returns true if the element is a symbol equal to s, or a hash of s. Equal
+ * hashes of symbols are confirmed by comparing the strings; a hash element has
+ * no string left to compare.
+ */
 bool msg_compareSymbol(const HvMessage *m, int i, const char *s);
 
+/** As msg_compareSymbol(), for an interned s. Symbols are compared by pointer. */
+static inline bool msg_compareInternedSymbol(const HvMessage *m, int i, const HvSymbol *s) {
+  if (i >= msg_getNumElements(m)) return false;
+  switch (msg_getType(m,i)) {
+    case HV_MSG_SYMBOL: return (msg_getInternedSymbol(m,i) == s);
+    case HV_MSG_HASH: return (msg_getData(m,i)->h == s->hash);
+    default: return false;
+  }
+}
+
+/** Returns true if the element is a symbol or hash matching the given string hash. */
+static inline bool msg_compareSymbolHash(const HvMessage *m, int i, hv_uint32_t h) {
+  if (i >= msg_getNumElements(m)) return false;
+  switch (msg_getType(m,i)) {
+    case HV_MSG_SYMBOL: return (msg_getInternedSymbol(m,i)->hash == h);
+    case HV_MSG_HASH: return (msg_getData(m,i)->h == h);
+    default: return false;
+  }
+}
+
 /** Returns 1 if the element i_m of message m is equal to element i_n of message n. */
 bool msg_equalsElement(const HvMessage *m, int i_m, const HvMessage *n, int i_n);
 
 bool msg_hasFormat(const HvMessage *m, const char *fmt);
 
+// size of the buffer that print objects format their message into
+#ifndef HV_PRINT_STRING_SIZE
+#define HV_PRINT_STRING_SIZE 256
+#endif
+
+/** Receives consecutive pieces of a message's text, which are not null-terminated. */
+typedef void (HvMessageWriter_t)(void *userData, const char *str, hv_size_t len);
+
+/**
+ * Streams the text of the message to a writer, in pieces, without allocating.
+ * Elements are separated by spaces. Floats are formatted like "%g".
+ */
+void msg_format(const HvMessage *msg, HvMessageWriter_t *writer, void *userData);
+
+/**
+ * Writes the text of the message into buf, truncated to len-1 characters and
+ * null-terminated if len is positive.
+ *
+ * @return  The length of the full text, like snprintf().
+ */
+hv_size_t msg_toStringBuf(const HvMessage *msg, char *buf, hv_size_t len);
+
 /**
  * Create a string representation of the message. Suitable for use by the print object.
  * The resulting string must be freed by the caller.
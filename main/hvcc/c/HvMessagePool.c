@@ -20,6 +20,9 @@
 // the number of bytes reserved at a time from the pool
 #define MP_BLOCK_SIZE_BYTES 512
 
+// the smallest chunk size, as a power of two. A one-element message fits in 16 bytes on 32-bit targets.
+#define MP_MIN_CHUNK_LOG2 4
+
 #if HV_APPLE
 #pragma mark - MessageList
 #endif
@@ -78,7 +81,7 @@ static void ml_free(HvMessagePoolList *ml) {
 #endif
 
 static hv_size_t mp_messagelistIndexForSize(hv_size_t byteSize) {
-  return (hv_size_t) hv_max_i((hv_min_max_log2((hv_uint32_t) byteSize) - 5), 0);
+  return (hv_size_t) hv_max_i((hv_min_max_log2((hv_uint32_t) byteSize) - MP_MIN_CHUNK_LOG2), 0);
 }
 
 hv_size_t mp_init(HvMessagePool *mp, hv_size_t numKB) {
@@ -107,7 +110,7 @@ void mp_freeMessage(HvMessagePool *mp, HvMessage *m) {
   const hv_size_t b = msg_getSize(m); // the number of bytes that a message occupies in memory
   const hv_size_t i = mp_messagelistIndexForSize(b); // the HvMessagePoolList index in the pool
   HvMessagePoolList *ml = &mp->lists[i];
-  const hv_size_t chunkSize = 32 << i;
+  const hv_size_t chunkSize = 1 << (MP_MIN_CHUNK_LOG2 + i);
   hv_memclear(m, chunkSize); // clear the chunk, just in case
   ml_push(ml, m);
 }
@@ -115,12 +118,12 @@ void mp_freeMessage(HvMessagePool *mp, HvMessage *m) {
 HvMessage *mp_addMessage(HvMessagePool *mp, const HvMessage *m) {
   const hv_size_t b = msg_getSize(m);
   // determine the message list index to allocate data from based on the msg size
-  // smallest chunk size is 32 bytes
+  // smallest chunk size is 16 bytes
   const hv_size_t i = mp_messagelistIndexForSize(b);
 
-  hv_assert(i < MP_NUM_MESSAGE_LISTS); // how many chunk sizes do we want to support? 32, 64, 128, 256 at the moment
+  hv_assert(i < MP_NUM_MESSAGE_LISTS); // how many chunk sizes do we want to support? 16, 32, 64, 128, 256 at the moment
   HvMessagePoolList *ml = &mp->lists[i];
-  const hv_size_t chunkSize = 32 << i;
+  const hv_size_t chunkSize = 1 << (MP_MIN_CHUNK_LOG2 + i);
 
   if (ml_hasAvailable(ml)) {
     char *buf = ml_pop(ml);
@@ -22,7 +22,7 @@
 #ifdef HV_MP_NUM_MESSAGE_LISTS
 #define MP_NUM_MESSAGE_LISTS HV_MP_NUM_MESSAGE_LISTS
 #else // HV_MP_NUM_MESSAGE_LISTS
-#define MP_NUM_MESSAGE_LISTS 4
+#define MP_NUM_MESSAGE_LISTS 5
 #endif // HV_MP_NUM_MESSAGE_LISTS
 
 #ifdef __cplusplus
@@ -45,9 +45,9 @@ typedef struct HvMessagePool {
 /**
  * The HvMessagePool is a basic memory management system. It reserves a large block of memory at initialisation
  * and proceeds to divide this block into smaller chunks (usually 512 bytes) as they are needed. These chunks are
- * further divided into 32, 64, 128, or 256 sections. Each of these sections is managed by a HvMessagePoolList (MPL).
+ * further divided into 16, 32, 64, 128, or 256 sections. Each of these sections is managed by a HvMessagePoolList (MPL).
  * An MPL is a linked-list data structure which is initialised such that its own pool of listnodes is filled with nodes
- * that point at each subblock (e.g. each 32-byte block of a 512-block chunk).
+ * that point at each subblock (e.g. each 16-byte block of a 512-block chunk).
  *
  * HvMessagePool is loosely inspired by TCMalloc. http://goog-perftools.sourceforge.net/doc/tcmalloc.html
  */
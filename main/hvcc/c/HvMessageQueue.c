@@ -87,13 +87,14 @@ HvMessage *mq_addMessageByTimestamp(HvMessageQueue *q, const HvMessage *m, int l
     n->let = let;
     n->sendMessage = sendMessage;
 
-    if (msg_getTimestamp(m) < msg_getTimestamp(q->head->m)) {
+    const hv_uint32_t t = msg_getTimestamp(m);
+    if (msg_isTimestampBefore(t, msg_getTimestamp(q->head->m))) {
       // the message occurs before the current head
       n->next = q->head;
       q->head->prev = n;
       n->prev = NULL;
       q->head = n;
-    } else if (msg_getTimestamp(m) >= msg_getTimestamp(q->tail->m)) {
+    } else if (!msg_isTimestampBefore(t, msg_getTimestamp(q->tail->m))) {
       // the message occurs after the current tail
       n->next = NULL;
       n->prev = q->tail;
@@ -103,7 +104,7 @@ HvMessage *mq_addMessageByTimestamp(HvMessageQueue *q, const HvMessage *m, int l
       // the message occurs somewhere between the head and tail
       MessageNode *node = q->head;
       while (node != NULL) {
-        if (msg_getTimestamp(m) < msg_getTimestamp(node->next->m)) {
+        if (msg_isTimestampBefore(t, msg_getTimestamp(node->next->m))) {
           MessageNode *r = node->next;
           node->next = n;
           n->next = r;
@@ -191,7 +192,7 @@ void mq_clear(HvMessageQueue *q) {
 
 void mq_clearAfter(HvMessageQueue *q, const hv_uint32_t timestamp) {
   MessageNode *n = q->tail;
-  while (n != NULL && timestamp <= msg_getTimestamp(n->m)) {
+  while (n != NULL && !msg_isTimestampBefore(msg_getTimestamp(n->m), timestamp)) {
     // free the node's message
     mp_freeMessage(&q->mp, n->m);
     n->m = NULL;
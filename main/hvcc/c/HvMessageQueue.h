@@ -64,9 +64,9 @@ static inline bool mq_hasMessage(HvMessageQueue *q) {
   return (q->head != NULL);
 }
 
-// true if there is a message and it occurs before (<) timestamp
+// true if there is a message and it occurs before (<) timestamp, in wrapping sample time
 static inline bool mq_hasMessageBefore(HvMessageQueue *const q, const hv_uint32_t timestamp) {
-  return mq_hasMessage(q) && (msg_getTimestamp(mq_node_getMessage(q->head)) < timestamp);
+  return mq_hasMessage(q) && msg_isTimestampBefore(msg_getTimestamp(mq_node_getMessage(q->head)), timestamp);
 }
 
 static inline MessageNode *mq_peek(HvMessageQueue *q) {
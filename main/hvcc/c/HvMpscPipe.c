@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "HvMpscPipe.h"
+
+// the header holds the size of the record including itself, zero while unpublished
+#define HMP_PAD 0x1 // marks the skipped bytes at the end of the ring
+#define HMP_HEADER_AT(q, x) ((hv_uint32_t *) ((q)->buffer + ((x) & (q)->mask)))
+
+hv_uint32_t hMp_init(HvMpscPipe *q, hv_uint32_t numBytes) {
+  hv_uint32_t len = 0;
+  if (numBytes > 0) {
+    len = HMP_HEADER_SIZE;
+    while (len < numBytes) len <<= 1;
+    // the consumer relies on unpublished headers reading as zero
+    q->buffer = (char *) hv_malloc(len);
+    hv_assert(q->buffer != NULL);
+    hv_memclear(q->buffer, len);
+  } else {
+    q->buffer = NULL; // writes always fail and reads find nothing
+  }
+  q->mask = (len > 0) ? (len - 1) : 0;
+  q->head = 0;
+  q->tail = 0;
+  return len;
+}
+
+void hMp_free(HvMpscPipe *q) {
+  hv_free(q->buffer);
+}
+
+char *hMp_getWriteBuffer(HvMpscPipe *q, hv_uint32_t totalBytes) {
+  const hv_uint32_t len = q->mask + 1;
+  if (q->buffer == NULL || totalBytes > len) return NULL;
+
+  hv_uint32_t head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+  hv_uint32_t pad, start;
+  do {
+    // acquire pairs with hMp_consume(), so the freed bytes read as zero before we write them
+    const hv_uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    const hv_uint32_t offset = head & q->mask;
+    // a region never wraps, skip to the start of the ring if it doesn't fit
+    pad = (offset + totalBytes > len) ? (len - offset) : 0;
+    if ((head - tail) + pad + totalBytes > len) return NULL;
+    start = head + pad;
+  } while (!__atomic_compare_exchange_n(&q->head, &head, start + totalBytes,
+      true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  if (pad > 0) __atomic_store_n(HMP_HEADER_AT(q, head), pad | HMP_PAD, __ATOMIC_RELEASE);
+  return (char *) HMP_HEADER_AT(q, start) + HMP_HEADER_SIZE;
+}
+
+char *hMp_getNextBatchBuffer(char *buffer, hv_uint32_t numBytes, hv_uint32_t nextBytes) {
+  // the consumer cannot get here before the head of the batch is published
+  char *const header = buffer - HMP_HEADER_SIZE + hMp_getRecordSize(numBytes);
+  __atomic_store_n((hv_uint32_t *) header, hMp_getRecordSize(nextBytes), __ATOMIC_RELAXED);
+  return header + HMP_HEADER_SIZE;
+}
+
+void hMp_produce(HvMpscPipe *q, char *buffer, hv_uint32_t numBytes) {
+  hv_assert(buffer > q->buffer && buffer < q->buffer + q->mask + 1);
+  // release makes the record, and the rest of its batch, visible with the header
+  __atomic_store_n((hv_uint32_t *) (buffer - HMP_HEADER_SIZE), hMp_getRecordSize(numBytes), __ATOMIC_RELEASE);
+}
+
+char *hMp_getReadBuffer(HvMpscPipe *q, hv_uint32_t *numBytes) {
+  if (q->buffer == NULL) return NULL;
+  hv_uint32_t tail = q->tail; // only the consumer writes the tail
+  while (true) {
+    hv_uint32_t *const header = HMP_HEADER_AT(q, tail);
+    const hv_uint32_t x = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+    if (x == 0) return NULL;
+    if (!(x & HMP_PAD)) {
+      *numBytes = x - HMP_HEADER_SIZE;
+      return (char *) header + HMP_HEADER_SIZE;
+    }
+    hv_memclear(header, x & ~HMP_PAD);
+    tail += x & ~HMP_PAD;
+    __atomic_store_n(&q->tail, tail, __ATOMIC_RELEASE);
+  }
+}
+
+void hMp_consume(HvMpscPipe *q) {
+  const hv_uint32_t tail = q->tail;
+  hv_uint32_t *const header = HMP_HEADER_AT(q, tail);
+  const hv_uint32_t x = *header;
+  hv_assert(x != 0 && !(x & HMP_PAD));
+  // clear the whole record, any of its bytes may hold a later header
+  hv_memclear(header, x);
+  __atomic_store_n(&q->tail, tail + x, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_OSC_PARSER_H_
+#define _HEAVY_OSC_PARSER_H_
+
+#include "HvMessage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * An OSC 1.0 packet parser. It walks a packet where it is, e.g. in the buffer a
+ * UDP datagram was received into, and reports each message with pointers into
+ * the packet. Bundles may nest up to HV_OSC_MAX_DEPTH deep; their messages carry
+ * the timetag of the innermost bundle.
+ *
+ * There is nothing platform-specific here, so it can be fed over the loopback
+ * interface on a host.
+ */
+#define HV_OSC_IMMEDIATELY 1ULL // the timetag meaning "now"
+#define HV_OSC_MAX_DEPTH 4
+#define HV_OSC_MAX_ARGS 8       // longest message hOs_toMessage() writes
+
+typedef struct HvOscMessage {
+  const char *address;    // NUL-terminated, inside the packet
+  const char *types;      // type tags after the ',', NUL-terminated, empty if the packet has none
+  const hv_uint8_t *args; // big-endian argument data
+  hv_uint32_t argsSize;
+  hv_uint64_t timetag;    // NTP format, HV_OSC_IMMEDIATELY outside bundles
+} HvOscMessage;
+
+typedef union HvOscMessageStorage {
+  HvMessage msg;
+  hv_uint8_t bytes[offsetof(HvMessage, types) + HV_OSC_MAX_ARGS + HV_OSC_MAX_ARGS * sizeof(ElementData)];
+} HvOscMessageStorage;
+
+typedef void (HvOscHook)(void *user, const HvOscMessage *m);
+
+/**
+ * Calls hook for each message of the packet, in order.
+ *
+ * @return  False if the packet is malformed. The messages before the fault have
+ *          been reported.
+ */
+bool hOs_parse(const hv_uint8_t *packet, hv_uint32_t size, HvOscHook *hook, void *user);
+
+/**
+ * Writes the Heavy message for the arguments of an OSC message. Numbers
+ * (i, f, d, h, c) become floats, T and F become 1 and 0, and N and I are
+ * skipped. Strings (s, S) become symbols, but only ones the patch already knows,
+ * since interning strings from the network would grow the heap without bound.
+ * No arguments make a bang.
+ *
+ * @return  False if the message has an argument that can't be represented, more
+ *          than HV_OSC_MAX_ARGS arguments, or is malformed.
+ */
+bool hOs_toMessage(const HvOscMessage *m, HvOscMessageStorage *s);
+
+/**
+ * Converts an NTP timetag into microseconds since the Unix epoch.
+ */
+static inline hv_int64_t hOs_timetagToUs(hv_uint64_t timetag) {
+  const hv_int64_t seconds = (hv_int64_t) (timetag >> 32) - 2208988800LL; // 1900 to 1970
+  return seconds * 1000000 + (hv_int64_t) (((timetag & 0xFFFFFFFFULL) * 1000000) >> 32);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _HEAVY_OSC_PARSER_H_
@@ -16,7 +16,7 @@
 
 #include "HvSignalPhasor.h"
 
-#define HV_PHASOR_2_32 4294967296.0
+#define HV_PHASOR_2_32 4294967296.0f
 
 #if HV_SIMD_AVX
 static void sPhasor_updatePhase(SignalPhasor *o, float p) {
@@ -57,22 +57,23 @@ static void sPhasor_k_updatePhase(SignalPhasor *o, hv_uint32_t p) {
 #endif
 }
 
-static void sPhasor_k_updateFrequency(SignalPhasor *o, float f, double r) {
+// t is the sample period, so that frequency updates stay in single precision
+static void sPhasor_k_updateFrequency(SignalPhasor *o, float f, float t) {
 #if HV_SIMD_AVX
-  o->step.f2sc = (float) (f/r);
-  o->inc = _mm256_set1_ps((float) (8.0f*f/r));
+  o->step.f2sc = f*t;
+  o->inc = _mm256_set1_ps(8.0f*f*t);
   sPhasor_k_updatePhase(o, o->phase[0]);
 #elif HV_SIMD_SSE
-  o->step.s = (hv_int32_t) (f*(HV_PHASOR_2_32/r));
+  o->step.s = (hv_int32_t) (f*(HV_PHASOR_2_32*t));
   o->inc = _mm_set1_epi32(4*o->step.s);
   const hv_uint32_t *const p = (hv_uint32_t *) &o->phase;
   sPhasor_k_updatePhase(o, p[0]);
 #elif HV_SIMD_NEON
-  o->step.s = (hv_int32_t) (f*(HV_PHASOR_2_32/r));
+  o->step.s = (hv_int32_t) (f*(HV_PHASOR_2_32*t));
   o->inc = vdupq_n_s32(4*o->step.s);
   sPhasor_k_updatePhase(o, vgetq_lane_u32(o->phase, 0));
 #else // HV_SIMD_NONE
-  o->step.s = (hv_int32_t) (f*(HV_PHASOR_2_32/r));
+  o->step.s = (hv_int32_t) (f*(HV_PHASOR_2_32*t));
   o->inc = o->step.s;
   // no need to update phase
 #endif
@@ -116,14 +117,14 @@ void sPhasor_onMessage(HeavyContextInterface *_c, SignalPhasor *o, int letIn, co
 
 hv_size_t sPhasor_k_init(SignalPhasor *o, float frequency, double samplerate) {
   __hv_zero_i((hv_bOuti_t) &o->phase);
-  sPhasor_k_updateFrequency(o, frequency, samplerate);
+  sPhasor_k_updateFrequency(o, frequency, (float) (1.0/samplerate));
   return 0;
 }
 
 void sPhasor_k_onMessage(HeavyContextInterface *_c, SignalPhasor *o, int letIn, const HvMessage *m) {
   if (msg_isFloat(m,0)) {
     switch (letIn) {
-      case 0: sPhasor_k_updateFrequency(o, msg_getFloat(m,0), hv_getSampleRate(_c)); break;
+      case 0: sPhasor_k_updateFrequency(o, msg_getFloat(m,0), hv_getSamplePeriod(_c)); break;
       case 1: {
         float p = msg_getFloat(m,0);
         while (p < 0.0f) p += 1.0f; // wrap phase to [0,1]
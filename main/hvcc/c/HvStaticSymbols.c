@@ -0,0 +1,10 @@
+// Generated by c2espidf: symbols interned at generation time, sorted by hash.
+
+#include "HvSymbolTable.h"
+
+const HvSymbol hv_staticSymbols[] = {
+  { 0xD006A44E, "bang" },
+  { 0xE270CAB2, "float" },
+};
+
+const int hv_numStaticSymbols = (int) (sizeof(hv_staticSymbols) / sizeof(hv_staticSymbols[0]));
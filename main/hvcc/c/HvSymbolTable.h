@@ -0,0 +1,57 @@
+/**
+ * Copyright (c) 2014-2018 Enzien Audio Ltd.
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEAVY_SYMBOL_TABLE_H_
+#define _HEAVY_SYMBOL_TABLE_H_
+
+#include "HvUtils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An interned symbol. Every distinct string is represented by exactly one
+ * HvSymbol for the lifetime of the program, so symbol elements can be copied by
+ * pointer and compared by their precomputed hash.
+ */
+typedef struct HvSymbol {
+  hv_uint32_t hash; // hv_string_to_hash(str)
+  const char *str;
+} HvSymbol;
+
+/**
+ * The symbols known at generation time, sorted by ascending hash. Defined by the
+ * generated HvStaticSymbols.c, typically placed in flash.
+ */
+extern const HvSymbol hv_staticSymbols[];
+extern const int hv_numStaticSymbols;
+
+/**
+ * Returns the interned symbol for the given string. Strings known at generation
+ * time resolve to the static table. Any other string is copied to the heap the
+ * first time it is seen. Safe to call from several threads.
+ */
+const HvSymbol *hSym_intern(const char *str);
+
+/** Returns the interned symbol with the given hash, or NULL if none has been interned. */
+const HvSymbol *hSym_find(hv_uint32_t hash);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _HEAVY_SYMBOL_TABLE_H_
@@ -17,6 +17,9 @@
 #include "HvTable.h"
 #include "HvMessage.h"
 
+#define HV_TABLE_HASH_RESIZE 0x190B711F // resize
+#define HV_TABLE_HASH_MIRROR 0x78F019F0 // mirror
+
 hv_size_t hTable_init(HvTable *o, int length) {
   o->length = length;
   // true size of the table is always an integer multple of HV_N_SIMD
@@ -95,7 +98,7 @@ int hTable_resize(HvTable *o, hv_uint32_t newLength) {
 
 void hTable_onMessage(HeavyContextInterface *_c, HvTable *o, int letIn, const HvMessage *m,
     void (*sendMessage)(HeavyContextInterface *, int, const HvMessage *)) {
-  if (msg_compareSymbol(m,0,"resize") && msg_isFloat(m,1) && msg_getFloat(m,1) >= 0.0f) {
+  if (msg_compareSymbolHash(m,0,HV_TABLE_HASH_RESIZE) && msg_isFloat(m,1) && msg_getFloat(m,1) >= 0.0f) {
     hTable_resize(o, (int) hv_ceil_f(msg_getFloat(m,1))); // apply ceil to ensure that tables always have enough space
 
     // send out the new size of the table
@@ -104,7 +107,7 @@ void hTable_onMessage(HeavyContextInterface *_c, HvTable *o, int letIn, const Hv
     sendMessage(_c, 0, n);
   }
 
-  else if (msg_compareSymbol(m,0,"mirror")) {
+  else if (msg_compareSymbolHash(m,0,HV_TABLE_HASH_MIRROR)) {
     hv_memcpy(o->buffer+o->size, o->buffer, HV_N_SIMD*sizeof(float));
   }
 }
@@ -50,6 +50,7 @@
 #define hv_uint16_t uint16_t
 #define hv_int32_t int32_t
 #define hv_uint32_t uint32_t
+#define hv_int64_t int64_t
 #define hv_uint64_t uint64_t
 #define hv_size_t size_t
 #define hv_uintptr_t uintptr_t
@@ -220,6 +221,35 @@ extern "C" {
   hv_uint32_t hv_string_to_hash(const char *str);
 #ifdef __cplusplus
 }
+
+// Compile-time version of hv_string_to_hash(), usable in case labels and static_assert.
+// Written as single-return recursion so that it remains a C++11 constant expression.
+static constexpr hv_uint32_t __hv_utils_strlen_c(const char *s) {
+  return (*s == '\0') ? 0 : 1 + __hv_utils_strlen_c(s + 1);
+}
+static constexpr hv_uint32_t __hv_utils_block_c(const char *s) {
+  return (hv_uint32_t) (unsigned char) s[0] | ((hv_uint32_t) (unsigned char) s[1] << 8) |
+      ((hv_uint32_t) (unsigned char) s[2] << 16) | ((hv_uint32_t) (unsigned char) s[3] << 24);
+}
+static constexpr hv_uint32_t __hv_utils_mix_c(hv_uint32_t k) {
+  return ((k * 0x5bd1e995u) ^ ((k * 0x5bd1e995u) >> 24)) * 0x5bd1e995u;
+}
+static constexpr hv_uint32_t __hv_utils_tail_c(const char *s, hv_uint32_t len, hv_uint32_t x) {
+  return (len == 3) ? (x ^ ((hv_uint32_t) s[2] << 16) ^ ((hv_uint32_t) s[1] << 8) ^ (hv_uint32_t) s[0]) * 0x5bd1e995u
+      : (len == 2) ? (x ^ ((hv_uint32_t) s[1] << 8) ^ (hv_uint32_t) s[0]) * 0x5bd1e995u
+      : (len == 1) ? (x ^ (hv_uint32_t) s[0]) * 0x5bd1e995u
+      : x;
+}
+static constexpr hv_uint32_t __hv_utils_body_c(const char *s, hv_uint32_t len, hv_uint32_t x) {
+  return (len >= 4) ? __hv_utils_body_c(s + 4, len - 4, (x * 0x5bd1e995u) ^ __hv_utils_mix_c(__hv_utils_block_c(s)))
+      : __hv_utils_tail_c(s, len, x);
+}
+static constexpr hv_uint32_t __hv_utils_final_c(hv_uint32_t x) {
+  return ((x ^ (x >> 13)) * 0x5bd1e995u) ^ (((x ^ (x >> 13)) * 0x5bd1e995u) >> 15);
+}
+static constexpr hv_uint32_t hv_string_to_hash_constexpr(const char *str) {
+  return (str == nullptr) ? 0 : __hv_utils_final_c(__hv_utils_body_c(str, __hv_utils_strlen_c(str), __hv_utils_strlen_c(str)));
+}
 #endif
 
 // Math
@@ -5,135 +5,812 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <inttypes.h>
 #include <math.h>
+#include <string.h>
+#include <sys/time.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 //#include "esp_chip_info.h"
 //#include "esp_flash.h"
 //#include "esp_system.h"
-// I2S (STD) TX for audio @ 48kHz
+// I2S (STD, or TDM for more than two channels) for audio @ 48kHz
 #include "driver/i2s_std.h"
+#include "soc/soc_caps.h"
+#if SOC_I2S_SUPPORTS_TDM
+#include "driver/i2s_tdm.h"
+#endif
 #include "driver/gpio.h"
-#include "esp_adc/adc_oneshot.h"
+#include "driver/pulse_cnt.h"
+#include "driver/uart.h"
+#include "esp_adc/adc_continuous.h"
 // Heavy (hvcc) generated patch interface
 #include "hvcc/c/Heavy_heavy.h"
 #include "hvcc/c/HvHeavy.h"
+#include "hvcc/c/HvMessage.h"
+#include "hvcc/c/HvDebounce.h"
+#include "hvcc/c/HvKnobFilter.h"
+#include "hvcc/c/HvEncoder.h"
+#include "hvcc/c/HvMidiParser.h"
+#include "hvcc/c/HvControlLink.h"
+#include "hvcc/c/HvOscParser.h"
+#include "hvcc/c/HvMeter.h"
+#include "hvcc/c/HvAudioIo.h"
+// Buttons, knobs and encoders of the board, generated from the patch and a board file
+#include "control_map.h"
+#if CONTROL_OSC
+// WiFi, SNTP and UDP sockets, only for the OSC input
+#include "esp_wifi.h"
+#include "esp_netif_sntp.h"
+#include "nvs_flash.h"
+#include "lwip/sockets.h"
+#endif
 
-//  configure I2S TX for 48kHz stereo on specific pins.
-static i2s_chan_handle_t init_i2s_tx(uint32_t sample_rate, gpio_num_t ws, gpio_num_t bclk, gpio_num_t dout) {
+#define AUDIO_BLOCK_FRAMES 256 // HVCC likes multiples of 8
+// Patches with up to two outputs play in stereo. More take 4 or 8 TDM slots on
+// chips with TDM; the original ESP32 has none and plays the first two.
+#define AUDIO_MAX_SLOTS 8
+// bytes a DMA buffer can hold
+#define I2S_DMA_BUFFER_MAX 4092
+
+//  configure I2S for 48kHz on specific pins, in stereo or num_slots TDM slots:
+//  TX only, or full duplex with RX on the same controller when rx is given.
+static i2s_chan_handle_t init_i2s(uint32_t sample_rate, int num_slots, gpio_num_t ws, gpio_num_t bclk,
+                                  gpio_num_t dout, gpio_num_t din, i2s_chan_handle_t *rx) {
     i2s_chan_handle_t tx_handle = NULL;
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
-    chan_cfg.dma_desc_num = 4;
-    chan_cfg.dma_frame_num = 256;
-    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle, NULL));
-
-    i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
-        .gpio_cfg = {
-            .mclk = I2S_GPIO_UNUSED,
-            .bclk = bclk,
-            .ws   = ws,
-            .dout = dout,
-            .din  = I2S_GPIO_UNUSED,
-            .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },
-        },
-    };
-    std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH;
-    ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle, &std_cfg));
+    // a block of 8 slots takes two DMA buffers
+    uint32_t frames_per_buffer = AUDIO_BLOCK_FRAMES;
+    while (frames_per_buffer * num_slots * sizeof(int16_t) > I2S_DMA_BUFFER_MAX) frames_per_buffer /= 2;
+    const uint32_t buffers_per_block = AUDIO_BLOCK_FRAMES / frames_per_buffer;
+    if (rx != NULL) {
+        // In full duplex the driver writes TX into the buffers that just played,
+        // so with two blocks of buffers a block goes out one block after it was
+        // read. An overrun then replays silence rather than the last block.
+        chan_cfg.dma_desc_num = 2 * buffers_per_block;
+        chan_cfg.auto_clear = true;
+    } else {
+        chan_cfg.dma_desc_num = 4 * buffers_per_block;
+    }
+    chan_cfg.dma_frame_num = frames_per_buffer;
+    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle, rx));
+
+#if SOC_I2S_SUPPORTS_TDM
+    if (num_slots > 2) {
+        // Philips framing, WS toggling at half the frame; codecs that want a
+        // one-bit frame sync take I2S_TDM_PCM_SHORT_SLOT_DEFAULT_CONFIG instead
+        i2s_tdm_config_t tdm_cfg = {
+            .clk_cfg = I2S_TDM_CLK_DEFAULT_CONFIG(sample_rate),
+            .slot_cfg = I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO,
+                                                            (i2s_tdm_slot_mask_t) ((1u << num_slots) - 1)),
+            .gpio_cfg = {
+                .mclk = I2S_GPIO_UNUSED,
+                .bclk = bclk,
+                .ws   = ws,
+                .dout = dout,
+                .din  = (rx != NULL) ? din : I2S_GPIO_UNUSED,
+                .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },
+            },
+        };
+        ESP_ERROR_CHECK(i2s_channel_init_tdm_mode(tx_handle, &tdm_cfg));
+        if (rx != NULL) ESP_ERROR_CHECK(i2s_channel_init_tdm_mode(*rx, &tdm_cfg));
+    } else
+#endif
+    {
+        i2s_std_config_t std_cfg = {
+            .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sample_rate),
+            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+            .gpio_cfg = {
+                .mclk = I2S_GPIO_UNUSED,
+                .bclk = bclk,
+                .ws   = ws,
+                .dout = dout,
+                .din  = (rx != NULL) ? din : I2S_GPIO_UNUSED,
+                .invert_flags = { .mclk_inv = false, .bclk_inv = false, .ws_inv = false },
+            },
+        };
+        std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_BOTH;
+        ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle, &std_cfg));
+        if (rx != NULL) ESP_ERROR_CHECK(i2s_channel_init_std_mode(*rx, &std_cfg));
+    }
+    if (rx != NULL) {
+        // both directions run off the controller's BCLK and WS, so they stay
+        // in step frame for frame
+        ESP_ERROR_CHECK(i2s_channel_enable(*rx));
+    }
     ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
     return tx_handle;
 }
 
+//  slots per frame for a patch's channels: stereo, or TDM where the chip has it.
+static int audio_slots(int num_channels) {
+#if SOC_I2S_SUPPORTS_TDM
+    if (num_channels > 4) return AUDIO_MAX_SLOTS;
+    if (num_channels > 2) return 4;
+#endif
+    return 2;
+}
+
 //  create a Heavy (HVCC) audio context for the given sample rate.
-static HeavyContextInterface* init_heavy(uint32_t sample_rate, int *out_channels) {
+static HeavyContextInterface* init_heavy(uint32_t sample_rate, int *in_channels, int *out_channels) {
     HeavyContextInterface *hv_ctx = hv_heavy_new((double) sample_rate);
     int ch = hv_getNumOutputChannels(hv_ctx);
     if (ch <= 0) ch = 1; // fallback to mono if patch declares none
     *out_channels = ch;
+    *in_channels = hv_getNumInputChannels(hv_ctx); // 0 without adc~
     return hv_ctx;
 }
 
-//  process audio in blocks and send to I2S.
-static void run_audio_loop(i2s_chan_handle_t tx, HeavyContextInterface *hv_ctx, int num_out_channels) {
-    const int frames_per_block = 256; // HVCC likes multiples of 8
-    float hv_out[frames_per_block * 2];
-    int16_t samples[frames_per_block * 2];
+// Controls are scheduled this far after their capture time, so that an event
+// always reaches the patch before its block is processed.
+#define CONTROL_LATENCY_FRAMES (2 * AUDIO_BLOCK_FRAMES)
+
+// Patches with adc~ get full-duplex I2S. Each pass of run_audio_loop() reads
+// the block the DMA has just captured, feeds it to the patch and writes the
+// output into the buffer that has just played. A sample therefore leaves
+// DOUT two blocks after it arrived on DIN: one block to be captured, and
+// one for the patch to process it (10.7 ms at 48 kHz). host/hvduplex.c checks
+// this against a model of the driver. Set AUDIO_INPUT to 0 to leave DIN free;
+// the patch then hears silence.
+#define AUDIO_INPUT 1
+
+// Output meters and a scope are taken in the conversion loop of
+// run_audio_loop(), where every output sample passes anyway, rather than in the
+// patch. They are published under a sequence lock, so front-panel LEDs or a web
+// UI can poll them from the other core without holding up the audio.
+#define AUDIO_METERS 1
+#define METER_WINDOW_MS 50
+#define SCOPE_POINTS 256
+#define SCOPE_DECIMATION 8 // a snapshot spans about 43 ms at 48 kHz
+#define METER_REPORT_MS 1000
+
+static HvMeter meter;
+
+//  read input from I2S (in full duplex), process audio in blocks and send to I2S.
+static void run_audio_loop(i2s_chan_handle_t tx, i2s_chan_handle_t rx, HeavyContextInterface *hv_ctx,
+                           int num_slots, int num_in_channels, int num_out_channels) {
+    const int frames_per_block = AUDIO_BLOCK_FRAMES;
+    // The blocks go on the heap: with 8 slots they would not fit the main task's
+    // stack. Without RX the inputs stay silent.
+    float *hv_out = (float *) calloc((size_t) (frames_per_block * num_out_channels), sizeof(float));
+    int16_t *samples = (int16_t *) calloc((size_t) (frames_per_block * num_slots), sizeof(int16_t));
+    float *hv_in = NULL;
+    if (num_in_channels > 0) hv_in = (float *) calloc((size_t) (frames_per_block * num_in_channels), sizeof(float));
+    configASSERT(hv_out != NULL && samples != NULL && (hv_in != NULL || num_in_channels == 0));
     while (1) {
-        int s = hv_processInline(hv_ctx, NULL, hv_out, frames_per_block);
+        if (rx != NULL) {
+            // the block just captured, read into the TX buffer, which is free until
+            // the output is converted into it
+            size_t read = 0;
+            if (i2s_channel_read(rx, samples, (size_t) (frames_per_block * num_slots) * sizeof(int16_t), &read,
+                                 portMAX_DELAY) != ESP_OK) {
+                vTaskDelay(1);
+                continue;
+            }
+            hAi_readS16(hv_in, (hv_uint32_t) num_in_channels, samples, (hv_uint32_t) num_slots, (hv_uint32_t) frames_per_block);
+        }
+        // i2s_channel_write() (i2s_channel_read() in full duplex) returns as the DMA
+        // hands over a buffer, so this time is paced by the sample clock and marks
+        // the start of the block processed next
+        hv_setSampleClock(hv_ctx, esp_timer_get_time());
+        int s = hv_processInline(hv_ctx, hv_in, hv_out, frames_per_block);
         if (s <= 0) { vTaskDelay(1); continue; }
-        for (int i = 0; i < s; ++i) {
-            float l = hv_out[i];
-            float r = (num_out_channels >= 2) ? hv_out[i + s] : l;
-            if (l > 1.0f) l = 1.0f; else if (l < -1.0f) l = -1.0f;
-            if (r > 1.0f) r = 1.0f; else if (r < -1.0f) r = -1.0f;
-            samples[2 * i]     = (int16_t)(l * 32767.0f);
-            samples[2 * i + 1] = (int16_t)(r * 32767.0f);
+        // one pass interleaves, clips, converts and meters; a mono patch plays on
+        // both slots of a stereo frame
+        HvMeterAccum accum[AUDIO_MAX_SLOTS] = { { 0 } };
+        hAi_writeS16(samples, (hv_uint32_t) num_slots, hv_out, (hv_uint32_t) num_out_channels, (hv_uint32_t) s,
+                     AUDIO_METERS ? accum : NULL);
+        if (AUDIO_METERS) {
+            hMe_addLevels(&meter, accum, (hv_uint32_t) s);
+            hMe_addScope(&meter, hv_out, (num_out_channels >= 2) ? (hv_uint32_t) s : 0, (hv_uint32_t) s);
         }
         size_t written = 0;
-        if (i2s_channel_write(tx, samples, (size_t)(s * 2 * sizeof(int16_t)), &written, portMAX_DELAY) != ESP_OK) {
+        if (i2s_channel_write(tx, samples, (size_t)(s * num_slots) * sizeof(int16_t), &written, portMAX_DELAY) != ESP_OK) {
             vTaskDelay(1);
         }
     }
 }
 
-typedef struct {
-    gpio_num_t pin;
-    const char *recv;
-    int invert;
-    hv_uint32_t hash;
-    int last_level;
-} ButtonMap;
+// Polls the meters as a front panel would, and reports clipping at most once
+// per METER_REPORT_MS.
+static void meters_task(void *arg) {
+    HvMeterLevel levels[AUDIO_MAX_SLOTS];
+    hv_uint32_t clips = 0;
+    TickType_t wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(METER_REPORT_MS));
+        if (hMe_readLevels(&meter, levels) == 0) continue;
+        hv_uint32_t c = 0;
+        float peak = 0.0f;
+        for (hv_uint32_t i = 0; i < meter.numChannels; ++i) {
+            c += levels[i].clips;
+            if (levels[i].peak > peak) peak = levels[i].peak;
+        }
+        if (c != clips) {
+            ESP_LOGW("meters", "%" PRIu32 " output samples clipped, peak %.1f dBFS", c - clips, 20.0f * log10f(peak));
+            clips = c;
+        }
+    }
+}
 
-typedef struct {
-    adc_channel_t ch;
-    const char *recv;
-    hv_uint32_t hash;
-} AdcMap;
+// Print objects of the patch only copy their message on the audio task;
+// prints_task formats them and calls this hook.
+static void print_hook(HeavyContextInterface *hv, const char *name, const char *str, const HvMessage *m) {
+    ESP_LOGI("pd", "%s: %s", name, str);
+}
+
+static void prints_task(void *arg) {
+    HeavyContextInterface *hv = (HeavyContextInterface *) arg;
+    hv_uint32_t dropped = 0;
+    while (1) {
+        hv_dispatchPrints(hv);
+        const hv_uint32_t d = hv_getDroppedPrintCount(hv);
+        if (d != dropped) {
+            ESP_LOGW("pd", "%" PRIu32 " print messages dropped, print queue full", d - dropped);
+            dropped = d;
+        }
+        hv_waitForPrints(hv, 1000);
+    }
+}
+
+// Buttons are quiet this long before a new change counts; a change itself is
+// reported at its first edge.
+#define BUTTON_DEBOUNCE_US 5000
+#define BUTTON_EDGES 64  // edge ring between the GPIO interrupt and buttons_task
+#define BUTTON_EVENTS 16 // debounced changes waiting for room in the input queue
+
+typedef struct ButtonCtx {
+    HeavyContextInterface *hv;
+    HvDebounce debounce;
+    TaskHandle_t task;
+    int num_events;
+    hv_uint32_t dropped;
+    HvEvent events[BUTTON_EVENTS];
+    HvMessage msgs[BUTTON_EVENTS]; // room for the one-element messages of the events
+} ButtonCtx;
+
+static ButtonCtx button_ctx;
+
+// Runs on every edge of a button pin: stamps it with the time and wakes buttons_task.
+static void button_isr(void *arg) {
+    const hv_uint32_t id = (hv_uint32_t) (uintptr_t) arg; // position in control_buttons
+    hDb_pushEdge(&button_ctx.debounce, id, (hv_uint32_t) gpio_get_level(control_buttons[id].pin), esp_timer_get_time());
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(button_ctx.task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// Called by hDb_process() for each debounced change of a button.
+static void on_button(void *user, hv_uint32_t id, hv_uint32_t level, hv_int64_t time_us) {
+    ButtonCtx *ctx = (ButtonCtx *) user;
+    const ControlButton *b = &control_buttons[id];
+    if (b->active_low) level = !level;
+    if (b->mode == CONTROL_BUTTON_BANG && level != 1) return; // PD-style bang on press only
+    if (ctx->num_events == BUTTON_EVENTS) {
+        ctx->dropped++;
+        return;
+    }
+    // the change is placed at the sample of its edge, not at the next block start
+    HvMessage *m = &ctx->msgs[ctx->num_events];
+    if (b->mode == CONTROL_BUTTON_BANG) msg_initWithBang(m, 0);
+    else msg_initWithFloat(m, 0, (float) level);
+    ctx->events[ctx->num_events++] = (HvEvent) {
+        0, b->index, m, hv_timeToSample(ctx->hv, time_us) + CONTROL_LATENCY_FRAMES
+    };
+}
+
+// Sleeps until a button interrupt or the end of a debounce period, then sends
+// the debounced changes to the patch in one hv_sendBatch() call.
+static void buttons_task(void *arg) {
+    ButtonCtx *ctx = (ButtonCtx *) arg;
+    hv_uint32_t dropped = 0;
+    while (1) {
+        const hv_int64_t now = esp_timer_get_time();
+        const hv_int64_t next = hDb_process(&ctx->debounce, now, on_button, ctx);
+        TickType_t wait = portMAX_DELAY;
+        if (ctx->num_events > 0) {
+            const int sent = hv_sendBatch(ctx->hv, ctx->events, ctx->num_events);
+            // changes the queue had no room for are sent again shortly, in order
+            for (int i = sent; i < ctx->num_events; ++i) {
+                ctx->msgs[i - sent] = ctx->msgs[i];
+                ctx->events[i - sent] = ctx->events[i];
+                ctx->events[i - sent].msg = &ctx->msgs[i - sent];
+            }
+            ctx->num_events -= sent;
+            if (ctx->num_events > 0) wait = pdMS_TO_TICKS(10);
+        }
+        if (next != HV_DEBOUNCE_IDLE) {
+            const TickType_t t = pdMS_TO_TICKS((next - now + 999) / 1000);
+            if (t < wait) wait = (t > 0) ? t : 1;
+        }
+        const hv_uint32_t d = ctx->dropped + hDb_getDroppedCount(&ctx->debounce);
+        if (d != dropped) {
+            ESP_LOGW("controls", "%" PRIu32 " button events dropped", d - dropped);
+            dropped = d;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+// Knobs are sampled continuously by the ADC DMA at its lowest rate. Each DMA
+// frame wakes controls_task, which averages the frame's samples per knob.
+#define KNOB_SAMPLE_RATE_HZ 20000
+#define KNOB_FRAME_BYTES 512     // 256 conversions, about 78 updates per second
+#define KNOB_HYSTERESIS 0.002f   // about 8 steps of 12 bits
+#define KNOB_DEADBAND 0.01f
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define KNOB_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define KNOB_GET_CHANNEL(p) ((p)->type1.channel)
+#define KNOB_GET_DATA(p) ((p)->type1.data)
+#else
+#define KNOB_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define KNOB_GET_CHANNEL(p) ((p)->type2.channel)
+#define KNOB_GET_DATA(p) ((p)->type2.data)
+#endif
 
 typedef struct {
     HeavyContextInterface *hv;
-    adc_oneshot_unit_handle_t adc;
-    AdcMap *adc_map;
-    int adc_count;
-    ButtonMap *btn_map;
-    int btn_count;
+    adc_continuous_handle_t adc;
+    TaskHandle_t task;
+    HvKnobFilter filter;
+    int8_t slot[16]; // position in control_knobs of each ADC channel, -1 if not mapped
 } ControlCtx;
 
+// Runs in the ADC interrupt when a DMA frame is complete.
+static bool knobs_isr(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(((ControlCtx *) user)->task, &woken);
+    return woken == pdTRUE;
+}
+
+static void init_knobs(ControlCtx *ctx) {
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = 4 * KNOB_FRAME_BYTES,
+        .conv_frame_size = KNOB_FRAME_BYTES,
+    };
+    ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_cfg, &ctx->adc));
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX] = { 0 };
+    for (int i = 0; i < (int)(sizeof(ctx->slot)/sizeof(ctx->slot[0])); ++i) ctx->slot[i] = -1;
+    for (int i = 0; i < CONTROL_NUM_KNOBS; ++i) {
+        pattern[i].atten = ADC_ATTEN_DB_11;
+        pattern[i].channel = control_knobs[i].ch & 0x7;
+        pattern[i].unit = ADC_UNIT_1;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        ctx->slot[control_knobs[i].ch] = (int8_t) i;
+    }
+    adc_continuous_config_t cfg = {
+        .pattern_num = CONTROL_NUM_KNOBS,
+        .adc_pattern = pattern,
+        .sample_freq_hz = KNOB_SAMPLE_RATE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = KNOB_OUTPUT_FORMAT,
+    };
+    ESP_ERROR_CHECK(adc_continuous_config(ctx->adc, &cfg));
+    hKf_init(&ctx->filter, CONTROL_NUM_KNOBS, (1u << SOC_ADC_DIGI_MAX_BITWIDTH) - 1,
+        KNOB_HYSTERESIS, KNOB_DEADBAND);
+    adc_continuous_evt_cbs_t cbs = { .on_conv_done = knobs_isr };
+    ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(ctx->adc, &cbs, ctx));
+}
+
+// Sleeps until the DMA completes a frame, filters it, and updates only the
+// knobs whose filtered value moved.
 static void controls_task(void *arg) {
     ControlCtx *ctx = (ControlCtx *) arg;
-    const TickType_t delay = pdMS_TO_TICKS(10);
-    // Read ADC a little slower than buttons (every 20ms)
-    const int adc_poll_div = 2; // 2 * 10ms = ~20ms
-    int adc_counter = 0;
+    uint8_t buf[KNOB_FRAME_BYTES];
     while (1) {
-        for (int i = 0; i < ctx->btn_count; ++i) {
-            int lvl = gpio_get_level(ctx->btn_map[i].pin);
-            if (ctx->btn_map[i].invert) lvl = !lvl;
-            if (lvl != ctx->btn_map[i].last_level) {
-                ctx->btn_map[i].last_level = lvl;
-                // Send a PD-style bang on button press (lvl == 1)
-                if (lvl == 1) {
-                    hv_sendBangToReceiver(ctx->hv, ctx->btn_map[i].hash);
-                }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t len = 0;
+        while (adc_continuous_read(ctx->adc, buf, sizeof(buf), &len, 0) == ESP_OK) {
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *p = (const adc_digi_output_data_t *) &buf[i];
+                const int slot = ctx->slot[KNOB_GET_CHANNEL(p) & 0xF];
+                if (slot >= 0) hKf_add(&ctx->filter, (hv_uint32_t) slot, KNOB_GET_DATA(p));
+            }
+        }
+        for (int i = 0; i < CONTROL_NUM_KNOBS; ++i) {
+            float x;
+            if (hKf_update(&ctx->filter, (hv_uint32_t) i, &x)) {
+                // Knobs are parameters: a lock-free store the patch picks up next block,
+                // already scaled to the parameter's range
+                hv_setParameterValue(ctx->hv, control_knobs[i].param, control_knob_value(&control_knobs[i], x));
             }
         }
-        adc_counter++;
-        if ((adc_counter % adc_poll_div) == 0) {
-            for (int i = 0; i < ctx->adc_count; ++i) {
-                int raw = 0;
-                if (adc_oneshot_read(ctx->adc, ctx->adc_map[i].ch, &raw) == ESP_OK) {
-                    float v = (float) raw / 4095.0f;
-                    hv_sendFloatToReceiver(ctx->hv, ctx->adc_map[i].hash, v);
+    }
+}
+
+// Encoders are counted by the PCNT peripheral, so turning one costs no CPU.
+// encoders_task polls the counts and applies the acceleration.
+#define ENCODER_POLL_MS 10
+#define ENCODER_THRESHOLD 5.0f // detents per second at which acceleration starts
+#define ENCODER_MAX_GAIN 8.0f
+#define ENCODER_LIMIT 10000    // hardware count range, the driver accumulates past it
+#define ENCODER_SLOTS (CONTROL_NUM_ENCODERS > 0 ? CONTROL_NUM_ENCODERS : 1)
+
+typedef struct {
+    HeavyContextInterface *hv;
+    pcnt_unit_handle_t units[ENCODER_SLOTS];
+    HvEncoder state[ENCODER_SLOTS];
+    float position[ENCODER_SLOTS]; // of absolute encoders, in [0, 1]
+    float pending[ENCODER_SLOTS];  // detents of delta encoders the input queue had no room for
+} EncoderCtx;
+
+static pcnt_unit_handle_t init_encoder(const ControlEncoder *e) {
+    pcnt_unit_config_t unit_cfg = {
+        .low_limit = -ENCODER_LIMIT,
+        .high_limit = ENCODER_LIMIT,
+        .flags.accum_count = 1,
+    };
+    pcnt_unit_handle_t unit = NULL;
+    ESP_ERROR_CHECK(pcnt_new_unit(&unit_cfg, &unit));
+    pcnt_glitch_filter_config_t filter_cfg = { .max_glitch_ns = 1000 };
+    ESP_ERROR_CHECK(pcnt_unit_set_glitch_filter(unit, &filter_cfg));
+    // full quadrature decoding: each channel counts the edges of one pin, in the
+    // direction given by the level of the other one
+    pcnt_chan_config_t a_cfg = { .edge_gpio_num = e->pin_a, .level_gpio_num = e->pin_b };
+    pcnt_chan_config_t b_cfg = { .edge_gpio_num = e->pin_b, .level_gpio_num = e->pin_a };
+    pcnt_channel_handle_t a = NULL, b = NULL;
+    ESP_ERROR_CHECK(pcnt_new_channel(unit, &a_cfg, &a));
+    ESP_ERROR_CHECK(pcnt_new_channel(unit, &b_cfg, &b));
+    ESP_ERROR_CHECK(pcnt_channel_set_edge_action(a, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE));
+    ESP_ERROR_CHECK(pcnt_channel_set_level_action(a, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE));
+    ESP_ERROR_CHECK(pcnt_channel_set_edge_action(b, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE));
+    ESP_ERROR_CHECK(pcnt_channel_set_level_action(b, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE));
+    // the driver adds the count to its total each time it reaches a limit
+    ESP_ERROR_CHECK(pcnt_unit_add_watch_point(unit, ENCODER_LIMIT));
+    ESP_ERROR_CHECK(pcnt_unit_add_watch_point(unit, -ENCODER_LIMIT));
+    gpio_pullup_en(e->pin_a);
+    gpio_pullup_en(e->pin_b);
+    ESP_ERROR_CHECK(pcnt_unit_enable(unit));
+    ESP_ERROR_CHECK(pcnt_unit_clear_count(unit));
+    ESP_ERROR_CHECK(pcnt_unit_start(unit));
+    return unit;
+}
+
+static void encoders_task(void *arg) {
+    EncoderCtx *ctx = (EncoderCtx *) arg;
+    HvEvent events[ENCODER_SLOTS];
+    HvMessage msgs[ENCODER_SLOTS];
+    int which[ENCODER_SLOTS];
+    TickType_t wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(ENCODER_POLL_MS));
+        const hv_int64_t now = esp_timer_get_time();
+        const hv_uint64_t sample = hv_timeToSample(ctx->hv, now) + CONTROL_LATENCY_FRAMES;
+        int n = 0;
+        for (int i = 0; i < CONTROL_NUM_ENCODERS; ++i) {
+            const ControlEncoder *e = &control_encoders[i];
+            int count = 0;
+            if (pcnt_unit_get_count(ctx->units[i], &count) != ESP_OK) continue;
+            const float detents = hEn_update(&ctx->state[i], count, now);
+            if (e->mode == CONTROL_ENCODER_ABSOLUTE) {
+                if (detents == 0.0f) continue;
+                float x = ctx->position[i] + detents * e->step;
+                x = (x < 0.0f) ? 0.0f : (x > 1.0f) ? 1.0f : x;
+                ctx->position[i] = x;
+                hv_setParameterValue(ctx->hv, e->param, control_encoder_value(e, x));
+            } else {
+                ctx->pending[i] += detents;
+                if (ctx->pending[i] == 0.0f) continue;
+                msg_initWithFloat(&msgs[n], 0, ctx->pending[i]);
+                which[n] = i;
+                events[n] = (HvEvent) { 0, e->index, &msgs[n], sample };
+                n++;
+            }
+        }
+        if (n > 0) {
+            // deltas the queue had no room for are added to the next ones
+            const int sent = hv_sendBatch(ctx->hv, events, n);
+            for (int j = 0; j < sent; ++j) ctx->pending[which[j]] = 0.0f;
+        }
+    }
+}
+
+// Streams that can't be held back, MIDI and the control link, retry a full
+// input queue a few ticks, then drop the rest.
+#define SEND_TRIES 10
+
+// Returns how many of the events the input queue had no room for.
+static int send_events(HeavyContextInterface *hv, const HvEvent *events, int n) {
+    int sent = 0;
+    for (int tries = 0; sent < n && tries < SEND_TRIES; ++tries) {
+        if (tries > 0) vTaskDelay(1);
+        sent += hv_sendBatch(hv, events + sent, n - sent);
+    }
+    return n - sent;
+}
+
+// MIDI arrives on a UART RX pin. The UART driver's interrupt moves the bytes
+// into its ring buffer and wakes midi_task, which parses each read in place and
+// sends the messages in one hv_sendBatch() call, each at the sample its last
+// byte arrived at.
+#define MIDI_BAUD 31250
+#define MIDI_BYTE_US 320     // 10 bits at 31250 baud
+#define MIDI_RX_BUFFER 1024  // driver ring buffer, about 0.3 s of bytes
+#define MIDI_READ_BYTES 128
+#define MIDI_EVENTS 64
+
+typedef struct {
+    HeavyContextInterface *hv;
+    QueueHandle_t uart_events;
+    HvMidiParser parser;
+} MidiCtx;
+
+static void init_midi(MidiCtx *ctx) {
+    uart_config_t cfg = {
+        .baud_rate = MIDI_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    ESP_ERROR_CHECK(uart_driver_install(CONTROL_MIDI_UART, MIDI_RX_BUFFER, 0, 16, &ctx->uart_events, 0));
+    ESP_ERROR_CHECK(uart_param_config(CONTROL_MIDI_UART, &cfg));
+    ESP_ERROR_CHECK(uart_set_pin(CONTROL_MIDI_UART, UART_PIN_NO_CHANGE, CONTROL_MIDI_RX_GPIO,
+        UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+    // wake on each complete message, or after 3 byte times of silence for shorter ones
+    ESP_ERROR_CHECK(uart_set_rx_full_threshold(CONTROL_MIDI_UART, 3));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(CONTROL_MIDI_UART, 3));
+    hMi_init(&ctx->parser);
+}
+
+static void midi_task(void *arg) {
+    MidiCtx *ctx = (MidiCtx *) arg;
+    hv_uint8_t bytes[MIDI_READ_BYTES];
+    HvMidiMessage parsed[MIDI_EVENTS];
+    HvMidiMessageStorage msgs[MIDI_EVENTS];
+    HvEvent events[MIDI_EVENTS];
+    hv_uint32_t dropped = 0, reported = 0;
+    uart_event_t event;
+    while (1) {
+        if (xQueueReceive(ctx->uart_events, &event, portMAX_DELAY) != pdTRUE) continue;
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            // bytes were lost, so start again at the next status byte
+            uart_flush_input(CONTROL_MIDI_UART);
+            xQueueReset(ctx->uart_events);
+            hMi_reset(&ctx->parser);
+            ESP_LOGW("midi", "receive overflow");
+            continue;
+        }
+        if (event.type != UART_DATA) continue;
+        // the buffered bytes arrived one byte time apart, the last one just now
+        const hv_int64_t now = esp_timer_get_time();
+        size_t buffered = 0;
+        uart_get_buffered_data_len(CONTROL_MIDI_UART, &buffered);
+        for (size_t offset = 0; offset < buffered; ) {
+            const size_t want = (buffered - offset < MIDI_READ_BYTES) ? buffered - offset : MIDI_READ_BYTES;
+            const int len = uart_read_bytes(CONTROL_MIDI_UART, bytes, want, 0);
+            if (len <= 0) break;
+            for (hv_uint32_t used = 0; used < (hv_uint32_t) len; ) {
+                const hv_uint32_t start = used;
+                hv_uint32_t n = 0;
+                used += hMi_parse(&ctx->parser, bytes + start, (hv_uint32_t) len - start, parsed, MIDI_EVENTS, &n);
+                for (hv_uint32_t i = 0; i < n; ++i) {
+                    const size_t after = buffered - 1 - (offset + start + parsed[i].end);
+                    const hv_int64_t t = now - (hv_int64_t) after * MIDI_BYTE_US;
+                    events[i] = (HvEvent) {
+                        hMi_toMessage(&parsed[i], &msgs[i]), HV_RECEIVER_INDEX_NONE, &msgs[i].msg,
+                        hv_timeToSample(ctx->hv, t) + CONTROL_LATENCY_FRAMES
+                    };
                 }
+                if (n > 0) dropped += (hv_uint32_t) send_events(ctx->hv, events, (int) n);
+            }
+            offset += (size_t) len;
+        }
+        if (dropped != reported) {
+            ESP_LOGW("midi", "%" PRIu32 " messages dropped", dropped - reported);
+            reported = dropped;
+        }
+    }
+}
+
+// The control link streams receiver and parameter updates from a host in
+// HvControlLink frames (see host/hvlink.c). Like MIDI, the UART driver's
+// interrupt fills its ring buffer and link_task parses each read in place.
+// Parameters go straight into the parameter bank; receiver updates of a frame
+// are sent in one hv_sendBatch() call.
+#define LINK_RX_BUFFER 4096 // driver ring buffer, about 45 ms at 921600 baud
+#define LINK_READ_BYTES 256
+
+typedef struct {
+    HeavyContextInterface *hv;
+    QueueHandle_t uart_events;
+    HvControlLink link;
+} LinkCtx;
+
+static void init_link(LinkCtx *ctx) {
+    uart_config_t cfg = {
+        .baud_rate = CONTROL_LINK_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    ESP_ERROR_CHECK(uart_driver_install(CONTROL_LINK_UART, LINK_RX_BUFFER, 0, 16, &ctx->uart_events, 0));
+    ESP_ERROR_CHECK(uart_param_config(CONTROL_LINK_UART, &cfg));
+    ESP_ERROR_CHECK(uart_set_pin(CONTROL_LINK_UART, UART_PIN_NO_CHANGE, CONTROL_LINK_RX_GPIO,
+        UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+    // frames are hundreds of bytes, so let the FIFO fill before waking the task
+    ESP_ERROR_CHECK(uart_set_rx_full_threshold(CONTROL_LINK_UART, 64));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(CONTROL_LINK_UART, 4));
+    hCl_init(&ctx->link);
+}
+
+// Applies the frame the parser completed and returns how many of its receiver
+// updates were dropped.
+static int link_apply(LinkCtx *ctx, hv_uint32_t numUpdates, hv_uint64_t sample) {
+    HvEvent events[HV_CONTROL_LINK_MAX_UPDATES];
+    HvMessage msgs[HV_CONTROL_LINK_MAX_UPDATES];
+    int n = 0, dropped = 0;
+    for (hv_uint32_t i = 0; i < numUpdates; ++i) {
+        const HvControlUpdate u = hCl_getUpdate(&ctx->link, i);
+        if (u.index & HV_CONTROL_LINK_PARAMETER) {
+            if (!hv_setParameterValue(ctx->hv, u.index & ~HV_CONTROL_LINK_PARAMETER, u.value)) dropped++;
+        } else if (u.index < CONTROL_NUM_RECEIVERS) {
+            msg_initWithFloat(&msgs[n], 0, u.value);
+            events[n] = (HvEvent) { 0, u.index, &msgs[n], sample };
+            n++;
+        } else {
+            dropped++;
+        }
+    }
+    return dropped + ((n > 0) ? send_events(ctx->hv, events, n) : 0);
+}
+
+static void link_task(void *arg) {
+    LinkCtx *ctx = (LinkCtx *) arg;
+    hv_uint8_t bytes[LINK_READ_BYTES];
+    hv_uint32_t dropped = 0, reported = 0, bad = 0, lost = 0;
+    uart_event_t event;
+    while (1) {
+        if (xQueueReceive(ctx->uart_events, &event, portMAX_DELAY) != pdTRUE) continue;
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            uart_flush_input(CONTROL_LINK_UART);
+            xQueueReset(ctx->uart_events);
+            hCl_reset(&ctx->link);
+            ESP_LOGW("link", "receive overflow");
+            continue;
+        }
+        if (event.type != UART_DATA) continue;
+        const hv_uint64_t sample = hv_timeToSample(ctx->hv, esp_timer_get_time()) + CONTROL_LATENCY_FRAMES;
+        int len;
+        while ((len = uart_read_bytes(CONTROL_LINK_UART, bytes, LINK_READ_BYTES, 0)) > 0) {
+            for (hv_uint32_t used = 0; used < (hv_uint32_t) len; ) {
+                hv_uint32_t n = 0;
+                used += hCl_parse(&ctx->link, bytes + used, (hv_uint32_t) len - used, &n);
+                if (n > 0) dropped += (hv_uint32_t) link_apply(ctx, n, sample);
             }
         }
-        vTaskDelay(delay);
+        if (dropped != reported || hCl_getBadFrameCount(&ctx->link) != bad || hCl_getLostFrameCount(&ctx->link) != lost) {
+            ESP_LOGW("link", "%" PRIu32 " updates dropped, %" PRIu32 " bad and %" PRIu32 " lost frames",
+                dropped - reported, hCl_getBadFrameCount(&ctx->link) - bad, hCl_getLostFrameCount(&ctx->link) - lost);
+            reported = dropped;
+            bad = hCl_getBadFrameCount(&ctx->link);
+            lost = hCl_getLostFrameCount(&ctx->link);
+        }
+    }
+}
+
+// OSC arrives over UDP on WiFi, with the network set in menuconfig (HVCC OSC
+// input). osc_task parses each datagram in place in its receive buffer and
+// sends the messages of a packet in one hv_sendBatch() call. Once SNTP has set
+// the clock, bundles are placed at the sample of their timetag; messages
+// outside bundles are placed at the sample they arrived at. Only built when the
+// board maps OSC, since WiFi takes a few hundred kilobytes of flash.
+#if CONTROL_OSC
+#define OSC_PACKET_BYTES 1536 // an Ethernet MTU, OSC over UDP isn't fragmented
+#define OSC_EVENTS 32
+#define OSC_CLOCK_SET 1600000000     // Unix time the clock is past once SNTP has set it
+#define OSC_MAX_OFFSET_US 10000000LL // timetags further from now are placed at arrival
+
+typedef struct {
+    HeavyContextInterface *hv;
+    hv_int64_t arrival;      // esp_timer time of the packet being parsed
+    hv_int64_t arrival_wall; // wall clock time of it, 0 while the clock isn't set
+    int num_events;
+    hv_uint32_t dropped;
+    HvEvent events[OSC_EVENTS];
+    HvOscMessageStorage msgs[OSC_EVENTS];
+} OscCtx;
+
+static void on_wifi_disconnected(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    esp_wifi_connect();
+}
+
+static void init_wifi(void) {
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(err);
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_create_default_wifi_sta();
+    wifi_init_config_t init = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&init));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, on_wifi_disconnected, NULL));
+    wifi_config_t cfg = {
+        .sta = {
+            .ssid = CONFIG_HV_OSC_WIFI_SSID,
+            .password = CONFIG_HV_OSC_WIFI_PASSWORD,
+        },
+    };
+    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &cfg));
+    ESP_ERROR_CHECK(esp_wifi_start());
+    // power save holds packets for up to a beacon interval
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_NONE));
+    ESP_ERROR_CHECK(esp_wifi_connect());
+    esp_sntp_config_t sntp = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_HV_OSC_SNTP_SERVER);
+    ESP_ERROR_CHECK(esp_netif_sntp_init(&sntp));
+}
+
+static hv_uint64_t osc_sample(OscCtx *ctx, hv_uint64_t timetag) {
+    if (timetag != HV_OSC_IMMEDIATELY && ctx->arrival_wall != 0) {
+        const hv_int64_t offset = hOs_timetagToUs(timetag) - ctx->arrival_wall;
+        if (offset > -OSC_MAX_OFFSET_US && offset < OSC_MAX_OFFSET_US) {
+            return hv_timeToSample(ctx->hv, ctx->arrival + offset);
+        }
+    }
+    return hv_timeToSample(ctx->hv, ctx->arrival) + CONTROL_LATENCY_FRAMES;
+}
+
+// Called by hOs_parse() for each message of a packet.
+static void on_osc(void *user, const HvOscMessage *m) {
+    OscCtx *ctx = (OscCtx *) user;
+    const ControlOscAddress *a = control_osc_find(m->address);
+    if (a == NULL || !hOs_toMessage(m, &ctx->msgs[ctx->num_events])) {
+        ctx->dropped++;
+        return;
+    }
+    HvEvent *e = &ctx->events[ctx->num_events];
+    *e = (HvEvent) { 0, a->index, &ctx->msgs[ctx->num_events].msg, osc_sample(ctx, m->timetag) };
+    if (++ctx->num_events == OSC_EVENTS) {
+        ctx->dropped += (hv_uint32_t) send_events(ctx->hv, ctx->events, ctx->num_events);
+        ctx->num_events = 0;
+    }
+}
+
+static void osc_task(void *arg) {
+    OscCtx *ctx = (OscCtx *) arg;
+    static hv_uint8_t packet[OSC_PACKET_BYTES];
+    const int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(CONTROL_OSC_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (sock < 0 || bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        ESP_LOGE("osc", "can't listen on port %d", CONTROL_OSC_PORT);
+        vTaskDelete(NULL);
+    }
+    hv_uint32_t malformed = 0, reported = 0;
+    while (1) {
+        const int n = recv(sock, packet, sizeof(packet), 0);
+        if (n <= 0) continue;
+        ctx->arrival = esp_timer_get_time();
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        ctx->arrival_wall = (tv.tv_sec > OSC_CLOCK_SET) ? (hv_int64_t) tv.tv_sec * 1000000 + tv.tv_usec : 0;
+        if (!hOs_parse(packet, (hv_uint32_t) n, on_osc, ctx)) malformed++;
+        if (ctx->num_events > 0) {
+            ctx->dropped += (hv_uint32_t) send_events(ctx->hv, ctx->events, ctx->num_events);
+            ctx->num_events = 0;
+        }
+        if (ctx->dropped + malformed != reported) {
+            ESP_LOGW("osc", "%" PRIu32 " messages dropped or malformed", ctx->dropped + malformed - reported);
+            reported = ctx->dropped + malformed;
+        }
     }
 }
+#endif // CONTROL_OSC
 
 void app_main(void)
 {
@@ -141,60 +818,104 @@ void app_main(void)
     const gpio_num_t I2S_WS   = GPIO_NUM_26;  // LRCK/WS
     const gpio_num_t I2S_BCLK = GPIO_NUM_27;  // BCLK
     const gpio_num_t I2S_DOUT = GPIO_NUM_25;  // DATA OUT
+    const gpio_num_t I2S_DIN  = GPIO_NUM_35;  // DATA IN (input-only pin), used if the patch has adc~
     const uint32_t sample_rate = 48000;       // 48 kHz
 
-    i2s_chan_handle_t tx = init_i2s_tx(sample_rate, I2S_WS, I2S_BCLK, I2S_DOUT);
+    int num_in_channels = 0;
     int num_out_channels = 0;
-    HeavyContextInterface *hv_ctx = init_heavy(sample_rate, &num_out_channels);
+    HeavyContextInterface *hv_ctx = init_heavy(sample_rate, &num_in_channels, &num_out_channels);
+    hv_setPrintHook(hv_ctx, print_hook);
+    hv_setPrintQueueSize(hv_ctx, 1);
+    xTaskCreate(prints_task, "hv_prints", 3072, hv_ctx, 1, NULL);
 
     // Map hardware controls to PD receivers (like pd2dsy-style mapping).
-    // Buttons: GPIO32 as input with pull-up, send bang on press to PD receiver.
-    static ButtonMap buttons[] = {
-        { GPIO_NUM_32, "button1", 1, 0, -1 },
-    };
-    for (int i = 0; i < (int)(sizeof(buttons)/sizeof(buttons[0])); ++i) {
-        buttons[i].hash = hv_stringToHash(buttons[i].recv);
+    // Buttons, knobs, encoders, MIDI, the control link and OSC come from control_map.h, generated from the board file.
+    ButtonCtx *bctx = &button_ctx;
+    bctx->hv = hv_ctx;
+    hDb_init(&bctx->debounce, CONTROL_NUM_BUTTONS, BUTTON_EDGES, BUTTON_DEBOUNCE_US);
+    for (int i = 0; i < CONTROL_NUM_BUTTONS; ++i) {
         gpio_config_t io = {
-            .pin_bit_mask = (1ULL << buttons[i].pin),
+            .pin_bit_mask = (1ULL << control_buttons[i].pin),
             .mode = GPIO_MODE_INPUT,
-            .pull_up_en = 1,
-            .pull_down_en = 0,
-            .intr_type = GPIO_INTR_DISABLE,
+            .pull_up_en = control_buttons[i].active_low,
+            .pull_down_en = !control_buttons[i].active_low,
+            .intr_type = GPIO_INTR_ANYEDGE,
         };
         gpio_config(&io);
-        buttons[i].last_level = -1;
+        // level buttons start the patch from the level they are at
+        const hv_uint32_t level = (hv_uint32_t) gpio_get_level(control_buttons[i].pin);
+        hDb_setLevel(&bctx->debounce, i, level);
+        if (control_buttons[i].mode == CONTROL_BUTTON_LEVEL) on_button(bctx, i, level, esp_timer_get_time());
+    }
+    // the task has to exist before the first interrupt notifies it
+    xTaskCreate(buttons_task, "buttons", 3072, bctx, 5, &bctx->task);
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    for (int i = 0; i < CONTROL_NUM_BUTTONS; ++i) {
+        ESP_ERROR_CHECK(gpio_isr_handler_add(control_buttons[i].pin, button_isr, (void *) (uintptr_t) i));
     }
 
-    // ADC (knobs): ADC1_CH5 (GPIO33) sends 0..1 float to PD receiver.
-    static AdcMap knobs[] = {
-        { ADC_CHANNEL_5, "knob1", 0 },
-    };
-    for (int i = 0; i < (int)(sizeof(knobs)/sizeof(knobs[0])); ++i) {
-        knobs[i].hash = hv_stringToHash(knobs[i].recv);
+    static ControlCtx cctx;
+    cctx.hv = hv_ctx;
+    if (CONTROL_NUM_KNOBS > 0) {
+        init_knobs(&cctx);
+        // the task has to exist before the first frame notifies it
+        xTaskCreate(controls_task, "controls", 4096, &cctx, 5, &cctx.task);
+        ESP_ERROR_CHECK(adc_continuous_start(cctx.adc));
     }
 
-    adc_oneshot_unit_handle_t adc_unit;
-    adc_oneshot_unit_init_cfg_t unit_cfg = {
-        .unit_id = ADC_UNIT_1,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&unit_cfg, &adc_unit));
-    for (int i = 0; i < (int)(sizeof(knobs)/sizeof(knobs[0])); ++i) {
-        adc_oneshot_chan_cfg_t chan_cfg = {
-            .bitwidth = ADC_BITWIDTH_DEFAULT,
-            .atten = ADC_ATTEN_DB_11,
-        };
-        ESP_ERROR_CHECK(adc_oneshot_config_channel(adc_unit, knobs[i].ch, &chan_cfg));
+    static EncoderCtx ectx;
+    ectx.hv = hv_ctx;
+    if (CONTROL_NUM_ENCODERS > 0) {
+        for (int i = 0; i < CONTROL_NUM_ENCODERS; ++i) {
+            const ControlEncoder *e = &control_encoders[i];
+            ectx.units[i] = init_encoder(e);
+            hEn_init(&ectx.state[i], 0, esp_timer_get_time(), e->counts_per_detent,
+                ENCODER_THRESHOLD, e->acceleration, ENCODER_MAX_GAIN);
+            ectx.position[i] = e->start;
+        }
+        xTaskCreate(encoders_task, "encoders", 3072, &ectx, 5, NULL);
     }
 
-    ControlCtx cctx = {
-        .hv = hv_ctx,
-        .adc = adc_unit,
-        .adc_map = knobs,
-        .adc_count = (int)(sizeof(knobs)/sizeof(knobs[0])),
-        .btn_map = buttons,
-        .btn_count = (int)(sizeof(buttons)/sizeof(buttons[0])),
-    };
-    xTaskCreate(controls_task, "controls", 4096, &cctx, 5, NULL);
+    static MidiCtx mctx;
+    mctx.hv = hv_ctx;
+    if (CONTROL_MIDI) {
+        init_midi(&mctx);
+        xTaskCreate(midi_task, "midi", 4096, &mctx, 5, NULL);
+    }
+
+    static LinkCtx lctx;
+    lctx.hv = hv_ctx;
+    if (CONTROL_LINK) {
+        init_link(&lctx);
+        xTaskCreate(link_task, "link", 4096, &lctx, 5, NULL);
+    }
+
+#if CONTROL_OSC
+    static OscCtx octx;
+    octx.hv = hv_ctx;
+    init_wifi();
+    xTaskCreate(osc_task, "osc", 6144, &octx, 5, NULL);
+#endif
+
+    // On ESP32 the ADC DMA runs on I2S0, so the audio channel takes whichever
+    // controller is still free after the knobs.
+    const bool duplex = AUDIO_INPUT && num_in_channels > 0;
+    const int num_slots = audio_slots(duplex && num_in_channels > num_out_channels ? num_in_channels : num_out_channels);
+    if (num_out_channels > num_slots) {
+        ESP_LOGW("audio", "the patch has %d outputs, the first %d play", num_out_channels, num_slots);
+    }
+    if (duplex && num_in_channels > num_slots) {
+        ESP_LOGW("audio", "the patch has %d inputs, the first %d are read", num_in_channels, num_slots);
+    }
+    if (AUDIO_METERS) {
+        // a meter per slot that plays the patch
+        const int num_meters = (num_out_channels == 1 || num_out_channels > num_slots) ? num_slots : num_out_channels;
+        hMe_init(&meter, (hv_uint32_t) num_meters, sample_rate * METER_WINDOW_MS / 1000, SCOPE_POINTS, SCOPE_DECIMATION);
+        // the audio loop runs on this core, so the readers go to the other one
+        xTaskCreatePinnedToCore(meters_task, "meters", 3072, NULL, 2, NULL, portNUM_PROCESSORS - 1);
+    }
 
-    run_audio_loop(tx, hv_ctx, num_out_channels);
+    i2s_chan_handle_t rx = NULL;
+    i2s_chan_handle_t tx = init_i2s(sample_rate, num_slots, I2S_WS, I2S_BCLK, I2S_DOUT, I2S_DIN, duplex ? &rx : NULL);
+    run_audio_loop(tx, rx, hv_ctx, num_slots, num_in_channels, num_out_channels);
 }